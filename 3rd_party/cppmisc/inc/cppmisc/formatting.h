@@ -2,8 +2,15 @@
 
 #include <ostream>
 #include <sstream>
+#include <string>
+#include <string.h>
+#include <stdint.h>
 
 
+/*
+ * stream based formatting
+ */
+
 inline void __format(std::ostream& s)
 {
 }
@@ -16,9 +23,238 @@ static void __format(std::ostream& s, Arg const& arg, Args const& ... args)
 }
 
 template <typename ... Args>
-static std::string format(Args const& ... args)
+static std::string format_stream(Args const& ... args)
 {
     std::stringstream s;
     __format(s, args...);
     return s.str();
 }
+
+
+/*
+ * allocation free formatting
+ *
+ * Arguments are appended to a caller provided buffer; text that does not
+ * fit is cut off. Integers are converted digit-pairwise, floating point
+ * values are printed with Grisu2 (src/formatting.cpp) in the shortest form
+ * that reads back to the same value. Types without a dedicated overload fall back to their
+ * operator<< through a temporary stream, which does allocate.
+ */
+
+class FormatBuffer
+{
+private:
+    char*   _buf;
+    int     _size;
+    int     _len;
+
+public:
+    FormatBuffer(char* buf, int size) : _buf(buf), _size(size), _len(0) {}
+
+    inline void append(char const* s, int len)
+    {
+        int n = len < _size - _len ? len : _size - _len;
+        memcpy(_buf + _len, s, n);
+        _len += n;
+    }
+
+    inline void append(char c)
+    {
+        if (_len < _size)
+            _buf[_len ++] = c;
+    }
+
+    inline char const* data() const { return _buf; }
+    inline int size() const { return _len; }
+    inline int capacity() const { return _size; }
+    inline bool full() const { return _len == _size; }
+    inline void clear() { _len = 0; }
+
+    // a cut off message still has to end with a newline
+    inline void end_line()
+    {
+        if (full())
+            _buf[_len - 1] = '\n';
+    }
+};
+
+/*
+ * writes decimal digits of v to the end of buf, returns the number of chars
+ */
+inline int __format_uint(uint64_t v, char (&buf)[24])
+{
+    static const char digits[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    char* p = buf + sizeof(buf);
+
+    while (v >= 100)
+    {
+        int i = int(v % 100) * 2;
+        v /= 100;
+        *-- p = digits[i + 1];
+        *-- p = digits[i];
+    }
+
+    if (v >= 10)
+    {
+        int i = int(v) * 2;
+        *-- p = digits[i + 1];
+        *-- p = digits[i];
+    }
+    else
+    {
+        *-- p = char('0' + v);
+    }
+
+    return int(buf + sizeof(buf) - p);
+}
+
+inline void __format_arg(FormatBuffer& b, unsigned long long v)
+{
+    char buf[24];
+    int n = __format_uint(v, buf);
+    b.append(buf + sizeof(buf) - n, n);
+}
+
+inline void __format_arg(FormatBuffer& b, long long v)
+{
+    if (v < 0)
+    {
+        b.append('-');
+        __format_arg(b, 0ull - (unsigned long long)v);
+    }
+    else
+    {
+        __format_arg(b, (unsigned long long)v);
+    }
+}
+
+inline void __format_arg(FormatBuffer& b, unsigned long v) { __format_arg(b, (unsigned long long)v); }
+inline void __format_arg(FormatBuffer& b, long v) { __format_arg(b, (long long)v); }
+inline void __format_arg(FormatBuffer& b, unsigned int v) { __format_arg(b, (unsigned long long)v); }
+inline void __format_arg(FormatBuffer& b, int v) { __format_arg(b, (long long)v); }
+inline void __format_arg(FormatBuffer& b, unsigned short v) { __format_arg(b, (unsigned long long)v); }
+inline void __format_arg(FormatBuffer& b, short v) { __format_arg(b, (long long)v); }
+
+// streams print bool as a number and the char types as characters
+inline void __format_arg(FormatBuffer& b, bool v) { b.append(v ? '1' : '0'); }
+inline void __format_arg(FormatBuffer& b, char v) { b.append(v); }
+inline void __format_arg(FormatBuffer& b, signed char v) { b.append(char(v)); }
+inline void __format_arg(FormatBuffer& b, unsigned char v) { b.append(char(v)); }
+
+/*
+ * shortest decimal representation that reads back to the same value, laid
+ * out like %g; returns the length, buf must hold at least 32 chars
+ */
+int format_double(double v, char* buf);
+int format_float(float v, char* buf);
+
+inline void __format_arg(FormatBuffer& b, double v)
+{
+    char buf[32];
+    int n = format_double(v, buf);
+    b.append(buf, n);
+}
+
+inline void __format_arg(FormatBuffer& b, float v)
+{
+    char buf[32];
+    int n = format_float(v, buf);
+    b.append(buf, n);
+}
+
+inline void __format_arg(FormatBuffer& b, char const* s)
+{
+    if (s)
+        b.append(s, int(strlen(s)));
+}
+
+inline void __format_arg(FormatBuffer& b, char* s)
+{
+    __format_arg(b, static_cast<char const*>(s));
+}
+
+inline void __format_arg(FormatBuffer& b, std::string const& s)
+{
+    b.append(s.data(), int(s.size()));
+}
+
+template <typename T>
+inline void __format_arg(FormatBuffer& b, T const& v)
+{
+    std::ostringstream s;
+    s << v;
+    auto const& str = s.str();
+    b.append(str.data(), int(str.size()));
+}
+
+inline void __format_to(FormatBuffer& b)
+{
+}
+
+template <typename Arg, typename ... Args>
+inline void __format_to(FormatBuffer& b, Arg const& arg, Args const& ... args)
+{
+    __format_arg(b, arg);
+    __format_to(b, args...);
+}
+
+template <typename ... Args>
+inline int format_to(char* buf, int size, Args const& ... args)
+{
+    FormatBuffer b(buf, size);
+    __format_to(b, args...);
+    return b.size();
+}
+
+/*
+ * formats into a thread local buffer; the result stays valid until the
+ * next call from the same thread. The trace macros write it out directly,
+ * so tracing does not allocate.
+ */
+static const int format_buf_size = 4096;
+
+// one buffer per thread, shared by all format_buf() instantiations
+FormatBuffer& __tls_format_buffer();
+
+template <typename ... Args>
+inline FormatBuffer& format_buf(Args const& ... args)
+{
+    FormatBuffer& b = __tls_format_buffer();
+    b.clear();
+    __format_to(b, args...);
+    return b;
+}
+
+template <typename ... Args>
+static std::string format(Args const& ... args)
+{
+    auto const& b = format_buf(args...);
+    if (!b.full())
+        return std::string(b.data(), b.size());
+
+    // longer than the thread local buffer: the same conversions into a
+    // growing string, so a value prints the same in any message
+    std::string s(2 * format_buf_size, '\0');
+    while (true)
+    {
+        FormatBuffer big(&s[0], int(s.size()));
+        __format_to(big, args...);
+        if (!big.full())
+        {
+            s.resize(big.size());
+            return s;
+        }
+        s.resize(2 * s.size());
+    }
+}
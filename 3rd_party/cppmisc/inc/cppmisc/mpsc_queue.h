@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "throws.h"
+
+
+/*
+ * Bounded lock-free multi-producer single-consumer queue
+ *
+ * Dmitry Vyukov's sequence-per-cell scheme: producers claim a cell with a
+ * CAS on the enqueue position, fill it in place and publish it through the
+ * cell sequence. Nothing is allocated after construction; a full queue makes
+ * try_push() fail instead of waiting.
+ */
+template <typename T>
+class MpscQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    std::vector<Cell>   _cells;
+    size_t              _mask;
+    alignas(64) std::atomic<size_t> _enqueue_pos;
+    alignas(64) size_t  _dequeue_pos;
+
+    MpscQueue(MpscQueue const&) = delete;
+
+public:
+    // capacity must be a power of two
+    MpscQueue(size_t capacity) : _cells(capacity), _mask(capacity - 1), _enqueue_pos(0), _dequeue_pos(0)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+            throw_invalid_argument("MpscQueue capacity must be a power of two");
+
+        for (size_t i = 0; i < capacity; ++ i)
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    /*
+     * fill(T&) is called on the claimed cell; returns false if the queue is full
+     */
+    template <typename Fill>
+    inline bool try_push(Fill&& fill)
+    {
+        size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true)
+        {
+            cell = &_cells[pos & _mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = intptr_t(seq) - intptr_t(pos);
+
+            if (dif == 0)
+            {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+                return false;
+            else
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+
+        fill(cell->data);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*
+     * consumer only; consume(T const&) is called on the oldest element
+     */
+    template <typename Consume>
+    inline bool try_pop(Consume&& consume)
+    {
+        Cell* cell = &_cells[_dequeue_pos & _mask];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+
+        if (seq != _dequeue_pos + 1)
+            return false;
+
+        consume(cell->data);
+        cell->seq.store(_dequeue_pos + _mask + 1, std::memory_order_release);
+        ++ _dequeue_pos;
+        return true;
+    }
+
+    inline size_t capacity() const
+    {
+        return _mask + 1;
+    }
+};
@@ -11,6 +11,7 @@ private:
     sighandler_t _sigint_handler;
     sighandler_t _sigterm_handler;
     sighandler_t _sighup_handler;
+    sighandler_t _sigusr1_handler;
 
     static void handle(int sig);
 
@@ -23,5 +24,6 @@ public:
     void set_sigint_handler(sighandler_t handler);
     void set_sigterm_handler(sighandler_t handler);
     void set_sighup_handler(sighandler_t handler);
+    void set_sigusr1_handler(sighandler_t handler);
     static SysSignals& instance();
 };
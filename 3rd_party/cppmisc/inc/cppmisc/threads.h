@@ -1,4 +1,14 @@
+#pragma once
+
 #include <pthread.h>
+#include <sched.h>
+#include <alloca.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <stdint.h>
+#include <vector>
 
 
 inline bool set_thread_rt_priotiy(pthread_t thread, int priotity)
@@ -22,3 +32,79 @@ inline bool clear_thread_priority(pthread_t thread)
     param.sched_priority = 0;
     return pthread_setschedparam(thread, policy, &param) == 0;
 }
+
+/*
+ * policy is one of SCHED_OTHER, SCHED_FIFO, SCHED_RR; returns 0 or an errno
+ */
+inline int set_thread_sched(pthread_t thread, int policy, int priority)
+{
+    sched_param param;
+    param.sched_priority = priority;
+    return pthread_setschedparam(thread, policy, &param);
+}
+
+inline bool get_thread_sched(pthread_t thread, int& policy, int& priority)
+{
+    sched_param param;
+    if (pthread_getschedparam(thread, &policy, &param) != 0)
+        return false;
+    priority = param.sched_priority;
+    return true;
+}
+
+/*
+ * pins the thread to the given cpus; returns 0 or an errno
+ */
+inline int set_thread_affinity(pthread_t thread, std::vector<int> const& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+        CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+inline std::vector<int> get_thread_affinity(pthread_t thread)
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    if (pthread_getaffinity_np(thread, sizeof(set), &set) != 0)
+        return cpus;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++ cpu)
+    {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/*
+ * locks current and future pages of the process; returns 0 or an errno
+ */
+inline int lock_process_memory()
+{
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : errno;
+}
+
+/*
+ * RLIMIT_MEMLOCK in bytes, -1 if unlimited
+ */
+inline int64_t memlock_limit()
+{
+    rlimit lim;
+    if (getrlimit(RLIMIT_MEMLOCK, &lim) != 0 || lim.rlim_cur == RLIM_INFINITY)
+        return -1;
+    return int64_t(lim.rlim_cur);
+}
+
+/*
+ * touches the next bytes of the calling thread's stack, so that with locked
+ * memory later calls don't page fault on it
+ */
+__attribute__((noinline)) inline void prefault_stack(size_t bytes)
+{
+    volatile char* p = reinterpret_cast<volatile char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096)
+        p[i] = 0;
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include <chrono>
 #include <time.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdexcept>
 
 
 inline int64_t epoch_usec()
@@ -36,26 +39,114 @@ inline double usec_to_sec(int64_t usec)
     return usec * 1e-6;
 }
 
-class LoopRate
+inline int64_t monotonic_nsec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Periodic scheduler with absolute deadlines on CLOCK_MONOTONIC
+ *
+ * Deadlines are t0 + k * period, so the handler run time does not shift the
+ * following deadlines. When spin_usec > 0 the thread sleeps until
+ * (deadline - spin) and busy-waits the rest, which trades CPU for wakeup
+ * jitter. If a deadline has already passed, wait() returns immediately and
+ * counts an overrun; whole periods that were missed are skipped rather than
+ * executed back to back.
+ */
+class PeriodicScheduler
 {
 private:
-    int64_t _t_prev;
-    int64_t _interval;
+    int64_t _period;
+    int64_t _spin;
+    int64_t _next;
+    int64_t _ticks;
+    int64_t _overruns;
+    int64_t _skipped;
+    int64_t _max_lateness;
+
+    static inline void sleep_until(int64_t t_nsec)
+    {
+        timespec ts;
+        ts.tv_sec = t_nsec / 1000000000;
+        ts.tv_nsec = t_nsec % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+    }
 
 public:
-    LoopRate(int64_t interval_usec) : _t_prev(epoch_usec()), _interval(interval_usec) {}
-    ~LoopRate() {}
+    PeriodicScheduler(int64_t period_usec, int64_t spin_usec = 0) :
+        _period(period_usec * 1000),
+        _spin(spin_usec * 1000)
+    {
+        if (period_usec <= 0)
+            throw std::invalid_argument("scheduler period must be positive");
+        reset();
+    }
 
-    inline void wait()
+    // the first deadline is one period from now
+    inline void reset()
+    {
+        _next = monotonic_nsec() + _period;
+        _ticks = 0;
+        _overruns = 0;
+        _skipped = 0;
+        _max_lateness = 0;
+    }
+
+    /*
+     * returns the number of periods skipped before this tick
+     */
+    inline int64_t wait()
     {
-        int64_t t = epoch_usec();
+        int64_t now = monotonic_nsec();
+        int64_t skipped = 0;
 
-        while (t < _t_prev + _interval)
+        if (now > _next)
         {
-            sleep_usec(_t_prev + _interval - t);
-            t = epoch_usec();
+            ++ _overruns;
+            skipped = (now - _next) / _period;
+            _next += skipped * _period;
+            _skipped += skipped;
         }
+        else
+        {
+            if (_next - now > _spin)
+                sleep_until(_next - _spin);
 
-        _t_prev = t;
+            now = monotonic_nsec();
+            while (now < _next)
+                now = monotonic_nsec();
+        }
+
+        int64_t lateness = now - _next;
+        if (lateness > _max_lateness)
+            _max_lateness = lateness;
+
+        _next += _period;
+        ++ _ticks;
+        return skipped;
+    }
+
+    inline int64_t period_usec() const { return _period / 1000; }
+    inline int64_t ticks() const { return _ticks; }
+    inline int64_t overruns() const { return _overruns; }
+    inline int64_t skipped() const { return _skipped; }
+    inline int64_t max_lateness_usec() const { return _max_lateness / 1000; }
+};
+
+class LoopRate
+{
+private:
+    PeriodicScheduler _scheduler;
+
+public:
+    LoopRate(int64_t interval_usec) : _scheduler(interval_usec) {}
+    ~LoopRate() {}
+
+    inline void wait()
+    {
+        _scheduler.wait();
     }
 };
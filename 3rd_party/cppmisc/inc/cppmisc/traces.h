@@ -4,6 +4,7 @@
 #include <unistd.h>
 #include <cassert>
 #include <stdio.h>
+#include <atomic>
 #include "formatting.h"
 #include "json.h"
 
@@ -13,6 +14,8 @@ namespace traces
     extern bool __enable_warn;
     extern bool __enable_err;
     extern bool __enable_info;
+    // read by every thread that traces, set by start_async() and stop_async()
+    extern std::atomic<bool> __enable_async;
 
     void init(Json::Value const& cfg);
     bool enable_dbg();
@@ -20,19 +23,50 @@ namespace traces
     bool enable_err();
     bool enable_info();
 
-    inline void write_stdout(std::string const& s)
+    /*
+     * async backend: messages are queued and written by a low priority
+     * thread; if the queue is full the message is dropped and counted
+     */
+    void start_async(int capacity);
+    void stop_async();
+    void async_write(int fd, char const* s, int len);
+    uint64_t async_dropped();
+
+    inline void write_stdout(char const* s, int len)
     {
-        int ans = write(1, s.c_str(), s.size());
+        if (__enable_async.load(std::memory_order_acquire))
+        {
+            async_write(1, s, len);
+            return;
+        }
+
+        int ans = write(1, s, len);
         assert(ans >= 0);
         unused(ans);
     }
 
-    inline void write_stderr(std::string const& s)
+    inline void write_stdout(std::string const& s)
     {
-        int ans = write(2, s.c_str(), s.size());
+        write_stdout(s.c_str(), s.size());
+    }
+
+    inline void write_stderr(char const* s, int len)
+    {
+        if (__enable_async.load(std::memory_order_acquire))
+        {
+            async_write(2, s, len);
+            return;
+        }
+
+        int ans = write(2, s, len);
         assert(ans >= 0);
         unused(ans);
     }
+
+    inline void write_stderr(std::string const& s)
+    {
+        write_stderr(s.c_str(), s.size());
+    }
 }
 
 template <class ... Args>
@@ -40,8 +74,9 @@ inline void info_msg(Args const& ... args)
 {
     if (!traces::__enable_info)
         return;
-    auto const& s = format("[inf] ", args..., "\n");
-    traces::write_stdout(s);
+    auto& b = format_buf("[inf] ", args..., "\n");
+    b.end_line();
+    traces::write_stdout(b.data(), b.size());
 }
 
 template <class ... Args>
@@ -49,8 +84,9 @@ inline void warn_msg(Args const& ... args)
 {
     if (!traces::__enable_warn)
         return;
-    auto const& s = format("[wrn] ", args..., "\n");
-    traces::write_stderr(s);
+    auto& b = format_buf("[wrn] ", args..., "\n");
+    b.end_line();
+    traces::write_stderr(b.data(), b.size());
 }
 
 template <class ... Args>
@@ -58,8 +94,9 @@ inline void err_msg(Args const& ... args)
 {
     if (!traces::__enable_err)
         return;
-    auto const& s = format("[err] ", args..., "\n");
-    traces::write_stderr(s);
+    auto& b = format_buf("[err] ", args..., "\n");
+    b.end_line();
+    traces::write_stderr(b.data(), b.size());
 }
 
 template <class ... Args>
@@ -67,13 +104,15 @@ inline void dbg_msg(Args const& ... args)
 {
     if (!traces::__enable_dbg)
         return;
-    auto const& s = format("[dbg] ", args..., "\n");
-    traces::write_stdout(s);
+    auto& b = format_buf("[dbg] ", args..., "\n");
+    b.end_line();
+    traces::write_stdout(b.data(), b.size());
 }
 
 template <class ... Args>
 inline void print_msg(Args const& ... args)
 {
-    auto const& s = format(args..., "\n");
-    traces::write_stdout(s);
+    auto& b = format_buf(args..., "\n");
+    b.end_line();
+    traces::write_stdout(b.data(), b.size());
 }
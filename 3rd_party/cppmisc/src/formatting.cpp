@@ -0,0 +1,428 @@
+#include <cppmisc/formatting.h>
+#include <string.h>
+#include <assert.h>
+#include <limits>
+
+
+/*
+ * Grisu2 double to text conversion (F. Loitsch, "Printing Floating-Point
+ * Numbers Quickly and Accurately with Integers", 2010)
+ *
+ * The result always reads back to the same double and is the shortest such
+ * representation in all but a tiny fraction of cases. Only integer
+ * arithmetic is used and nothing is allocated.
+ */
+
+namespace
+{
+    struct DiyFp
+    {
+        uint64_t f;
+        int e;
+
+        DiyFp(uint64_t f_, int e_) : f(f_), e(e_) {}
+
+        static DiyFp sub(DiyFp const& x, DiyFp const& y)
+        {
+            assert(x.e == y.e && x.f >= y.f);
+            return DiyFp(x.f - y.f, x.e);
+        }
+
+        // upper 64 bits of the product, rounded
+        static DiyFp mul(DiyFp const& x, DiyFp const& y)
+        {
+            unsigned __int128 p = (unsigned __int128)x.f * y.f;
+            uint64_t h = uint64_t(p >> 64);
+            uint64_t l = uint64_t(p);
+            h += l >> 63;
+            return DiyFp(h, x.e + y.e + 64);
+        }
+
+        static DiyFp normalize(DiyFp x)
+        {
+            int shift = __builtin_clzll(x.f);
+            return DiyFp(x.f << shift, x.e - shift);
+        }
+
+        static DiyFp normalize_to(DiyFp const& x, int e)
+        {
+            return DiyFp(x.f << (x.e - e), e);
+        }
+    };
+
+    struct Boundaries
+    {
+        DiyFp w;
+        DiyFp minus;
+        DiyFp plus;
+    };
+
+    template <typename T> struct FloatBits;
+    template <> struct FloatBits<double> { typedef uint64_t type; };
+    template <> struct FloatBits<float> { typedef uint32_t type; };
+
+    // v and the midpoints to its neighbours, v must be positive
+    template <typename T>
+    Boundaries compute_boundaries(T value)
+    {
+        const int precision = std::numeric_limits<T>::digits;
+        const int bias = std::numeric_limits<T>::max_exponent - 1 + precision - 1;
+        const int min_exp = 1 - bias;
+        const uint64_t hidden_bit = uint64_t(1) << (precision - 1);
+
+        typename FloatBits<T>::type bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint64_t F = bits & (hidden_bit - 1);
+        int E = int(bits >> (precision - 1));
+
+        DiyFp v = E == 0 ? DiyFp(F, min_exp) : DiyFp(F + hidden_bit, E - bias);
+
+        // the lower neighbour is closer when v is a power of two
+        bool lower_closer = F == 0 && E > 1;
+        DiyFp m_plus(2 * v.f + 1, v.e - 1);
+        DiyFp m_minus = lower_closer ? DiyFp(4 * v.f - 1, v.e - 2) : DiyFp(2 * v.f - 1, v.e - 1);
+
+        DiyFp w_plus = DiyFp::normalize(m_plus);
+        DiyFp w_minus = DiyFp::normalize_to(m_minus, w_plus.e);
+        return Boundaries{DiyFp::normalize(v), w_minus, w_plus};
+    }
+
+    // the scaled values get a binary exponent in [alpha, gamma]
+    const int alpha = -60;
+    const int gamma = -32;
+
+    struct CachedPower
+    {
+        uint64_t f;
+        int e;
+        int k;
+    };
+
+    const int cached_powers_min_dec_exp = -300;
+    const int cached_powers_dec_step = 8;
+
+    // normalized 10^k for k = -300, -292, ..., 324
+    const CachedPower cached_powers[] = {
+        { 0xAB70FE17C79AC6CA, -1060, -300 },
+        { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+        { 0xBE5691EF416BD60C, -1007, -284 },
+        { 0x8DD01FAD907FFC3C,  -980, -276 },
+        { 0xD3515C2831559A83,  -954, -268 },
+        { 0x9D71AC8FADA6C9B5,  -927, -260 },
+        { 0xEA9C227723EE8BCB,  -901, -252 },
+        { 0xAECC49914078536D,  -874, -244 },
+        { 0x823C12795DB6CE57,  -847, -236 },
+        { 0xC21094364DFB5637,  -821, -228 },
+        { 0x9096EA6F3848984F,  -794, -220 },
+        { 0xD77485CB25823AC7,  -768, -212 },
+        { 0xA086CFCD97BF97F4,  -741, -204 },
+        { 0xEF340A98172AACE5,  -715, -196 },
+        { 0xB23867FB2A35B28E,  -688, -188 },
+        { 0x84C8D4DFD2C63F3B,  -661, -180 },
+        { 0xC5DD44271AD3CDBA,  -635, -172 },
+        { 0x936B9FCEBB25C996,  -608, -164 },
+        { 0xDBAC6C247D62A584,  -582, -156 },
+        { 0xA3AB66580D5FDAF6,  -555, -148 },
+        { 0xF3E2F893DEC3F126,  -529, -140 },
+        { 0xB5B5ADA8AAFF80B8,  -502, -132 },
+        { 0x87625F056C7C4A8B,  -475, -124 },
+        { 0xC9BCFF6034C13053,  -449, -116 },
+        { 0x964E858C91BA2655,  -422, -108 },
+        { 0xDFF9772470297EBD,  -396, -100 },
+        { 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+        { 0xF8A95FCF88747D94,  -343,  -84 },
+        { 0xB94470938FA89BCF,  -316,  -76 },
+        { 0x8A08F0F8BF0F156B,  -289,  -68 },
+        { 0xCDB02555653131B6,  -263,  -60 },
+        { 0x993FE2C6D07B7FAC,  -236,  -52 },
+        { 0xE45C10C42A2B3B06,  -210,  -44 },
+        { 0xAA242499697392D3,  -183,  -36 },
+        { 0xFD87B5F28300CA0E,  -157,  -28 },
+        { 0xBCE5086492111AEB,  -130,  -20 },
+        { 0x8CBCCC096F5088CC,  -103,  -12 },
+        { 0xD1B71758E219652C,   -77,   -4 },
+        { 0x9C40000000000000,   -50,    4 },
+        { 0xE8D4A51000000000,   -24,   12 },
+        { 0xAD78EBC5AC620000,     3,   20 },
+        { 0x813F3978F8940984,    30,   28 },
+        { 0xC097CE7BC90715B3,    56,   36 },
+        { 0x8F7E32CE7BEA5C70,    83,   44 },
+        { 0xD5D238A4ABE98068,   109,   52 },
+        { 0x9F4F2726179A2245,   136,   60 },
+        { 0xED63A231D4C4FB27,   162,   68 },
+        { 0xB0DE65388CC8ADA8,   189,   76 },
+        { 0x83C7088E1AAB65DB,   216,   84 },
+        { 0xC45D1DF942711D9A,   242,   92 },
+        { 0x924D692CA61BE758,   269,  100 },
+        { 0xDA01EE641A708DEA,   295,  108 },
+        { 0xA26DA3999AEF774A,   322,  116 },
+        { 0xF209787BB47D6B85,   348,  124 },
+        { 0xB454E4A179DD1877,   375,  132 },
+        { 0x865B86925B9BC5C2,   402,  140 },
+        { 0xC83553C5C8965D3D,   428,  148 },
+        { 0x952AB45CFA97A0B3,   455,  156 },
+        { 0xDE469FBD99A05FE3,   481,  164 },
+        { 0xA59BC234DB398C25,   508,  172 },
+        { 0xF6C69A72A3989F5C,   534,  180 },
+        { 0xB7DCBF5354E9BECE,   561,  188 },
+        { 0x88FCF317F22241E2,   588,  196 },
+        { 0xCC20CE9BD35C78A5,   614,  204 },
+        { 0x98165AF37B2153DF,   641,  212 },
+        { 0xE2A0B5DC971F303A,   667,  220 },
+        { 0xA8D9D1535CE3B396,   694,  228 },
+        { 0xFB9B7CD9A4A7443C,   720,  236 },
+        { 0xBB764C4CA7A44410,   747,  244 },
+        { 0x8BAB8EEFB6409C1A,   774,  252 },
+        { 0xD01FEF10A657842C,   800,  260 },
+        { 0x9B10A4E5E9913129,   827,  268 },
+        { 0xE7109BFBA19C0C9D,   853,  276 },
+        { 0xAC2820D9623BF429,   880,  284 },
+        { 0x80444B5E7AA7CF85,   907,  292 },
+        { 0xBF21E44003ACDD2D,   933,  300 },
+        { 0x8E679C2F5E44FF8F,   960,  308 },
+        { 0xD433179D9C8CB841,   986,  316 },
+        { 0x9E19DB92B4E31BA9,  1013,  324 },
+    };
+
+    CachedPower cached_power_for_binary_exponent(int e)
+    {
+        // k = ceil((alpha - e - 1) * log10(2))
+        int f = alpha - e - 1;
+        int k = (f * 78913) / (1 << 18) + (f > 0);
+        int index = (-cached_powers_min_dec_exp + k + (cached_powers_dec_step - 1)) / cached_powers_dec_step;
+        assert(index >= 0 && index < int(sizeof(cached_powers) / sizeof(cached_powers[0])));
+
+        CachedPower const& cached = cached_powers[index];
+        assert(alpha <= cached.e + e + 64 && cached.e + e + 64 <= gamma);
+        return cached;
+    }
+
+    // number of decimal digits of n, pow10 receives 10^(digits - 1)
+    int find_largest_pow10(uint32_t n, uint32_t& pow10)
+    {
+        static const uint32_t powers[] = {
+            1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+        };
+
+        int digits = 1;
+        while (digits < 10 && n >= powers[digits])
+            ++ digits;
+        pow10 = powers[digits - 1];
+        return digits;
+    }
+
+    void round_last_digit(char* buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k)
+    {
+        // move the last digit towards w as long as it stays in the interval
+        while (rest < dist && delta - rest >= ten_k &&
+            (rest + ten_k < dist || dist - rest > rest + ten_k - dist))
+        {
+            assert(buf[len - 1] != '0');
+            buf[len - 1] --;
+            rest += ten_k;
+        }
+    }
+
+    void generate_digits(char* buf, int& len, int& dec_exp, DiyFp const& M_minus, DiyFp const& w, DiyFp const& M_plus)
+    {
+        uint64_t delta = DiyFp::sub(M_plus, M_minus).f;
+        uint64_t dist = DiyFp::sub(M_plus, w).f;
+
+        // split M_plus into an integral part p1 and a fractional part p2
+        DiyFp one(uint64_t(1) << -M_plus.e, M_plus.e);
+        uint32_t p1 = uint32_t(M_plus.f >> -one.e);
+        uint64_t p2 = M_plus.f & (one.f - 1);
+
+        uint32_t pow10;
+        int n = find_largest_pow10(p1, pow10);
+
+        while (n > 0)
+        {
+            uint32_t d = p1 / pow10;
+            p1 %= pow10;
+            buf[len ++] = char('0' + d);
+            -- n;
+
+            uint64_t rest = (uint64_t(p1) << -one.e) + p2;
+            if (rest <= delta)
+            {
+                dec_exp += n;
+                round_last_digit(buf, len, dist, delta, rest, uint64_t(pow10) << -one.e);
+                return;
+            }
+
+            pow10 /= 10;
+        }
+
+        int m = 0;
+        while (true)
+        {
+            p2 *= 10;
+            uint64_t d = p2 >> -one.e;
+            p2 &= one.f - 1;
+            buf[len ++] = char('0' + d);
+            ++ m;
+
+            delta *= 10;
+            dist *= 10;
+            if (p2 <= delta)
+                break;
+        }
+
+        dec_exp -= m;
+        round_last_digit(buf, len, dist, delta, p2, one.f);
+    }
+
+    // digits of a positive v such that v = digits * 10^dec_exp
+    template <typename T>
+    void grisu2(char* buf, int& len, int& dec_exp, T v)
+    {
+        Boundaries b = compute_boundaries(v);
+        CachedPower cached = cached_power_for_binary_exponent(b.plus.e);
+        DiyFp c(cached.f, cached.e);
+
+        DiyFp w = DiyFp::mul(b.w, c);
+        DiyFp w_minus = DiyFp::mul(b.minus, c);
+        DiyFp w_plus = DiyFp::mul(b.plus, c);
+
+        // shrink the interval by one unit to stay on the safe side of the
+        // rounding errors of the multiplication
+        DiyFp M_minus(w_minus.f + 1, w_minus.e);
+        DiyFp M_plus(w_plus.f - 1, w_plus.e);
+
+        len = 0;
+        dec_exp = -cached.k;
+        generate_digits(buf, len, dec_exp, M_minus, w, M_plus);
+    }
+
+    char* write_exponent(char* p, int e)
+    {
+        *p ++ = 'e';
+        if (e < 0)
+        {
+            *p ++ = '-';
+            e = -e;
+        }
+        else
+        {
+            *p ++ = '+';
+        }
+
+        // at least two digits, like printf
+        if (e >= 100)
+        {
+            *p ++ = char('0' + e / 100);
+            e %= 100;
+        }
+        *p ++ = char('0' + e / 10);
+        *p ++ = char('0' + e % 10);
+        return p;
+    }
+
+    template <typename T>
+    int format_shortest(T v, char* buf, int min_precision)
+    {
+        // classified from the bits: -Ofast implies -ffinite-math-only and
+        // -fno-signed-zeros, which fold std::isnan and friends away
+        typedef typename FloatBits<T>::type Bits;
+        const int sign_shift = int(sizeof(Bits)) * 8 - 1;
+        const Bits mantissa_mask = (Bits(1) << (std::numeric_limits<T>::digits - 1)) - 1;
+        const Bits exponent_mask = ~mantissa_mask & ~(Bits(1) << sign_shift);
+
+        Bits bits;
+        memcpy(&bits, &v, sizeof(bits));
+        bool negative = (bits >> sign_shift) != 0;
+        Bits exponent = bits & exponent_mask;
+        Bits mantissa = bits & mantissa_mask;
+
+        if (exponent == exponent_mask && mantissa != 0)
+        {
+            memcpy(buf, negative ? "-nan" : "nan", 4);
+            return negative ? 4 : 3;
+        }
+
+        char* p = buf;
+        if (negative)
+        {
+            *p ++ = '-';
+            bits &= ~(Bits(1) << sign_shift);
+            memcpy(&v, &bits, sizeof(bits));
+        }
+
+        if (exponent == exponent_mask)
+        {
+            memcpy(p, "inf", 3);
+            return int(p - buf) + 3;
+        }
+
+        if (exponent == 0 && mantissa == 0)
+        {
+            *p ++ = '0';
+            return int(p - buf);
+        }
+
+        char digits[20];
+        int len, dec_exp;
+        grisu2(digits, len, dec_exp, v);
+
+        // the same choice between fixed and exponential notation as %.Pg
+        // makes, with P being the number of digits but at least min_precision
+        int x = len + dec_exp - 1;
+        int precision = len > min_precision ? len : min_precision;
+
+        if (x < -4 || x >= precision)
+        {
+            *p ++ = digits[0];
+            if (len > 1)
+            {
+                *p ++ = '.';
+                memcpy(p, digits + 1, len - 1);
+                p += len - 1;
+            }
+            p = write_exponent(p, x);
+        }
+        else if (x < 0)
+        {
+            *p ++ = '0';
+            *p ++ = '.';
+            for (int i = 0; i < -x - 1; ++ i)
+                *p ++ = '0';
+            memcpy(p, digits, len);
+            p += len;
+        }
+        else if (x + 1 >= len)
+        {
+            memcpy(p, digits, len);
+            p += len;
+            for (int i = len; i < x + 1; ++ i)
+                *p ++ = '0';
+        }
+        else
+        {
+            memcpy(p, digits, x + 1);
+            p += x + 1;
+            *p ++ = '.';
+            memcpy(p, digits + x + 1, len - x - 1);
+            p += len - x - 1;
+        }
+
+        return int(p - buf);
+    }
+}
+
+FormatBuffer& __tls_format_buffer()
+{
+    static thread_local char buf[format_buf_size];
+    static thread_local FormatBuffer b(buf, format_buf_size);
+    return b;
+}
+
+int format_double(double v, char* buf)
+{
+    return format_shortest(v, buf, 15);
+}
+
+int format_float(float v, char* buf)
+{
+    return format_shortest(v, buf, 6);
+}
@@ -21,6 +21,12 @@ void SysSignals::set_sighup_handler(sighandler_t handler)
     signal(SIGHUP, &SysSignals::handle);
 }
 
+void SysSignals::set_sigusr1_handler(sighandler_t handler)
+{
+    _sigusr1_handler = std::move(handler);
+    signal(SIGUSR1, &SysSignals::handle);
+}
+
 void SysSignals::handle(int sig)
 {
     SysSignals& inst = SysSignals::instance();
@@ -39,6 +45,10 @@ void SysSignals::handle(int sig)
         if (inst._sighup_handler)
             inst._sighup_handler();
         break;
+    case SIGUSR1:
+        if (inst._sigusr1_handler)
+            inst._sigusr1_handler();
+        break;
     }
 }
 
@@ -1,4 +1,12 @@
 #include <cppmisc/traces.h>
+#include <cppmisc/mpsc_queue.h>
+#include <cppmisc/timing.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <new>
 
 
 namespace traces
@@ -7,6 +15,147 @@ namespace traces
     bool __enable_warn = true;
     bool __enable_err = true;
     bool __enable_info = true;
+    std::atomic<bool> __enable_async(false);
+
+    namespace
+    {
+        const int record_size = 256;
+        const int writer_nice = 10;
+        const int64_t writer_idle_usec = 1000;
+
+        struct Record
+        {
+            int fd;
+            int len;
+            char data[record_size];
+        };
+
+        struct AsyncBackend
+        {
+            MpscQueue<Record>       queue;
+            std::atomic<uint64_t>   dropped;
+            std::atomic<bool>       stop;
+            std::thread             writer;
+
+            AsyncBackend(int capacity) : queue(capacity), dropped(0), stop(false) {}
+        };
+
+        AsyncBackend* backend = nullptr;
+
+        void write_all(int fd, char const* s, int len)
+        {
+            while (len > 0)
+            {
+                int n = write(fd, s, len);
+                if (n <= 0)
+                    return;
+                s += n;
+                len -= n;
+            }
+        }
+
+        void writer_loop(AsyncBackend* b)
+        {
+            setpriority(PRIO_PROCESS, syscall(SYS_gettid), writer_nice);
+
+            char buf[4096];
+            int buf_fd = -1;
+            int buf_len = 0;
+            uint64_t reported = 0;
+
+            auto flush = [&]() {
+                if (buf_len > 0)
+                    write_all(buf_fd, buf, buf_len);
+                buf_len = 0;
+            };
+
+            auto consume = [&](Record const& r) {
+                if (r.fd != buf_fd || buf_len + r.len > int(sizeof(buf)))
+                    flush();
+                buf_fd = r.fd;
+                memcpy(buf + buf_len, r.data, r.len);
+                buf_len += r.len;
+            };
+
+            while (true)
+            {
+                bool idle = true;
+                while (b->queue.try_pop(consume))
+                    idle = false;
+                flush();
+
+                uint64_t dropped = b->dropped.load(std::memory_order_relaxed);
+                if (dropped != reported)
+                {
+                    auto const& s = format("[wrn] traces: ", dropped - reported, " messages dropped\n");
+                    write_all(2, s.c_str(), s.size());
+                    reported = dropped;
+                }
+
+                if (idle)
+                {
+                    if (b->stop)
+                        break;
+                    sleep_usec(writer_idle_usec);
+                }
+            }
+        }
+    }
+
+    void start_async(int capacity)
+    {
+        if (backend)
+            return;
+
+        int sz = 2;
+        while (sz < capacity)
+            sz *= 2;
+
+        // the queue is cache line aligned, which plain new ignores in C++14
+        void* mem = nullptr;
+        if (posix_memalign(&mem, alignof(AsyncBackend), sizeof(AsyncBackend)) != 0)
+            throw std::bad_alloc();
+        backend = new (mem) AsyncBackend(sz);
+        backend->writer = std::thread(writer_loop, backend);
+        __enable_async.store(true, std::memory_order_release);
+        atexit(stop_async);
+    }
+
+    void stop_async()
+    {
+        if (!backend || backend->stop)
+            return;
+
+        // late messages go straight to the descriptors; the backend itself is
+        // never freed as a producer may still be inside async_write()
+        __enable_async.store(false, std::memory_order_relaxed);
+        backend->stop = true;
+        if (backend->writer.joinable())
+            backend->writer.join();
+    }
+
+    void async_write(int fd, char const* s, int len)
+    {
+        bool truncated = len > record_size;
+        if (truncated)
+            len = record_size;
+
+        bool pushed = backend->queue.try_push([fd, s, len, truncated](Record& r) {
+            r.fd = fd;
+            r.len = len;
+            memcpy(r.data, s, len);
+            if (truncated)
+                memcpy(r.data + len - 4, "...\n", 4);
+        });
+
+        if (!pushed)
+            backend->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t async_dropped()
+    {
+        return backend ? backend->dropped.load(std::memory_order_relaxed) : 0;
+    }
 
     void init(Json::Value const& cfg)
     {
@@ -42,5 +191,21 @@ namespace traces
         __enable_warn = enable_warn;
         __enable_err = enable_err;
         __enable_info = enable_info;
+
+        // "async": true or "async": {"capacity": N}
+        if (json_has(cfg, "async"))
+        {
+            auto const& async = cfg["async"];
+            int capacity = 1024;
+
+            if (async.isObject())
+            {
+                if (json_has(async, "capacity"))
+                    json_get(async, "capacity", capacity);
+                start_async(capacity);
+            }
+            else if (async.asBool())
+                start_async(capacity);
+        }
     }
 }
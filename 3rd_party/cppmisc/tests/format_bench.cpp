@@ -0,0 +1,48 @@
+#include <cppmisc/formatting.h>
+#include <cppmisc/timing.h>
+#include <stdio.h>
+
+
+/*
+ * Compares format_buf() with the stringstream based format_stream() on a
+ * typical trace line: a tag, a few integers and doubles.
+ */
+
+template <typename F>
+double bench(F&& f, int n)
+{
+    int64_t t0 = monotonic_nsec();
+    for (int i = 0; i < n; ++ i)
+        f(i);
+    return double(monotonic_nsec() - t0) / n;
+}
+
+int main(int argc, char const* argv[])
+{
+    const int N = argc > 1 ? atoi(argv[1]) : 1000000;
+    volatile int sink = 0;
+
+    double t_stream = bench([&](int i) {
+        auto const& s = format_stream("[log] t=", i * 1e-3, " theta=", 0.1 * i, " x=", i, " y=", -i, "\n");
+        sink += s.size();
+    }, N);
+
+    double t_buf = bench([&](int i) {
+        auto const& b = format_buf("[log] t=", i * 1e-3, " theta=", 0.1 * i, " x=", i, " y=", -i, "\n");
+        sink += b.size();
+    }, N);
+
+    double t_int_stream = bench([&](int i) {
+        auto const& s = format_stream(i, " ", i * 7, " ", -i);
+        sink += s.size();
+    }, N);
+
+    double t_int_buf = bench([&](int i) {
+        auto const& b = format_buf(i, " ", i * 7, " ", -i);
+        sink += b.size();
+    }, N);
+
+    printf("mixed:    stringstream %7.1f ns, buffer %7.1f ns\n", t_stream, t_buf);
+    printf("integers: stringstream %7.1f ns, buffer %7.1f ns\n", t_int_stream, t_int_buf);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <cppmisc/formatting.h>
+#include <cppmisc/misc.h>
+#include <assert.h>
+#include <limits>
+#include <random>
+
+
+struct Point
+{
+    int x, y;
+};
+
+std::ostream& operator << (std::ostream& s, Point const& p)
+{
+    return s << "(" << p.x << ", " << p.y << ")";
+}
+
+enum Color { red, green, blue };
+
+void test_integers()
+{
+    assert(format(0) == "0");
+    assert(format(7, " ", -7, " ", 10, " ", 99, " ", 100) == "7 -7 10 99 100");
+    assert(format(std::numeric_limits<int64_t>::min()) == "-9223372036854775808");
+    assert(format(std::numeric_limits<uint64_t>::max()) == "18446744073709551615");
+    assert(format(short(-3), (unsigned short)4, 5u, 6l, 7ul) == "-34567");
+    assert(format(true, false) == "10");
+    assert(format('a', (unsigned char)'b', (signed char)'c') == "abc");
+
+    std::mt19937_64 gen(1);
+    for (int i = 0; i < 10000; ++ i)
+    {
+        int64_t v = int64_t(gen()) >> (gen() % 64);
+        assert(format(v) == format_stream(v));
+    }
+}
+
+void test_doubles()
+{
+    assert(format(0.) == "0");
+    assert(format(-0.) == "-0");
+    assert(format(1.5) == "1.5");
+    assert(format(-250.) == "-250");
+    assert(format(0.1) == "0.1");
+    assert(format(0.1 + 0.2) == "0.30000000000000004");
+    assert(format(1e-5) == "1e-05");
+    assert(format(1e100) == "1e+100");
+    assert(format(std::numeric_limits<double>::infinity()) == "inf");
+    assert(format(-std::numeric_limits<double>::infinity()) == "-inf");
+    assert(format(std::numeric_limits<double>::quiet_NaN()) == "nan");
+    assert(format(std::numeric_limits<double>::denorm_min()) == "5e-324");
+    assert(format(std::numeric_limits<float>::infinity()) == "inf");
+    assert(format(std::numeric_limits<float>::quiet_NaN()) == "nan");
+    assert(format(-0.f) == "-0");
+    assert(format(0.1f) == "0.1");
+    assert(format(1.f / 3) == "0.33333334");
+
+    // the output must read back to the same value
+    std::mt19937_64 gen(2);
+    std::uniform_real_distribution<double> mantissa(-1., 1.);
+    std::uniform_int_distribution<int> exponent(-300, 300);
+    for (int i = 0; i < 100000; ++ i)
+    {
+        double v = ldexp(mantissa(gen), exponent(gen));
+        auto const& s = format(v);
+        assert(strtod(s.c_str(), nullptr) == v);
+        assert(s.size() <= 24);
+    }
+}
+
+void test_strings()
+{
+    char const* cstr = "cstr";
+    char buf[] = "buf";
+    std::string str = "str";
+    assert(format("literal ", cstr, " ", buf, " ", str) == "literal cstr buf str");
+    assert(format((char const*)nullptr) == "");
+    assert(format() == "");
+}
+
+void test_fallback()
+{
+    assert(format(Point{1, -2}) == "(1, -2)");
+    assert(format(blue) == "2");
+}
+
+void test_truncation()
+{
+    char buf[8];
+    int n = format_to(buf, sizeof(buf), "0123", 4567, 89);
+    assert(n == 8);
+    assert(std::string(buf, n) == "01234567");
+
+    // format() never truncates
+    std::string big(3 * format_buf_size, 'x');
+    assert(format("a", big, "b") == "a" + big + "b");
+    assert(format(big, 0.1 + 0.2) == big + "0.30000000000000004");
+
+    auto& b = format_buf(big, "\n");
+    assert(b.full());
+    b.end_line();
+    assert(b.data()[b.size() - 1] == '\n');
+    unused(n);
+}
+
+int main()
+{
+    test_integers();
+    test_doubles();
+    test_strings();
+    test_fallback();
+    test_truncation();
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <thread>
+#include <vector>
+#include <cppmisc/mpsc_queue.h>
+#include <cppmisc/misc.h>
+#include <assert.h>
+
+
+struct Item
+{
+    int producer;
+    int value;
+};
+
+void test_single_thread()
+{
+    MpscQueue<int> q(4);
+    int v;
+    auto get = [&v](int const& x) { v = x; };
+
+    assert(!q.try_pop(get));
+    for (int i = 0; i < 4; ++ i)
+        assert(q.try_push([i](int& x) { x = i; }));
+    assert(!q.try_push([](int& x) { x = -1; }));
+
+    for (int i = 0; i < 4; ++ i)
+    {
+        assert(q.try_pop(get));
+        assert(v == i);
+    }
+    assert(!q.try_pop(get));
+}
+
+void test_multiple_producers()
+{
+    const int nproducers = 4;
+    const int N = 100000;
+    MpscQueue<Item> q(256);
+    std::vector<std::thread> producers;
+
+    for (int p = 0; p < nproducers; ++ p)
+    {
+        producers.emplace_back([&q, p, N]() {
+            for (int i = 0; i < N; ++ i)
+            {
+                while (!q.try_push([p, i](Item& item) { item.producer = p; item.value = i; }))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<int> next(nproducers, 0);
+    int received = 0;
+
+    while (received < nproducers * N)
+    {
+        bool ok = q.try_pop([&next](Item const& item) {
+            // every producer's items come in order
+            assert(item.value == next[item.producer]);
+            ++ next[item.producer];
+        });
+
+        if (ok)
+            ++ received;
+        else
+            std::this_thread::yield();
+    }
+
+    for (auto& t : producers)
+        t.join();
+
+    for (int p = 0; p < nproducers; ++ p)
+        assert(next[p] == N);
+}
+
+int main(int argc, char const* argv[])
+{
+    test_single_thread();
+    test_multiple_producers();
+    return 0;
+}
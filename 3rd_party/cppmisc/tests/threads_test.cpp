@@ -0,0 +1,73 @@
+#include <cppmisc/threads.h>
+#include <cppmisc/misc.h>
+#include <sys/resource.h>
+#include <assert.h>
+
+
+void test_sched()
+{
+    pthread_t self = pthread_self();
+    int ans = set_thread_sched(self, SCHED_OTHER, 0);
+    assert(ans == 0);
+
+    int policy = -1, priority = -1;
+    bool ok = get_thread_sched(self, policy, priority);
+    assert(ok);
+    assert(policy == SCHED_OTHER);
+    assert(priority == 0);
+
+    // an invalid priority is reported, not silently clamped
+    ans = set_thread_sched(self, SCHED_FIFO, 1000);
+    assert(ans == EINVAL);
+    unused(ans);
+    unused(ok);
+}
+
+void test_affinity()
+{
+    pthread_t self = pthread_self();
+    auto const& cpus = get_thread_affinity(self);
+    assert(!cpus.empty());
+
+    int ans = set_thread_affinity(self, {cpus[0]});
+    assert(ans == 0);
+    auto const& pinned = get_thread_affinity(self);
+    assert(pinned.size() == 1 && pinned[0] == cpus[0]);
+
+    ans = set_thread_affinity(self, cpus);
+    assert(ans == 0);
+    assert(get_thread_affinity(self) == cpus);
+    unused(ans);
+}
+
+void test_prefault_stack()
+{
+    const size_t size = 256 * 1024;
+    prefault_stack(size);
+
+    // the pages are already there, touching them again must not fault
+    rusage before, after;
+    getrusage(RUSAGE_THREAD, &before);
+    prefault_stack(size);
+    getrusage(RUSAGE_THREAD, &after);
+    assert(after.ru_minflt - before.ru_minflt < 4);
+
+}
+
+void test_memlock_limit()
+{
+    rlimit lim;
+    getrlimit(RLIMIT_MEMLOCK, &lim);
+    int64_t limit = memlock_limit();
+    assert(limit == (lim.rlim_cur == RLIM_INFINITY ? -1 : int64_t(lim.rlim_cur)));
+    unused(limit);
+}
+
+int main()
+{
+    test_sched();
+    test_affinity();
+    test_prefault_stack();
+    test_memlock_limit();
+    return 0;
+}
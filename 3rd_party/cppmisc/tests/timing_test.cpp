@@ -0,0 +1,78 @@
+#include <cppmisc/timing.h>
+#include <cppmisc/misc.h>
+#include <assert.h>
+
+
+void test_no_drift()
+{
+    const int N = 200;
+    const int64_t period = 1000;
+    PeriodicScheduler scheduler(period);
+    int64_t t0 = monotonic_nsec();
+
+    for (int i = 0; i < N; ++ i)
+    {
+        scheduler.wait();
+        sleep_usec(300);
+    }
+
+    // the handler run time must not accumulate
+    int64_t elapsed = (monotonic_nsec() - t0) / 1000;
+    assert(elapsed >= N * period);
+    assert(elapsed < N * period + 20 * period);
+    assert(scheduler.ticks() == N);
+    unused(elapsed);
+}
+
+void test_overruns()
+{
+    const int64_t period = 2000;
+    PeriodicScheduler scheduler(period);
+
+    scheduler.wait();
+    sleep_usec(3 * period + period / 2);
+    int64_t skipped = scheduler.wait();
+    assert(skipped >= 2);
+    assert(scheduler.overruns() == 1);
+    assert(scheduler.skipped() == skipped);
+
+    // the schedule stays aligned to the original grid
+    scheduler.wait();
+    assert(scheduler.ticks() == 3);
+    unused(skipped);
+}
+
+void test_spin()
+{
+    PeriodicScheduler scheduler(1000, 200);
+    for (int i = 0; i < 20; ++ i)
+        scheduler.wait();
+    assert(scheduler.ticks() == 20);
+}
+
+void test_bad_period()
+{
+    for (int64_t period : {0, -1})
+    {
+        bool thrown = false;
+        try
+        {
+            PeriodicScheduler scheduler(period);
+        }
+        catch (std::invalid_argument const&)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+        unused(thrown);
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    test_no_drift();
+    test_overruns();
+    test_spin();
+    test_bad_period();
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <cppmisc/traces.h>
+#include <cppmisc/files.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <string.h>
+#include <assert.h>
+
+
+void test_async()
+{
+    char path[] = "/tmp/traces_test_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+
+    int saved_stdout = dup(1);
+    dup2(fd, 1);
+
+    traces::init(json_parse(R"({"enable": ["info"], "async": {"capacity": 64}})"));
+    assert(traces::__enable_async);
+
+    const int N = 32;
+    for (int i = 0; i < N; ++ i)
+        info_msg("message ", i);
+
+    std::string long_msg(1000, 'x');
+    info_msg(long_msg);
+
+    traces::stop_async();
+    assert(!traces::__enable_async);
+
+    dup2(saved_stdout, 1);
+    close(saved_stdout);
+    close(fd);
+
+    std::string const& data = read_all(path);
+    unlink(path);
+
+    size_t pos = 0;
+    for (int i = 0; i < N; ++ i)
+    {
+        std::string line = format("[inf] message ", i, "\n");
+        pos = data.find(line, pos);
+        assert(pos != std::string::npos);
+        pos += line.size();
+    }
+
+    // long messages are truncated, not split
+    assert(data.find("...\n", pos) != std::string::npos);
+    assert(traces::async_dropped() == 0);
+}
+
+int main(int argc, char const* argv[])
+{
+    test_async();
+    return 0;
+}
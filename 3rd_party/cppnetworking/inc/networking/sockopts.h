@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cppmisc/json.h>
+
+
+/*
+ * Socket options for latency sensitive connections
+ *
+ * The default profile leaves every option as the kernel sets it. Options
+ * that can't be applied (e.g. SO_BUSY_POLL without CAP_NET_ADMIN) are
+ * reported as warnings and don't fail the connection.
+ */
+struct SocketProfile
+{
+    bool    nodelay;            // TCP_NODELAY, disables Nagle's algorithm
+    bool    quickack;           // TCP_QUICKACK, re-armed after every read
+    int     busy_poll_usec;     // SO_BUSY_POLL, 0 -- off
+    int     priority;           // SO_PRIORITY, -1 -- unchanged
+    int     tos;                // IP_TOS, -1 -- unchanged
+    int     rcvbuf;             // SO_RCVBUF in bytes, 0 -- unchanged
+    int     sndbuf;             // SO_SNDBUF in bytes, 0 -- unchanged
+
+    SocketProfile() :
+        nodelay(false),
+        quickack(false),
+        busy_poll_usec(0),
+        priority(-1),
+        tos(-1),
+        rcvbuf(0),
+        sndbuf(0)
+    {}
+
+    // small packets go out at once and are acknowledged at once
+    static SocketProfile low_latency()
+    {
+        SocketProfile p;
+        p.nodelay = true;
+        p.quickack = true;
+        p.priority = 6;
+        return p;
+    }
+};
+
+/*
+ * applies the profile to the socket; TCP options are skipped for other
+ * protocols; returns the number of options that failed
+ */
+int apply_socket_profile(int sock, SocketProfile const& profile);
+
+// re-arms TCP_QUICKACK, the kernel clears it on its own
+void rearm_quickack(int sock);
+
+/*
+ * config block, all keys are optional:
+ *   {"nodelay": true, "quickack": true, "busy_poll_usec": 50,
+ *    "priority": 6, "tos": 16, "rcvbuf": 65536, "sndbuf": 65536}
+ */
+void json_parse(Json::Value const& json, SocketProfile& profile);
@@ -4,6 +4,7 @@
 #include <string>
 #include <tuple>
 #include <vector>
+#include "sockopts.h"
 
 
 class TCPSrv;
@@ -22,6 +23,7 @@ class Connection
 private:
     friend class TCPSrv;
     int remote_sock;
+    bool quickack;
 
     Connection(int remotre_sock);
     Connection(Connection const&);
@@ -52,7 +54,14 @@ public:
     std::tuple<int, std::string> read(bool blocking);
     bool alive();
 
+    // underlying socket descriptor, e.g. for epoll; owned by the connection
+    int fd() const;
+
+    // returns the number of options that failed
+    int set_profile(SocketProfile const& profile);
+
     static ConnectionPtr connect(std::string const& ip, int port);
+    static ConnectionPtr connect(std::string const& ip, int port, SocketProfile const& profile);
 };
 
 
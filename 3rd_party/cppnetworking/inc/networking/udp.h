@@ -3,6 +3,7 @@
 #include <string>
 #include <arpa/inet.h>
 #include <memory>
+#include "sockopts.h"
 
 
 class Udp;
@@ -61,6 +62,20 @@ public:
     //   N bytes read
     int read(char* buf, int sz, int64_t wait_interval);
 
+    // wait until a datagram arrives, not more than 'usec'
+    //  returns:
+    //   0 timed out
+    //  -1 failed
+    //   1 data available
+    int wait_for_data(int64_t usec);
+
+    // underlying socket descriptor, e.g. for epoll; owned by the object
+    int fd() const;
+
+    // returns:
+    //  number of options that failed; TCP options are ignored
+    int set_profile(SocketProfile const& profile);
+
     // returns:
     //  description of arose error
     std::string const& status() const;
@@ -0,0 +1,85 @@
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <errno.h>
+#include <string.h>
+
+#include <networking/sockopts.h>
+#include <cppmisc/traces.h>
+
+
+namespace
+{
+    bool is_tcp(int sock)
+    {
+        int protocol = 0;
+        socklen_t len = sizeof(protocol);
+        if (getsockopt(sock, SOL_SOCKET, SO_PROTOCOL, &protocol, &len) < 0)
+            return false;
+        return protocol == IPPROTO_TCP;
+    }
+
+    int set_option(int sock, int level, int name, char const* name_str, int value)
+    {
+        if (setsockopt(sock, level, name, &value, sizeof(value)) < 0)
+        {
+            warn_msg("can't set ", name_str, " to ", value, ": ", strerror(errno));
+            return 1;
+        }
+        return 0;
+    }
+}
+
+int apply_socket_profile(int sock, SocketProfile const& profile)
+{
+    int failed = 0;
+
+    if (is_tcp(sock))
+    {
+        if (profile.nodelay)
+            failed += set_option(sock, IPPROTO_TCP, TCP_NODELAY, "TCP_NODELAY", 1);
+        if (profile.quickack)
+            failed += set_option(sock, IPPROTO_TCP, TCP_QUICKACK, "TCP_QUICKACK", 1);
+    }
+
+    if (profile.busy_poll_usec > 0)
+        failed += set_option(sock, SOL_SOCKET, SO_BUSY_POLL, "SO_BUSY_POLL", profile.busy_poll_usec);
+    if (profile.priority >= 0)
+        failed += set_option(sock, SOL_SOCKET, SO_PRIORITY, "SO_PRIORITY", profile.priority);
+    if (profile.tos >= 0)
+        failed += set_option(sock, IPPROTO_IP, IP_TOS, "IP_TOS", profile.tos);
+    if (profile.rcvbuf > 0)
+        failed += set_option(sock, SOL_SOCKET, SO_RCVBUF, "SO_RCVBUF", profile.rcvbuf);
+    if (profile.sndbuf > 0)
+        failed += set_option(sock, SOL_SOCKET, SO_SNDBUF, "SO_SNDBUF", profile.sndbuf);
+
+    return failed;
+}
+
+void rearm_quickack(int sock)
+{
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+}
+
+void json_parse(Json::Value const& json, SocketProfile& profile)
+{
+    profile = SocketProfile();
+
+    if (json_has(json, "nodelay"))
+        profile.nodelay = json["nodelay"].asBool();
+    if (json_has(json, "quickack"))
+        profile.quickack = json["quickack"].asBool();
+    if (json_has(json, "busy_poll_usec"))
+        json_get(json, "busy_poll_usec", profile.busy_poll_usec);
+    if (json_has(json, "priority"))
+        json_get(json, "priority", profile.priority);
+    if (json_has(json, "tos"))
+        json_get(json, "tos", profile.tos);
+    if (json_has(json, "rcvbuf"))
+        json_get(json, "rcvbuf", profile.rcvbuf);
+    if (json_has(json, "sndbuf"))
+        json_get(json, "sndbuf", profile.sndbuf);
+}
@@ -58,13 +58,14 @@ inline timeval to_timeval(int64_t usec)
 */
 
 Connection::Connection(int remote_sock) : 
-	remote_sock(remote_sock)
+	remote_sock(remote_sock), quickack(false)
 {
 }
 
 Connection::Connection(Connection&& connection)
 {
     remote_sock = connection.remote_sock;
+    quickack = connection.quickack;
     connection.remote_sock = -1;
 }
 
@@ -95,6 +96,17 @@ bool Connection::write(std::vector<uint8_t> const& buf)
     return write(reinterpret_cast<char const*>(buf.data()), buf.size());
 }
 
+int Connection::fd() const
+{
+    return remote_sock;
+}
+
+int Connection::set_profile(SocketProfile const& profile)
+{
+    quickack = profile.quickack;
+    return apply_socket_profile(remote_sock, profile);
+}
+
 int Connection::wait_for_data(int64_t usec){
     fd_set rfds;
     FD_ZERO(&rfds);
@@ -111,6 +123,8 @@ int Connection::read(char* s, int len, bool blocking)
     int status = recv(remote_sock, s, len, flags);
     if (status > 0)
     {
+        if (quickack)
+            rearm_quickack(remote_sock);
         return status;
     }
     else if (status < 0)
@@ -181,6 +195,11 @@ int Connection::read(std::string& buf, bool blocking)
 }
 
 std::shared_ptr<Connection> Connection::connect(std::string const& ip, int port)
+{
+    return connect(ip, port, SocketProfile());
+}
+
+std::shared_ptr<Connection> Connection::connect(std::string const& ip, int port, SocketProfile const& profile)
 {
     dbg_msg("connecting to the server ", ip, ":", port, "..");
     int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
@@ -196,15 +215,16 @@ std::shared_ptr<Connection> Connection::connect(std::string const& ip, int port)
     int syn_retries = 3;
     setsockopt(sock, IPPROTO_TCP, TCP_SYNCNT, &syn_retries, sizeof(syn_retries));
 
+    // buffer sizes have to be set before the handshake to affect the window
+    std::shared_ptr<Connection> connection(new Connection(sock));
+    connection->set_profile(profile);
+
     int res = ::connect(sock, (sockaddr const*)&addr, sizeof(addr));
     if (res < 0)
-    {
-        close(sock);
         throw_runtime_error("can't connect to host '" + ip + ":" + to_string(port) + "'");
-    }
 
     dbg_msg("connected");
-    return std::shared_ptr<Connection>(new Connection(sock));
+    return connection;
 }
 
 
@@ -208,6 +208,33 @@ int Udp::read(char* buf, int sz, int64_t usec)
     }
 }
 
+int Udp::wait_for_data(int64_t usec)
+{
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    FD_SET(_sock, &rfds);
+
+    timeval&& tv = to_timeval(usec);
+
+    int retval = select(_sock + 1, &rfds, nullptr, nullptr, &tv);
+    if (retval < 0)
+    {
+        _status = strerror(errno);
+        return -1;
+    }
+    return retval > 0 ? 1 : 0;
+}
+
+int Udp::fd() const
+{
+    return _sock;
+}
+
+int Udp::set_profile(SocketProfile const& profile)
+{
+    return apply_socket_profile(_sock, profile);
+}
+
 std::string const& Udp::status() const
 {
     return _status;
@@ -0,0 +1,117 @@
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cppmisc/timing.h>
+#include <cppmisc/traces.h>
+#include <networking/tcp.h>
+
+
+/*
+ * Round trip of 32-byte packets over loopback with the default and the
+ * low latency socket profile.
+ *
+ * "ping-pong" sends one packet and waits for the echo. "split" sends the
+ * packet as two writes before waiting, the pattern where Nagle's algorithm
+ * holds back the second write until the delayed ACK of the first arrives.
+ *
+ *   rtt_bench [iterations] [port]
+ */
+
+const int packet_size = 32;
+
+bool read_exact(Connection& c, char* buf, int len)
+{
+    int done = 0;
+    while (done < len)
+    {
+        int n = c.read(buf + done, len - done, true);
+        if (n < 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+void echo_server(TCPSrv& srv, SocketProfile const& profile)
+{
+    auto c = srv.wait_for_connection();
+    if (!c)
+        return;
+    c->set_profile(profile);
+
+    char buf[packet_size];
+    while (read_exact(*c, buf, packet_size))
+    {
+        if (!c->write(buf, packet_size))
+            break;
+    }
+}
+
+ConnectionPtr connect_retry(int port, SocketProfile const& profile)
+{
+    for (int attempt = 0; ; ++ attempt)
+    {
+        try
+        {
+            return Connection::connect("127.0.0.1", port, profile);
+        }
+        catch (std::exception const&)
+        {
+            if (attempt == 100)
+                throw;
+            sleep_usec(10000);
+        }
+    }
+}
+
+void run(char const* name, SocketProfile const& profile, bool split, int iterations, int port)
+{
+    TCPSrv srv(port);
+    std::thread server([&]() { echo_server(srv, profile); });
+
+    std::vector<int64_t> rtt;
+    rtt.reserve(iterations);
+    {
+        auto c = connect_retry(port, profile);
+        char buf[packet_size] = {};
+
+        for (int i = 0; i < iterations; ++ i)
+        {
+            int64_t t0 = monotonic_nsec();
+            if (split)
+            {
+                c->write(buf, 8);
+                c->write(buf + 8, packet_size - 8);
+            }
+            else
+            {
+                c->write(buf, packet_size);
+            }
+            if (!read_exact(*c, buf, packet_size))
+                throw_runtime_error("echo server closed the connection");
+            rtt.push_back(monotonic_nsec() - t0);
+        }
+    }
+
+    server.join();
+
+    std::sort(rtt.begin(), rtt.end());
+    printf("%-28s p50 %9.1f us  p99 %9.1f us  max %9.1f us\n", name,
+        rtt[rtt.size() / 2] * 1e-3, rtt[rtt.size() * 99 / 100] * 1e-3, rtt.back() * 1e-3);
+}
+
+int main(int argc, char const* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    int port = argc > 2 ? atoi(argv[2]) : 12900;
+
+    traces::__enable_dbg = false;
+
+    run("ping-pong, default", SocketProfile(), false, iterations, port);
+    run("ping-pong, low_latency", SocketProfile::low_latency(), false, iterations, port + 1);
+    run("split, default", SocketProfile(), true, iterations, port + 2);
+    run("split, low_latency", SocketProfile::low_latency(), true, iterations, port + 3);
+    return 0;
+}
@@ -2,22 +2,38 @@ import matplotlib.pyplot as plt
 import sys
 import numpy as np
 import re
+sys.path.append('scripts')
+import flight_log
 
 
-with open('log.txt', 'r') as f:
-	data = f.read()
+def load_text_log(path):
+	with open(path, 'r') as f:
+		data = f.read()
 
-prefix = "[inf] [log]"
-regular2 = r"[+-]? *(?:\d+(?:\.\d*)?|\.\d+)(?:[eE][+-]?\d+)?"
-m=[]
-for line in data.split('\n'):
-	if line[:len(prefix)] != prefix:
-		continue
+	prefix = "[inf] [log]"
+	regular2 = r"[+-]? *(?:\d+(?:\.\d*)?|\.\d+)(?:[eE][+-]?\d+)?"
+	m=[]
+	for line in data.split('\n'):
+		if line[:len(prefix)] != prefix:
+			continue
 
-	t,torque,theta,phi,dtheta,dphi,x,y = re.findall(regular2, line)
-	m += [(t,torque,theta,phi,dtheta,dphi,x,y)]
+		t,torque,theta,phi,dtheta,dphi,x,y = re.findall(regular2, line)
+		m += [(t,torque,theta,phi,dtheta,dphi,x,y)]
 
-m = np.array(m, dtype=float)
+	return np.array(m, dtype=float)
+
+
+def load_flight_record(path):
+	r = flight_log.load(path)
+	return np.column_stack([r['t'], r['torque'], r['theta'], r['phi'],
+		r['dtheta'], r['dphi'], r['x'], r['y']])
+
+
+path = sys.argv[1] if len(sys.argv) > 1 else 'flight.bin'
+if path.endswith('.txt'):
+	m = load_text_log(path)
+else:
+	m = load_flight_record(path)
 print(m[:,5][10])
 
 plt.subplot(2, 2, 1)
@@ -0,0 +1,63 @@
+import numpy as np
+import sys
+
+
+'''
+Reader for the binary flight records written by FlightRecorder
+(src/flight_recorder.h). The record layout must be kept in sync with
+struct FlightRecord.
+'''
+
+header_size = 4096
+magic = b'BFLYREC\x00'
+version = 1
+
+header_dtype = np.dtype([
+	('magic', 'S8'),
+	('version', '<u4'),
+	('record_size', '<u4'),
+	('count', '<u8'),
+	('dropped', '<u8'),
+])
+
+record_dtype = np.dtype([
+	('t', '<f8'),
+	('ball_found', '<i4'),
+	('reserved', '<i4'),
+	('theta', '<f8'),
+	('dtheta', '<f8'),
+	('phi', '<f8'),
+	('dphi', '<f8'),
+	('x', '<f8'),
+	('vx', '<f8'),
+	('y', '<f8'),
+	('vy', '<f8'),
+	('torque', '<f8'),
+	('ctrl_tau', '<f8'),
+	('ctrl_y', '<f8'),
+	('ctrl_dy', '<f8'),
+	('ctrl_I', '<f8'),
+	('ctrl_v', '<f8'),
+	('ctrl_u', '<f8'),
+])
+
+
+def load(path):
+	'''
+	returns a numpy structured array with one element per control tick
+	'''
+	hdr = np.fromfile(path, dtype=header_dtype, count=1)[0]
+	if hdr['magic'] != magic.rstrip(b'\x00'):
+		raise ValueError('%s is not a flight record' % path)
+	if hdr['version'] != version:
+		raise ValueError('unsupported flight record version %d' % hdr['version'])
+	if hdr['record_size'] != record_dtype.itemsize:
+		raise ValueError('unexpected record size %d' % hdr['record_size'])
+
+	count = int(hdr['count'])
+	return np.fromfile(path, dtype=record_dtype, count=count, offset=header_size)
+
+
+if __name__ == '__main__':
+	m = load(sys.argv[1])
+	print('%d records, %.3fs' % (len(m), m['t'][-1] - m['t'][0] if len(m) else 0))
@@ -1,6 +1,8 @@
 #include "butterfly.h"
 #include "filters.h"
+#include "event_loop.h"
 #include "string.h"
+#include <cppmisc/signals.h>
 
 using namespace std;
 
@@ -76,10 +78,25 @@ Butterfly::Butterfly()
     m_dphi = 0;
     m_stop = false;
     m_ball_found = false;
+    m_io_mode = io_inline;
+    m_read_latest = false;
+    m_io_wait_usec = 10000;
+    m_poll_usec = 100;
+    m_servo_timeout_usec = 100000;
+    m_period_usec = 0;
+    m_spin_usec = 0;
+    m_latency_enabled = true;
+    m_prev_tick_nsec = 0;
+    m_dump_latency = false;
+    m_t0 = 0;
+    m_servo_version = 0;
+    m_camera_version = 0;
 }
 
 Butterfly::~Butterfly()
 {
+    m_stop = true;
+    stop_io_threads();
 }
 
 void Butterfly::init(Json::Value const& cfg, Json::Value const& jsfbcfg)
@@ -91,8 +108,78 @@ void Butterfly::init(Json::Value const& cfg, Json::Value const& jsfbcfg)
 
     auto const& butcfg = json_get(cfg, "controller");
 
+    if (json_has(butcfg, "io_mode"))
+    {
+        auto io_mode = json_get<std::string>(butcfg, "io_mode");
+        if (io_mode == "inline")
+            m_io_mode = io_inline;
+        else if (io_mode == "threaded")
+            m_io_mode = io_threaded;
+        else if (io_mode == "epoll")
+            m_io_mode = io_epoll;
+        else
+            throw_runtime_error("unknown controller io_mode: ", io_mode);
+    }
+
+    if (json_has(butcfg, "read_mode"))
+    {
+        auto read_mode = json_get<std::string>(butcfg, "read_mode");
+        if (read_mode == "sequential")
+            m_read_latest = false;
+        else if (read_mode == "freshest")
+            m_read_latest = true;
+        else
+            throw_runtime_error("unknown controller read_mode: ", read_mode);
+    }
+
+    if (json_has(butcfg, "poll_usec"))
+        json_get(butcfg, "poll_usec", m_poll_usec);
+
+    if (json_has(butcfg, "servo_timeout_usec"))
+        json_get(butcfg, "servo_timeout_usec", m_servo_timeout_usec);
+
+    if (json_has(butcfg, "rate_hz"))
+    {
+        double rate_hz = json_get<double>(butcfg, "rate_hz");
+        if (rate_hz <= 0)
+            throw_runtime_error("controller rate_hz must be positive");
+        if (m_io_mode != io_threaded)
+            throw_runtime_error("controller rate_hz requires \"io_mode\": \"threaded\"");
+        m_period_usec = int64_t(1e+6 / rate_hz + 0.5);
+        if (m_period_usec <= 0)
+            throw_runtime_error("controller rate_hz ", rate_hz, " is above the 1us scheduler resolution");
+    }
+
+    if (json_has(butcfg, "spin_usec"))
+        json_get(butcfg, "spin_usec", m_spin_usec);
+
+    if (json_has(butcfg, "latency_stats"))
+        m_latency_enabled = butcfg["latency_stats"].asBool();
+
+    if (json_has(butcfg, "flight_recorder"))
+    {
+        auto const& reccfg = json_get(butcfg, "flight_recorder");
+        auto path = json_get<std::string>(reccfg, "path");
+        int capacity = 65536;
+        if (json_has(reccfg, "capacity"))
+            json_get(reccfg, "capacity", capacity);
+        m_recorder.reset(new FlightRecorder(path, capacity));
+    }
+
+    if (json_has(butcfg, "rt"))
+        m_rt.init(json_get(butcfg, "rt"));
+
+    if (m_io_mode == io_epoll)
+    {
+        m_loop.reset(new EventLoop());
+        m_loop->add_timer(ev_deadline);
+        m_loop->add_wakeup(ev_wakeup);
+    }
+
     m_servo = ServoIfc::capture_instance();
     m_servo->init(cfg);
+    if (m_servo->uses_uring() && m_io_mode == io_threaded)
+        throw_runtime_error("servo io_backend uring requires \"io_mode\": \"inline\" or \"epoll\"");
 
     m_camera = Camera::capture_instance();
     m_camera->init(cfg);
@@ -105,22 +192,43 @@ void wait_for_camera_ready()
 
 }
 
-void Butterfly::measure()
+void Butterfly::read_servo(ServoSample& sample)
 {
-    int64_t t_servo;
-    int status = m_servo->get_state(t_servo, m_theta, m_dtheta, true);
+    int status = m_read_latest ?
+        m_servo->get_latest_state(sample.t, sample.theta, sample.dtheta, true) :
+        m_servo->get_state(sample.t, sample.theta, sample.dtheta, true);
     if (status < 0)
         throw_runtime_error("servo disconnected");
+}
+
+void Butterfly::read_camera(CameraSample& sample)
+{
+    sample.status = m_read_latest ?
+        m_camera->get_latest(sample.t, sample.x, sample.y) :
+        m_camera->get(sample.t, sample.x, sample.y);
+    if (sample.status == 1)
+    {
+        sample.vx = m_diff_x.process(sample.t, sample.x);
+        sample.vy = m_diff_y.process(sample.t, sample.y);
+    }
+}
 
-    int64_t t_cam;
-    status = m_camera->get(t_cam, m_x, m_y);
+void Butterfly::update_servo(ServoSample const& sample)
+{
+    m_theta = sample.theta;
+    m_dtheta = sample.dtheta;
+}
 
-    switch (status)
+void Butterfly::update_camera(CameraSample const& sample)
+{
+    switch (sample.status)
     {
     case 1:
     {
-        m_vx = m_diff_x.process(t_cam, m_x);
-        m_vy = m_diff_y.process(t_cam, m_y);
+        m_x = sample.x;
+        m_y = sample.y;
+        m_vx = sample.vx;
+        m_vy = sample.vy;
 
         double alpha = atan2(m_x, m_y);
         double dalpha = (m_y * m_vx - m_x * m_vy) / (m_x * m_x + m_y * m_y);
@@ -144,9 +252,152 @@ void Butterfly::measure()
     }
 }
 
+/*
+ * returns false if there is no new servo state yet (threaded mode only)
+ */
+bool Butterfly::measure()
+{
+    if (m_io_mode == io_threaded)
+        return fetch_snapshot(true);
+
+    int64_t t_begin = stamp();
+    ServoSample servo;
+    read_servo(servo);
+    record(stage_servo_read, t_begin);
+    update_servo(servo);
+
+    t_begin = stamp();
+    CameraSample cam;
+    read_camera(cam);
+    record(stage_camera_read, t_begin);
+    update_camera(cam);
+    return true;
+}
+
+/*
+ * returns true if a new servo state was taken; with require_servo the
+ * camera is not consumed until the servo state is updated
+ */
+bool Butterfly::fetch_snapshot(bool require_servo)
+{
+    ServoSample servo;
+    uint32_t version = m_servo_slot.load(servo);
+    bool servo_updated = version != m_servo_version;
+
+    if (!servo_updated && require_servo)
+        return false;
+
+    if (servo_updated)
+    {
+        m_servo_version = version;
+        update_servo(servo);
+    }
+
+    CameraSample cam;
+    version = m_camera_slot.load(cam);
+    if (version != m_camera_version)
+    {
+        m_camera_version = version;
+        update_camera(cam);
+    }
+
+    return servo_updated;
+}
+
+// both reader threads may fail at once; the first error is kept
+void Butterfly::io_failed(std::exception_ptr error)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_io_error_mutex);
+        if (!m_io_error)
+            m_io_error = error;
+    }
+    m_stop = true;
+}
+
+void Butterfly::servo_loop()
+{
+    m_rt.apply_io_thread("servo");
+
+    try
+    {
+        while (!m_stop)
+        {
+            int status = m_servo->wait_for_data(m_io_wait_usec);
+            if (status < 0)
+                throw_runtime_error("servo disconnected");
+            if (status == 0)
+            {
+                m_servo->keep_safe();
+                continue;
+            }
+
+            int64_t t_begin = stamp();
+            ServoSample sample;
+            read_servo(sample);
+            record(stage_servo_read, t_begin);
+            m_servo_slot.store(sample);
+        }
+    }
+    catch (...)
+    {
+        io_failed(std::current_exception());
+    }
+
+    m_rt.report_thread_usage("servo");
+}
+
+void Butterfly::camera_loop()
+{
+    m_rt.apply_io_thread("camera");
+
+    try
+    {
+        while (!m_stop)
+        {
+            int64_t t_begin = stamp();
+            CameraSample sample;
+            read_camera(sample);
+
+            if (sample.status == 0)
+            {
+                if (m_camera->wait_for_data(m_io_wait_usec) < 0)
+                    throw_runtime_error("camera disconnected");
+                continue;
+            }
+
+            record(stage_camera_read, t_begin);
+            m_camera_slot.store(sample);
+        }
+    }
+    catch (...)
+    {
+        io_failed(std::current_exception());
+    }
+
+    m_rt.report_thread_usage("camera");
+}
+
+void Butterfly::start_io_threads()
+{
+    m_servo_thread = std::thread(&Butterfly::servo_loop, this);
+    m_camera_thread = std::thread(&Butterfly::camera_loop, this);
+}
+
+void Butterfly::stop_io_threads()
+{
+    if (m_servo_thread.joinable())
+        m_servo_thread.join();
+    if (m_camera_thread.joinable())
+        m_camera_thread.join();
+}
+
+// called from the signal handlers
 void Butterfly::stop()
 {
     m_stop = true;
+    if (m_loop)
+        m_loop->wake();
 }
 
 void Butterfly::get_signals(int64_t const& t, BflySignals& signals)
@@ -162,6 +413,193 @@ void Butterfly::get_signals(int64_t const& t, BflySignals& signals)
     signals.y = m_y;
     signals.vy = m_vy;
     signals.torque = 0;
+    memset(&signals.ctrl, 0, sizeof(signals.ctrl));
+}
+
+static void to_flight_record(BflySignals const& signals, FlightRecord& record)
+{
+    record.t = signals.t;
+    record.ball_found = signals.ball_found;
+    record.reserved = 0;
+    record.theta = signals.theta;
+    record.dtheta = signals.dtheta;
+    record.phi = signals.phi;
+    record.dphi = signals.dphi;
+    record.x = signals.x;
+    record.vx = signals.vx;
+    record.y = signals.y;
+    record.vy = signals.vy;
+    record.torque = signals.torque;
+    record.ctrl_tau = signals.ctrl.tau;
+    record.ctrl_y = signals.ctrl.y;
+    record.ctrl_dy = signals.ctrl.dy;
+    record.ctrl_I = signals.ctrl.I;
+    record.ctrl_v = signals.ctrl.v;
+    record.ctrl_u = signals.ctrl.u;
+}
+
+void Butterfly::dump_latency() const
+{
+    static char const* names[nstages] = {
+        "servo read", "camera read", "callback", "set torque", "period"
+    };
+
+    for (int i = 0; i < nstages; ++ i)
+        m_latency[i].dump(names[i]);
+}
+
+void Butterfly::control_step(callback_t const& cb, int64_t t)
+{
+    int64_t t_begin = stamp();
+    if (m_latency_enabled)
+    {
+        if (m_prev_tick_nsec != 0)
+            m_latency[stage_period].record(t_begin - m_prev_tick_nsec);
+        m_prev_tick_nsec = t_begin;
+    }
+
+    BflySignals signals;
+    get_signals(t - m_t0, signals);
+
+    // attention dirty
+    bool status = cb(signals, fbcfg);
+    record(stage_callback, t_begin);
+
+    if (!status)
+        m_stop = true;
+
+    t_begin = stamp();
+    m_servo->set_torque(signals.torque);
+    record(stage_set_torque, t_begin);
+
+    if (m_recorder)
+    {
+        FlightRecord rec;
+        to_flight_record(signals, rec);
+        m_recorder->push(rec);
+    }
+
+    if (m_dump_latency.exchange(false))
+        dump_latency();
+}
+
+void Butterfly::polling_loop(callback_t const& cb)
+{
+    while (!m_stop)
+    {
+        int64_t t = epoch_usec();
+        if (!measure())
+        {
+            sleep_usec(m_poll_usec);
+            continue;
+        }
+
+        control_step(cb, t);
+    }
+}
+
+/*
+ * Control steps are made at the configured rate independently of the
+ * device packet rates; each step takes the latest published snapshot.
+ */
+void Butterfly::scheduled_loop(callback_t const& cb)
+{
+    PeriodicScheduler scheduler(m_period_usec, m_spin_usec);
+
+    while (!m_stop)
+    {
+        scheduler.wait();
+        int64_t t = epoch_usec();
+        fetch_snapshot(false);
+
+        // nothing to control until the first servo state arrives
+        if (m_servo_version == 0)
+            continue;
+
+        control_step(cb, t);
+    }
+
+    info_msg("scheduler: ", scheduler.ticks(), " ticks, ",
+        scheduler.overruns(), " overruns, ",
+        scheduler.skipped(), " skipped periods, max lateness ",
+        scheduler.max_lateness_usec(), "us");
+}
+
+/*
+ * The loop sleeps in epoll_wait until a device socket becomes readable, the
+ * servo deadline expires or stop() is called. A control step is made
+ * for every servo state; camera packets are consumed as soon as they come,
+ * before the servo state of the same wakeup is handled.
+ *
+ * Signals stay with the SysSignals handlers, whichever thread gets them;
+ * stop() wakes the loop through an eventfd. The device descriptors leave
+ * the epoll set when the devices close them.
+ */
+void Butterfly::event_loop(callback_t const& cb)
+{
+    EventLoop& loop = *m_loop;
+    loop.add_fd(m_servo->fd(), ev_servo);
+    loop.add_fd(m_camera->fd(), ev_camera);
+    loop.arm_timer(m_servo_timeout_usec);
+
+    EventLoop::Event events[EventLoop::max_events];
+
+    while (!m_stop)
+    {
+        int n = loop.wait(events);
+        bool servo_ready = false;
+
+        for (int i = 0; i < n; ++ i)
+        {
+            switch (events[i].id)
+            {
+            case ev_servo:
+                if (events[i].error)
+                    throw_runtime_error("servo disconnected");
+                servo_ready = true;
+                break;
+
+            case ev_camera:
+            {
+                if (events[i].error)
+                    throw_runtime_error("camera disconnected");
+
+                int64_t t_begin = stamp();
+                CameraSample cam;
+                read_camera(cam);
+                while (cam.status != 0)
+                {
+                    update_camera(cam);
+                    read_camera(cam);
+                }
+                record(stage_camera_read, t_begin);
+                break;
+            }
+
+            case ev_deadline:
+                loop.ack_timer();
+                err_msg("no servo state within ", m_servo_timeout_usec, "us");
+                m_stop = true;
+                break;
+
+            case ev_wakeup:
+                loop.ack_wakeup();
+                break;
+            }
+        }
+
+        if (servo_ready && !m_stop)
+        {
+            int64_t t = epoch_usec();
+            int64_t t_begin = stamp();
+            ServoSample servo;
+            read_servo(servo);
+            record(stage_servo_read, t_begin);
+            update_servo(servo);
+            loop.arm_timer(m_servo_timeout_usec);
+            control_step(cb, t);
+        }
+    }
 }
 
 void Butterfly::start(callback_t const& cb)
@@ -169,32 +607,47 @@ void Butterfly::start(callback_t const& cb)
     if (!m_camera || !m_servo)
         throw_runtime_error("Butterfly not initialized yet");
 
+    m_rt.apply_process();
     m_camera->start();
     m_servo->start();
 
-    int status;
-    int64_t t, t0;
-    t0 = epoch_usec();
-
-    while (!m_stop)
-    {
-        t = epoch_usec();
-        measure();
+    SysSignals::instance().set_sigusr1_handler([this]() { m_dump_latency = true; });
 
-        BflySignals signals;
-        get_signals(t - t0, signals);
+    if (m_io_mode == io_threaded)
+        start_io_threads();
 
-        // attention dirty
-        status = cb(signals, fbcfg);
-            
-        if (!status)
-            m_stop = true;
+    m_rt.apply_control_thread();
+    m_t0 = epoch_usec();
 
-        m_servo->set_torque(signals.torque);
-    }
+    if (m_io_mode == io_epoll)
+        event_loop(cb);
+    else if (m_period_usec > 0)
+        scheduled_loop(cb);
+    else
+        polling_loop(cb);
 
+    m_rt.report_thread_usage("control");
+    stop_io_threads();
     m_servo->stop();
     m_camera->stop();
 
+    if (m_latency_enabled)
+        dump_latency();
+
+    if (m_read_latest)
+        info_msg("skipped stale samples: servo ", m_servo->skipped(), ", camera ", m_camera->skipped());
+
+    if (m_servo->lost() > 0 || m_servo->late() > 0)
+        warn_msg("servo packets: ", m_servo->lost(), " lost, ", m_servo->late(), " late");
+
+    if (m_servo->safe_torques() > 0)
+        warn_msg("servo: ", m_servo->safe_torques(), " torque commands replaced by zero because of stale state");
+
+    if (m_recorder)
+        m_recorder->close();
+
+    if (m_io_error)
+        std::rethrow_exception(m_io_error);
+
     info_msg("stopped");
 }
@@ -2,12 +2,23 @@
 
 #include <memory>
 #include <stdexcept>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <functional>
 #include <cppmisc/json.h>
 #include <vector>
 #include "filters.h"
+#include "seqlock.h"
+#include "latency_histogram.h"
+#include "flight_recorder.h"
+#include "rt_setup.h"
 #include "servo_iface.h"
 #include "cam_iface.h"
 
+class EventLoop;
+
 class FeedbackConfig{
 public:
     void fill_from_parse(Json::Value const& jsfbcfg);
@@ -31,6 +42,19 @@ public:
     int k_k;
 };
 
+/*
+ * controller internals for the flight recorder; filled by the callback
+ */
+struct ControllerTrace
+{
+    double tau;     // phase of the reference trajectory
+    double y;       // transverse coordinates
+    double dy;
+    double I;
+    double v;       // stabilizing feedback
+    double u;       // torque before saturation
+};
+
 struct BflySignals
 {
     bool ball_found;
@@ -44,11 +68,52 @@ struct BflySignals
     double y;
     double vy;
     double torque;
+    ControllerTrace ctrl;
+};
+
+struct ServoSample
+{
+    int64_t t;
+    double theta;
+    double dtheta;
+};
+
+struct CameraSample
+{
+    int status; // as returned by Camera::get
+    int64_t t;
+    double x;
+    double y;
+    double vx;
+    double vy;
 };
 
 class Butterfly
 {
+public:
+    typedef std::function<bool(BflySignals&, FeedbackConfig&)> callback_t;
+
 private:
+    enum io_mode_t
+    {
+        io_inline,      // servo and camera are read by the control loop
+        io_threaded,    // every device has its own reader thread
+        io_epoll        // single thread woken by device sockets, a deadline timer and stop()
+    };
+
+    // sources of the epoll loop
+    enum { ev_servo, ev_camera, ev_deadline, ev_wakeup };
+
+    enum stage_t
+    {
+        stage_servo_read,
+        stage_camera_read,
+        stage_callback,
+        stage_set_torque,
+        stage_period,       // tick to tick interval
+        nstages
+    };
+
     std::shared_ptr<ServoIfc> m_servo;
     std::shared_ptr<Camera> m_camera;
 
@@ -59,15 +124,70 @@ private:
     double      m_x, m_y;
     double      m_vx, m_vy;
     double      m_phi, m_dphi;
-    bool        m_stop;
+    std::atomic<bool> m_stop;
     bool        m_ball_found;
 
-    void measure();
+    io_mode_t   m_io_mode;
+    bool        m_read_latest;      // drain the sockets and keep the newest sample only
+    int64_t     m_io_wait_usec;
+    int64_t     m_poll_usec;
+    int64_t     m_servo_timeout_usec;
+    int64_t     m_period_usec;      // fixed control period; 0 means paced by the servo
+    int64_t     m_spin_usec;
+    int64_t     m_t0;
+
+    SeqLock<ServoSample>    m_servo_slot;
+    SeqLock<CameraSample>   m_camera_slot;
+    uint32_t                m_servo_version;
+    uint32_t                m_camera_version;
+    std::thread             m_servo_thread;
+    std::thread             m_camera_thread;
+    std::mutex              m_io_error_mutex;
+    std::exception_ptr      m_io_error;         // the first error of the reader threads
+
+    bool                    m_latency_enabled;
+    LatencyHistogram        m_latency[nstages];
+    int64_t                 m_prev_tick_nsec;
+    std::atomic<bool>       m_dump_latency;
+
+    std::unique_ptr<FlightRecorder> m_recorder;
+    std::unique_ptr<EventLoop>      m_loop;     // of io_mode epoll; stop() wakes it
+    RtSetup                 m_rt;
+
+    void read_servo(ServoSample& sample);
+    void read_camera(CameraSample& sample);
+    void update_servo(ServoSample const& sample);
+    void update_camera(CameraSample const& sample);
+
+    bool measure();
+    bool fetch_snapshot(bool require_servo);
+    void io_failed(std::exception_ptr error);
+    void servo_loop();
+    void camera_loop();
+    void start_io_threads();
+    void stop_io_threads();
+
+    void control_step(callback_t const& cb, int64_t t);
+    void polling_loop(callback_t const& cb);
+    void scheduled_loop(callback_t const& cb);
+    void event_loop(callback_t const& cb);
+
     void get_signals(int64_t const& t, BflySignals& signals);
 
-public:
-    typedef std::function<bool(BflySignals&, FeedbackConfig&)> callback_t;
+    inline int64_t stamp() const
+    {
+        return m_latency_enabled ? monotonic_nsec() : 0;
+    }
+
+    inline void record(stage_t stage, int64_t t_begin)
+    {
+        if (m_latency_enabled)
+            m_latency[stage].record(monotonic_nsec() - t_begin);
+    }
 
+    void dump_latency() const;
+
+public:
     FeedbackConfig fbcfg;
 
     Butterfly();
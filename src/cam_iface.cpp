@@ -5,12 +5,16 @@
 #include "device_manager.h"
 
 using namespace std;
+using namespace ser::literals;
 
 
 Camera::Camera()
 {
     host = "";
     port = 0;
+    shm_timeout_usec = 500000;
+    skipped_count = 0;
+    use_uring = false;
 }
 
 Camera::~Camera()
@@ -20,32 +24,164 @@ Camera::~Camera()
 void Camera::init(Json::Value const& jscfg)
 {
     auto const& jscam = json_get(jscfg, "camera");
+
+    // a camera server on the same host can write to shared memory instead
+    if (json_has(jscam, "shm"))
+    {
+        json_get<std::string>(jscam, "shm", shm_name);
+        if (json_has(jscam, "shm_timeout_usec"))
+            json_get(jscam, "shm_timeout_usec", shm_timeout_usec);
+        return;
+    }
+
     json_get<std::string>(jscam, "ip", host);
     json_get(jscam, "port", port);
+    if (json_has(jscam, "socket"))
+        json_get(jscam, "socket", socket_profile);
+
+    std::string io_backend = "socket";
+    if (json_has(jscam, "io_backend"))
+        json_get(jscam, "io_backend", io_backend);
+    if (io_backend != "socket" && io_backend != "uring")
+        throw_runtime_error("unknown camera io_backend ", io_backend);
+    use_uring = io_backend == "uring";
 }
 
 void Camera::start()
 {
+    if (!shm_name.empty())
+    {
+        auto shm = ShmRing::open(shm_name);
+        ring = shm;
+        decoder.reset();
+        con_reader = ser::make_pack_reader([shm](char* p, int n) {
+            return shm->read(p, n);
+        });
+        return;
+    }
+
     if (host.empty())
         throw_runtime_error("camera is not initialized yet; run init(...)");
 
-    auto cnct = Connection::connect(host, port);
-    con_reader = ser::make_pack_reader([cnct](char* p, int n) {
-        if (!cnct)
-            return -1;
-        return cnct->read(p, n, false);
-    });
-    char buf[1024];
-    int len = ser::pack(buf, sizeof(buf), 
-        "ts", epoch_usec(), 
-        "cmd", "start"
+    auto cnct = Connection::connect(host, port, socket_profile);
+    connection = cnct;
+    decoder.reset();
+
+    if (use_uring && cnct)
+    {
+        auto io = std::make_shared<UringIo>(cnct->fd());
+        uring = io;
+        con_reader = ser::make_pack_reader([io, cnct](char* p, int n) {
+            return io->read(p, n, false);
+        });
+    }
+    else
+    {
+        con_reader = ser::make_pack_reader([cnct](char* p, int n) {
+            if (!cnct)
+                return -1;
+            return cnct->read(p, n, false);
+        });
+    }
+
+    auto io = uring;
+    auto writer = [&cnct, &io](char const* p, int n) {
+        bool ok = io ? io->write(p, n) : cnct->write(p, n);
+        return ok ? n : -1;
+    };
+    int status = ser::send_pack(writer,
+        "ts"_h, epoch_usec(),
+        "cmd"_h, "start"
     );
-    cnct->write(buf, len);
+    if (status <= 0)
+        throw_runtime_error("can't send the start command to camera");
 }
 
 void Camera::stop()
 {
     con_reader = nullptr;
+    uring = nullptr;
+    connection = nullptr;
+    ring = nullptr;
+}
+
+int Camera::fd() const
+{
+    if (ring)
+        throw_runtime_error("camera reads shared memory, it has no descriptor to poll");
+    if (!connection)
+        throw_runtime_error("not connected to cumera; call run();");
+    return uring ? uring->fd() : connection->fd();
+}
+
+int Camera::wait_for_data(int64_t usec)
+{
+    if (ring)
+        return ring->wait_for_data(usec);
+    if (!connection)
+        throw_runtime_error("not connected to cumera; call run();");
+
+    int status = uring ? uring->wait_for_data(usec) : connection->wait_for_data(usec);
+    if (status < 0)
+        return -1;
+    return status > 0 ? 1 : 0;
+}
+
+namespace
+{
+    typedef SER_KEY("good") key_good;
+    typedef SER_KEY("x") key_x;
+    typedef SER_KEY("y") key_y;
+    typedef SER_KEY("ts") key_ts;
+
+    // the order the camera server packs a measurement in
+    typedef ser::layout<key_ts, key_good, key_x, key_y> measurement_layout;
+
+    // generic path for packets the decoder can't take, e.g. without x and y
+    int parse_measurement(ser::PacketView const& pack, int64_t& ts_usec, double& x, double& y)
+    {
+        bool good;
+        int status = pack.get(measurement_layout(), key_good(), good);
+        if (status <= 0)
+            throw_runtime_error("camera data corrupted");
+
+        if (!good)
+            return -1;
+
+        status = pack.get(measurement_layout(), key_x(), x, key_y(), y, key_ts(), ts_usec);
+        if (status <= 0)
+            throw_runtime_error("camera data corrupted");
+
+        return 1;
+    }
+
+    int decode_measurement(ser::MessageDecoder<CameraMeasurement>& decoder, ser::PacketRef const& ref,
+        int64_t& ts_usec, double& x, double& y)
+    {
+        CameraMeasurement m;
+        if (decoder.decode(ref, m) > 0)
+        {
+            if (!m.good)
+                return -1;
+            ts_usec = m.ts;
+            x = m.x;
+            y = m.y;
+            return 1;
+        }
+
+        ser::PacketView pack;
+        if (pack.parse(ref.data, ref.size) <= 0)
+            throw_runtime_error("camera data corrupted");
+        return parse_measurement(pack, ts_usec, x, y);
+    }
+}
+
+// the shared memory has no connection to lose; a producer that is gone
+// counts as one that closed it
+void Camera::check_producer() const
+{
+    if (ring && !ring->producer_alive(shm_timeout_usec))
+        throw_runtime_error("connection closed: camera server left the shared memory ring");
 }
 
 int Camera::get(int64_t& ts_usec, double& x, double& y)
@@ -53,27 +189,44 @@ int Camera::get(int64_t& ts_usec, double& x, double& y)
     if (!con_reader)
         throw_runtime_error("not connected to cumera; call run();");
 
-    ser::Packet pack;
+    ser::PacketRef pack;
     int status = con_reader->fetch_next(pack);
     if (status < 0)
         throw_runtime_error("connection closed");
 
     if (status == 0)
+    {
+        check_producer();
         return 0;
+    }
 
-    bool good;
-    status = pack.get("good", good);
-    if (status <= 0)
-        throw_runtime_error("camera data corrupted");
+    return decode_measurement(decoder, pack, ts_usec, x, y);
+}
 
-    if (!good)
-        return -1;
+int Camera::get_latest(int64_t& ts_usec, double& x, double& y)
+{
+    if (!con_reader)
+        throw_runtime_error("not connected to cumera; call run();");
 
-    status = pack.get("x", x, "y", y, "ts", ts_usec);
-    if (status <= 0)
-        throw_runtime_error("camera data corrupted");
+    ser::PacketRef pack;
+    int skipped;
+    int status = con_reader->fetch_latest(pack, skipped);
+    if (status < 0)
+        throw_runtime_error("connection closed");
 
-    return 1;
+    skipped_count += skipped;
+    if (status == 0)
+    {
+        check_producer();
+        return 0;
+    }
+
+    return decode_measurement(decoder, pack, ts_usec, x, y);
+}
+
+uint64_t Camera::skipped() const
+{
+    return skipped_count;
 }
 
 shared_ptr<Camera> Camera::capture_instance()
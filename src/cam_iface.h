@@ -4,17 +4,51 @@
 #include <memory>
 #include <networking/tcp.h>
 #include <cppmisc/json.h>
-#include "serializer.h"
+#include "ser_message.h"
+#include "shm_ring.h"
+#include "uring_io.h"
+
+
+/*
+ * A ball measurement as the camera server sends it when the ball is found;
+ * without the ball the packet may carry only ts and good
+ */
+struct CameraMeasurement
+{
+    int64_t ts;
+    bool    good;
+    double  x;
+    double  y;
+
+    template <typename V>
+    void fields(V& v)
+    {
+        v(SER_KEY("ts")(), ts);
+        v(SER_KEY("good")(), good);
+        v(SER_KEY("x")(), x);
+        v(SER_KEY("y")(), y);
+    }
+};
 
 
 class Camera
 {
 private:
     ser::PacketReaderPtr con_reader;
+    ConnectionPtr   connection;
+    ShmRingPtr      ring;
+    UringIoPtr      uring;
+    bool            use_uring;
     std::string     host;
+    std::string     shm_name;
     int             port;
+    int64_t         shm_timeout_usec;   // of the producer heartbeat, 0 to wait forever
+    SocketProfile   socket_profile;
+    uint64_t        skipped_count;
+    ser::MessageDecoder<CameraMeasurement> decoder;
 
     Camera();
+    void check_producer() const;
     Camera(Camera const&) = delete;
 
 public:
@@ -27,6 +61,22 @@ public:
     // -1 -- ball wasn't detected
     int get(int64_t& ts_usec, double& x, double& y);
 
+    // same as get, but drains all buffered measurements and returns
+    // the newest one; the older ones are counted in skipped()
+    int get_latest(int64_t& ts_usec, double& x, double& y);
+    uint64_t skipped() const;
+
+    // wait until the camera socket becomes readable
+    // 1 -- data available
+    // 0 -- timed out
+    // -1 -- failed
+    int wait_for_data(int64_t usec);
+
+    // socket descriptor of the camera connection, the io_uring one with
+    // "io_backend": "uring"; there is none when the measurements come
+    // through shared memory
+    int fd() const;
+
     void start();
     void stop();
 
@@ -0,0 +1,129 @@
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <cppmisc/throws.h>
+#include <cppmisc/misc.h>
+#include "event_loop.h"
+
+
+EventLoop::EventLoop() :
+    m_timer(-1),
+    m_wakeup(-1)
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+        throw_runtime_error("epoll_create1 failed: ", strerror(errno));
+}
+
+EventLoop::~EventLoop()
+{
+    if (m_wakeup >= 0)
+        close(m_wakeup);
+
+    if (m_timer >= 0)
+        close(m_timer);
+
+    close(m_epoll);
+}
+
+void EventLoop::add(int fd, int id)
+{
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = uint32_t(id);
+
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+        throw_runtime_error("epoll_ctl failed for fd ", fd, ": ", strerror(errno));
+}
+
+void EventLoop::add_fd(int fd, int id)
+{
+    if (fd < 0)
+        throw_runtime_error("can't add invalid descriptor to event loop");
+
+    add(fd, id);
+}
+
+void EventLoop::add_timer(int id)
+{
+    if (m_timer >= 0)
+        throw_runtime_error("event loop timer is already added");
+
+    m_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_timer < 0)
+        throw_runtime_error("timerfd_create failed: ", strerror(errno));
+
+    add(m_timer, id);
+}
+
+void EventLoop::arm_timer(int64_t usec)
+{
+    itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = usec / 1000000;
+    spec.it_value.tv_nsec = (usec % 1000000) * 1000;
+
+    if (timerfd_settime(m_timer, 0, &spec, nullptr) < 0)
+        throw_runtime_error("timerfd_settime failed: ", strerror(errno));
+}
+
+uint64_t EventLoop::ack_timer()
+{
+    uint64_t expirations = 0;
+    int status = read(m_timer, &expirations, sizeof(expirations));
+    if (status != sizeof(expirations))
+        return 0;
+    return expirations;
+}
+
+void EventLoop::add_wakeup(int id)
+{
+    if (m_wakeup >= 0)
+        throw_runtime_error("event loop wakeup is already added");
+
+    m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeup < 0)
+        throw_runtime_error("eventfd failed: ", strerror(errno));
+
+    add(m_wakeup, id);
+}
+
+void EventLoop::wake()
+{
+    uint64_t one = 1;
+    int status = write(m_wakeup, &one, sizeof(one));
+    unused(status);
+}
+
+void EventLoop::ack_wakeup()
+{
+    uint64_t count;
+    int status = read(m_wakeup, &count, sizeof(count));
+    unused(status);
+}
+
+int EventLoop::wait(Event (&events)[max_events], int64_t timeout_usec)
+{
+    epoll_event evs[max_events];
+    int timeout_msec = timeout_usec < 0 ? -1 : int((timeout_usec + 999) / 1000);
+
+    int n = epoll_wait(m_epoll, evs, max_events, timeout_msec);
+    if (n < 0)
+    {
+        if (errno == EINTR)
+            return 0;
+        throw_runtime_error("epoll_wait failed: ", strerror(errno));
+    }
+
+    for (int i = 0; i < n; ++ i)
+    {
+        events[i].id = int(evs[i].data.u32);
+        events[i].error = (evs[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+    }
+
+    return n;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+
+/*
+ * Thin wrapper over epoll with timerfd and eventfd sources
+ *
+ * Every source is registered with a user defined id that is reported back
+ * by wait(). Descriptors added with add_fd() are not owned by the loop;
+ * the timer and wakeup descriptors are.
+ */
+class EventLoop
+{
+private:
+    int         m_epoll;
+    int         m_timer;
+    int         m_wakeup;
+
+    EventLoop(EventLoop const&) = delete;
+
+    void add(int fd, int id);
+
+public:
+    static const int max_events = 8;
+
+    struct Event
+    {
+        int id;
+        bool error;     // hangup or error condition on the descriptor
+    };
+
+    EventLoop();
+    ~EventLoop();
+
+    // wake up when fd becomes readable
+    void add_fd(int fd, int id);
+
+    // one-shot deadline; re-arm it with arm_timer()
+    void add_timer(int id);
+    void arm_timer(int64_t usec);
+    // returns the number of expirations since the last call
+    uint64_t ack_timer();
+
+    /*
+     * wake() makes the wakeup source readable. It is async-signal-safe, so
+     * a signal handler running on any thread can interrupt wait()
+     */
+    void add_wakeup(int id);
+    void wake();
+    void ack_wakeup();
+
+    /*
+     * returns the number of events written to events[]
+     * 0 if timed out; timeout_usec < 0 waits infinitely
+     */
+    int wait(Event (&events)[max_events], int64_t timeout_usec = -1);
+};
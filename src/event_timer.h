@@ -1,6 +1,11 @@
+#pragma once
+
 #include <functional>
 #include <thread>
 #include <memory>
+#include <atomic>
+#include <cppmisc/timing.h>
+#include <cppmisc/traces.h>
 
 
 
@@ -12,14 +17,13 @@ private:
     enum state_t { active, stopping, stopped };
 
     EventTimerHandler               user_handler;
-    int64_t                         period_usec;
-    state_t                         state;
+    PeriodicScheduler               scheduler;
+    std::atomic<state_t>            state;
     std::unique_ptr<std::thread>    caller;
 
     void handler_loop()
     {
-        auto t = epoch_usec();
-        auto t0 = t;
+        scheduler.reset();
 
         try
         {
@@ -29,16 +33,7 @@ private:
                 if (status)
                     break;
 
-                t = epoch_usec();
-                auto t1 = t0 + period_usec;
-
-                while (t < t1)
-                {
-                    sleep_usec(t1 - t);
-                    t = epoch_usec();
-                }
-
-                t0 = epoch_usec();
+                scheduler.wait();
             }
         }
         catch (std::exception& e)
@@ -51,9 +46,9 @@ private:
     }
 
 public:
-    EventTimer(int64_t period_usec, EventTimerHandler const& handler) :
+    EventTimer(int64_t period_usec, EventTimerHandler const& handler, int64_t spin_usec = 0) :
         user_handler(handler),
-        period_usec(period_usec),
+        scheduler(period_usec, spin_usec),
         state(stopped)
     {}
 
@@ -89,5 +84,10 @@ public:
     {
         return state == active;
     }
+
+    inline PeriodicScheduler const& stats() const
+    {
+        return scheduler;
+    }
 };
 
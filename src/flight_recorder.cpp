@@ -0,0 +1,191 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <new>
+#include <cppmisc/traces.h>
+#include <cppmisc/timing.h>
+#include "flight_recorder.h"
+
+using namespace std;
+
+
+namespace
+{
+    const char magic[8] = {'B', 'F', 'L', 'Y', 'R', 'E', 'C', '\0'};
+    const int64_t records_per_window = 4096;
+
+    struct FileHeader
+    {
+        char        magic[8];
+        uint32_t    version;
+        uint32_t    record_size;
+        uint64_t    count;
+        uint64_t    dropped;
+    };
+
+    int64_t page_size()
+    {
+        static const int64_t sz = sysconf(_SC_PAGESIZE);
+        return sz;
+    }
+}
+
+FlightRecorder::FlightRecorder(string const& path, int capacity, int64_t flush_usec) :
+    m_ring(capacity),
+    m_head(0),
+    m_tail(0),
+    m_dropped(0),
+    m_stop(false),
+    m_path(path),
+    m_fd(-1),
+    m_window(nullptr),
+    m_window_offset(0),
+    m_window_size(0),
+    m_written(0),
+    m_flush_usec(flush_usec)
+{
+    if (capacity <= 0)
+        throw_runtime_error("flight recorder capacity must be positive");
+
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+        throw_runtime_error("can't create flight record ", path, ": ", strerror(errno));
+
+    write_header();
+    map_window(header_size);
+    m_flusher = std::thread(&FlightRecorder::flusher_loop, this);
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+void* FlightRecorder::operator new(size_t size)
+{
+    void* p = nullptr;
+    if (posix_memalign(&p, alignof(FlightRecorder), size) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void FlightRecorder::operator delete(void* p)
+{
+    free(p);
+}
+
+void FlightRecorder::map_window(int64_t offset)
+{
+    int64_t size = records_per_window * sizeof(FlightRecord);
+    if (ftruncate(m_fd, offset + size) < 0)
+        throw_runtime_error("can't resize ", m_path, ": ", strerror(errno));
+
+    int64_t aligned = offset & ~(page_size() - 1);
+    int64_t delta = offset - aligned;
+    void* p = mmap(nullptr, size + delta, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, aligned);
+    if (p == MAP_FAILED)
+        throw_runtime_error("can't map ", m_path, ": ", strerror(errno));
+
+    m_window = reinterpret_cast<char*>(p) + delta;
+    m_window_offset = offset;
+    m_window_size = size;
+}
+
+void FlightRecorder::unmap_window()
+{
+    if (!m_window)
+        return;
+
+    int64_t delta = m_window_offset & (page_size() - 1);
+    munmap(m_window - delta, m_window_size + delta);
+    m_window = nullptr;
+}
+
+void FlightRecorder::write_header()
+{
+    FileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, magic, sizeof(magic));
+    hdr.version = version;
+    hdr.record_size = sizeof(FlightRecord);
+    hdr.count = m_written;
+    hdr.dropped = dropped();
+
+    if (pwrite(m_fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+        err_msg("can't write flight record header: ", strerror(errno));
+}
+
+void FlightRecorder::flush()
+{
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+    if (tail == head)
+        return;
+
+    while (tail < head)
+    {
+        int64_t pos = header_size + int64_t(m_written) * sizeof(FlightRecord);
+        if (pos + int64_t(sizeof(FlightRecord)) > m_window_offset + m_window_size)
+        {
+            unmap_window();
+            map_window(pos);
+        }
+
+        memcpy(m_window + (pos - m_window_offset), &m_ring[tail % m_ring.size()], sizeof(FlightRecord));
+        ++ tail;
+        ++ m_written;
+    }
+
+    m_tail.store(tail, std::memory_order_release);
+    write_header();
+}
+
+void FlightRecorder::flusher_loop()
+{
+    try
+    {
+        while (!m_stop)
+        {
+            flush();
+            sleep_usec(m_flush_usec);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        err_msg("flight recorder failed: ", e.what());
+    }
+}
+
+void FlightRecorder::close()
+{
+    if (m_fd < 0)
+        return;
+
+    m_stop = true;
+    if (m_flusher.joinable())
+        m_flusher.join();
+
+    try
+    {
+        flush();
+    }
+    catch (std::exception const& e)
+    {
+        err_msg("flight recorder failed: ", e.what());
+    }
+
+    unmap_window();
+    int64_t size = header_size + int64_t(m_written) * sizeof(FlightRecord);
+    if (ftruncate(m_fd, size) < 0)
+        err_msg("can't truncate ", m_path, ": ", strerror(errno));
+    write_header();
+    ::close(m_fd);
+    m_fd = -1;
+
+    info_msg("flight recorder: ", m_written, " records written to ", m_path, ", ", dropped(), " dropped");
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+
+
+/*
+ * On-disk record of a single control tick
+ *
+ * The layout is fixed and little endian; scripts/flight_log.py mirrors it
+ * as a numpy dtype. Bump FlightRecorder::version when it changes.
+ */
+struct FlightRecord
+{
+    double  t;
+    int32_t ball_found;
+    int32_t reserved;
+    double  theta;
+    double  dtheta;
+    double  phi;
+    double  dphi;
+    double  x;
+    double  vx;
+    double  y;
+    double  vy;
+    double  torque;
+    double  ctrl_tau;
+    double  ctrl_y;
+    double  ctrl_dy;
+    double  ctrl_I;
+    double  ctrl_v;
+    double  ctrl_u;
+};
+
+static_assert(sizeof(FlightRecord) == 136, "unexpected FlightRecord layout");
+
+
+/*
+ * Binary flight recorder
+ *
+ * push() copies the record into a preallocated ring and never blocks, does
+ * not allocate and makes no syscalls; if the ring is full the record is
+ * dropped and counted. A background thread moves records from the ring
+ * into an mmap'd file which grows in fixed chunks.
+ *
+ * File layout:
+ *   header      4096 bytes (magic, version, record size, count, dropped)
+ *   records     count * sizeof(FlightRecord)
+ */
+class FlightRecorder
+{
+public:
+    static const uint32_t version = 1;
+    static const int header_size = 4096;
+
+private:
+    std::vector<FlightRecord>   m_ring;
+    alignas(64) std::atomic<uint64_t> m_head;   // written by the producer
+    alignas(64) std::atomic<uint64_t> m_tail;   // written by the flusher
+    std::atomic<uint64_t>       m_dropped;
+    std::atomic<bool>           m_stop;
+
+    std::string m_path;
+    int         m_fd;
+    char*       m_window;       // mapped part of the file
+    int64_t     m_window_offset;
+    int64_t     m_window_size;
+    uint64_t    m_written;
+    int64_t     m_flush_usec;
+    std::thread m_flusher;
+
+    FlightRecorder(FlightRecorder const&) = delete;
+
+    void map_window(int64_t offset);
+    void unmap_window();
+    void write_header();
+    void flush();
+    void flusher_loop();
+
+public:
+    FlightRecorder(std::string const& path, int capacity, int64_t flush_usec = 10000);
+    ~FlightRecorder();
+
+    // C++11 new ignores the cache line alignment of m_head and m_tail
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+
+    // returns false if the record was dropped
+    inline bool push(FlightRecord const& record)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        uint64_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= m_ring.size())
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_ring[head % m_ring.size()] = record;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // flushes the remaining records and closes the file
+    void close();
+
+    inline uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    inline uint64_t written() const { return m_written; }
+};
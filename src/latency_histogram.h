@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <cppmisc/traces.h>
+
+
+/*
+ * Log-linear latency histogram in the spirit of HdrHistogram
+ *
+ * Values are nanoseconds. Every power of two is split into 2^sub_bits
+ * linear buckets, which bounds the relative error of a percentile by
+ * 2^-sub_bits. Recording is wait-free and allocation-free; it is meant to
+ * have a single writer while any thread may read or dump it.
+ */
+class LatencyHistogram
+{
+private:
+    static const int sub_bits = 5;
+    static const int sub_count = 1 << sub_bits;
+    static const int max_bits = 40;     // ~18 minutes
+    static const int nbuckets = (max_bits - sub_bits + 1) * sub_count;
+
+    std::atomic<uint64_t> m_buckets[nbuckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<int64_t>  m_max;
+
+    static inline int msb(uint64_t v)
+    {
+        return 63 - __builtin_clzll(v);
+    }
+
+    static inline int bucket_index(int64_t value)
+    {
+        if (value < sub_count)
+            return value < 0 ? 0 : int(value);
+
+        int shift = msb(uint64_t(value)) - sub_bits;
+        int idx = (shift + 1) * sub_count + int((value >> shift) - sub_count);
+        return idx < nbuckets ? idx : nbuckets - 1;
+    }
+
+    // the largest value falling into the bucket
+    static inline int64_t bucket_value(int idx)
+    {
+        if (idx < sub_count)
+            return idx;
+
+        int shift = idx / sub_count - 1;
+        int64_t sub = idx % sub_count + sub_count;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    template <typename T>
+    static inline void increment(std::atomic<T>& v, T delta)
+    {
+        // single writer, so there is no need for a read-modify-write
+        v.store(v.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+public:
+    LatencyHistogram()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < nbuckets; ++ i)
+            m_buckets[i].store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    inline void record(int64_t nsec)
+    {
+        increment(m_buckets[bucket_index(nsec)], uint64_t(1));
+        increment(m_count, uint64_t(1));
+        if (nsec > m_max.load(std::memory_order_relaxed))
+            m_max.store(nsec, std::memory_order_relaxed);
+    }
+
+    inline uint64_t count() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    inline int64_t max() const
+    {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * q in [0, 1]; returns nanoseconds
+     */
+    int64_t percentile(double q) const
+    {
+        uint64_t total = 0;
+        for (int i = 0; i < nbuckets; ++ i)
+            total += m_buckets[i].load(std::memory_order_relaxed);
+
+        if (total == 0)
+            return 0;
+
+        uint64_t rank = uint64_t(q * total + 0.5);
+        if (rank < 1)
+            rank = 1;
+
+        uint64_t acc = 0;
+        for (int i = 0; i < nbuckets; ++ i)
+        {
+            acc += m_buckets[i].load(std::memory_order_relaxed);
+            if (acc >= rank)
+            {
+                int64_t v = bucket_value(i);
+                int64_t vmax = max();
+                return v < vmax ? v : vmax;
+            }
+        }
+
+        return max();
+    }
+
+    void dump(char const* name) const
+    {
+        info_msg("latency ", name, ": n=", count(),
+            " p50=", percentile(0.5) * 1e-3,
+            " p99=", percentile(0.99) * 1e-3,
+            " p99.9=", percentile(0.999) * 1e-3,
+            " max=", max() * 1e-3, " usec");
+    }
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <stdint.h>
+#include <string.h>
 
 static const double _PI_2 = acos(0.0);
 static const double _PI = 2 * _PI_2;
@@ -20,6 +22,17 @@ inline bool in_diap(T const& val, T const& minval, T const& maxval)
     return val >= minval && val <= maxval;
 }
 
+/*
+ * neither NaN nor inf; tested by the bits, as -Ofast assumes finite math
+ * and folds std::isfinite() to true
+ */
+inline bool is_finite(double x)
+{
+	uint64_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	return (bits & 0x7ff0000000000000ull) != 0x7ff0000000000000ull;
+}
+
 template <typename T>
 inline T square(T const& x)
 {
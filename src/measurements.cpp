@@ -69,7 +69,6 @@ int launch(Json::Value const& jscfg, F& f)
         servo->set_torque(torque);
     }
 
-    servo->set_torque(0.0);
     servo->stop();
     return status;
 }
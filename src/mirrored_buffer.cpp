@@ -0,0 +1,68 @@
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <utility>
+#include <cppmisc/throws.h>
+#include "mirrored_buffer.h"
+
+
+MirroredBuffer::MirroredBuffer(size_t size) : m_data(nullptr), m_size(0)
+{
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    m_size = page;
+    while (m_size < size)
+        m_size *= 2;
+
+    int fd = memfd_create("ser_ring", MFD_CLOEXEC);
+    if (fd < 0)
+        throw_runtime_error("memfd_create failed: ", strerror(errno));
+
+    if (ftruncate(fd, m_size) < 0)
+    {
+        int err = errno;
+        close(fd);
+        throw_runtime_error("can't resize ring buffer: ", strerror(err));
+    }
+
+    // reserve both halves at once, then map the file over each of them
+    void* p = mmap(nullptr, 2 * m_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        int err = errno;
+        close(fd);
+        throw_runtime_error("can't reserve ring buffer: ", strerror(err));
+    }
+
+    char* base = reinterpret_cast<char*>(p);
+    void* lo = mmap(base, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void* hi = mmap(base + m_size, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    int err = errno;
+    close(fd);
+
+    if (lo == MAP_FAILED || hi == MAP_FAILED)
+    {
+        munmap(base, 2 * m_size);
+        throw_runtime_error("can't map ring buffer: ", strerror(err));
+    }
+
+    m_data = base;
+}
+
+MirroredBuffer::MirroredBuffer(MirroredBuffer&& src) : m_data(src.m_data), m_size(src.m_size)
+{
+    src.m_data = nullptr;
+    src.m_size = 0;
+}
+
+MirroredBuffer::~MirroredBuffer()
+{
+    if (m_data)
+        munmap(m_data, 2 * m_size);
+}
+
+void MirroredBuffer::swap(MirroredBuffer& other)
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+
+/*
+ * Ring buffer memory mapped twice back to back
+ *
+ * The second mapping mirrors the first, so size() bytes starting at any
+ * offset below size() are contiguous: data that wraps around the end of
+ * the ring can be read or written with a single pointer, and consuming it
+ * only advances an index.
+ */
+class MirroredBuffer
+{
+private:
+    char*   m_data;
+    size_t  m_size;
+
+    MirroredBuffer(MirroredBuffer const&) = delete;
+    MirroredBuffer& operator=(MirroredBuffer const&) = delete;
+
+public:
+    // the size is rounded up to a power of two number of pages
+    explicit MirroredBuffer(size_t size);
+    MirroredBuffer(MirroredBuffer&& src);
+    ~MirroredBuffer();
+
+    void swap(MirroredBuffer& other);
+
+    inline char* data() const { return m_data; }
+    inline size_t size() const { return m_size; }
+
+    // pointer to the byte at a ring position; positions may grow unbounded
+    inline char* at(size_t pos) const { return m_data + (pos & (m_size - 1)); }
+};
@@ -273,32 +273,39 @@ static double get_torque_sham3(BflySignals const& signals, FeedbackConfig const&
         return 0;
 }
 
-static double get_torque(BflySignals const& signals, FeedbackConfig const& fbcfg)
+/*
+ * false if the state is out of the range of the feedback splines, e.g. NaN;
+ * nothing here throws
+ */
+static bool get_torque(BflySignals const& signals, FeedbackConfig const& fbcfg, ControllerTrace& trace, double& tau)
 {
     double theta = signals.theta;
     double phi = signals.phi;
     double dtheta = signals.dtheta;
     double dphi = signals.dphi;
 
+    if (!is_finite(phi))
+        return false;
+
     auto n = int(floor(phi / _PI));
     phi -= _PI * n;
     theta -= _PI * n;
     
-    static const spline spline_dphi_sham(3, fbcfg.phi, fbcfg.dphi,  "periodic");
-    static const spline spline_vc_sham(3, fbcfg.phi, fbcfg.theta,  "periodic");
-
-    auto dphi_s = spline_dphi_sham(phi);
-    auto theta_s = spline_vc_sham(phi);
-    auto vc1 = spline_vc_sham(phi, 1);
-    auto vc2 = spline_vc_sham(phi, 2);
-    
-
-    static const spline spline_ky_sham(3, fbcfg.phi, fbcfg.k_c1, "periodic");
-    static const spline spline_kdy_sham(3, fbcfg.phi, fbcfg.k_c2, "periodic");
-    static const spline spline_kz_sham(3, fbcfg.phi, fbcfg.k_c3, "periodic");
-    auto ky = spline_ky_sham(phi);
-    auto kdy = spline_kdy_sham(phi);
-    auto kz = spline_kz_sham(phi);
+    // channels: dphi, theta, k_c1, k_c2, k_c3
+    static const spline_bundle sham_splines(3, fbcfg.phi, 
+        {fbcfg.dphi, fbcfg.theta, fbcfg.k_c1, fbcfg.k_c2, fbcfg.k_c3}, "periodic");
+
+    // derivatives 0..2 of all the channels
+    double sham[3 * 5];
+    if (!sham_splines.eval_all(phi, sham, 2))
+        return false;
+    auto dphi_s = sham[0];
+    auto theta_s = sham[1];
+    auto vc1 = sham[5 + 1];
+    auto vc2 = sham[10 + 1];
+    auto ky = sham[2];
+    auto kdy = sham[3];
+    auto kz = sham[4];
 
     auto dtheta_s = vc1 * dphi_s;
 
@@ -310,19 +317,28 @@ static double get_torque(BflySignals const& signals, FeedbackConfig const& fbcfg
 
     Vec2 dq_s(dtheta_s, dphi_s);
     Mat2x2 invL(1, -vc1, 0, 1);
-    auto M = sub_M(theta, phi);
-    auto C = sub_C(theta_s, phi, dtheta_s, dphi_s);
-    auto G = sub_G(theta, phi);
+    double rho[3];
+    if (!spline_rho<2>(phi, rho))
+        return false;
+
+    auto M = sub_M(theta, phi, rho);
+    auto C = sub_C(theta_s, phi, dtheta_s, dphi_s, rho);
+    auto G = sub_G(theta, phi, rho);
 
     auto invM = inv(M);
     auto K = invL * invM;
 
 
-    auto tau = (v + (K * (G + C * dq_s)).at(0,0) + vc2 * pow(dphi_s, 2)) / K.at(0,0);
-    info_msg("[log] " ,"t=", signals.t, ",torque=", signals.torque, ",theta=", theta, ",phi=", phi, 
-             ",dtheta=", dtheta, ",dphi=", dphi, ",x=", signals.x, ",y=", signals.y);
+    tau = (v + (K * (G + C * dq_s)).at(0,0) + vc2 * pow(dphi_s, 2)) / K.at(0,0);
+
+    trace.tau = phi;
+    trace.y = y;
+    trace.dy = dy;
+    trace.I = z;
+    trace.v = v;
+    trace.u = tau;
 
-    return tau;
+    return true;
 }
 
 
@@ -343,7 +359,12 @@ int launch(Json::Value const& jscfg, Json::Value const& fbcfg)
         if (!signals.ball_found)
             return false;
 
-        auto torque = get_torque(signals, fbcfg);
+        double torque;
+        if (!get_torque(signals, fbcfg, signals.ctrl, torque))
+        {
+            signals.torque = 0.;
+            return false;
+        }
         signals.torque = clamp(torque, -0.1, 0.1);
 
         return true;
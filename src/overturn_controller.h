@@ -2,6 +2,7 @@
 
 #include "matrix.h"
 #include "splines.h"
+#include "static_spline.h"
 #include "filters.h"
 #include <vector>
 
@@ -32,10 +33,11 @@ using namespace std;
 //     return s(arg, der);
 // }
 
-inline double spline_rho(double arg, int der=0)
+template <int maxder>
+inline bool spline_rho(double arg, double* rho)
 {
-    static spline s(5, {-0.0259916157659,-0.0103954212891,-0.00519762315263,3.90788876463e-12,0.00519762315912,0.0103954212943,0.0155935694044,0.0207922425284,0.0259916157683,0.0311918643098,0.0363931634432,0.0415956885855,0.0467996153011,0.0520051193228,0.057212376575,0.0624215631947,0.0676328555542,0.0728464302834,0.0780624642933,0.0832811347986,0.0885026193425,0.0937270958193,0.0989547425011,0.104185738062,0.109420261603,0.114658492683,0.11990061134,0.125146798126,0.130397234132,0.13565210102,0.140911581057,0.146175857146,0.151445112863,0.156719532496,0.161999301082,0.167284604454,0.172575629286,0.177872563145,0.18317559455,0.188484913032,0.193800709207,0.199123174859,0.204452503035,0.209788888151,0.215132526121,0.220483614515,0.225842352735,0.231208942242,0.236583586821,0.241966492913,0.247357870021,0.252757931209,0.258166893735,0.263584979824,0.269012417648,0.274449442556,0.27989629861,0.285353240534,0.290820536161,0.296298469525,0.301787344767,0.307287491051,0.312799268787,0.318323077444,0.323859365398,0.329408642269,0.334971494348,0.340548603795,0.346140772367,0.351748950529,0.357374272758,0.363018099761,0.368682067945,0.374368145838,0.380078695948,0.385816538641,0.391585011859,0.3973880167,0.403230034357,0.40911609536,0.415051679068,0.421042522436,0.427094325316,0.433212357182,0.439400996548,0.445663263653,0.452000428183,0.458411774662,0.464894582216,0.471444328387,0.478055075195,0.484719959222,0.491431697403,0.498183035175,0.504967092659,0.511777594916,0.51860899524,0.525456513044,0.532316111535,0.539184438254,0.546058746738,0.552936812224,0.559816849632,0.566697438486,0.573577456889,0.580456025089,0.587332458234,0.594206227404,0.601076927845,0.607944253305,0.614807975425,0.621667927291,0.628523990346,0.635376084013,0.642224157491,0.649068183277,0.655908152051,0.662744068666,0.669575948971,0.676403817334,0.68322770468,0.690047646961,0.696863683945,0.703675858278,0.710484214733,0.717288799635,0.724089660402,0.730886845185,0.737680402592,0.744470381466,0.751256830716,0.75803979918,0.764819335526,0.771595488164,0.77836830519,0.785137834333,0.79190412292,0.798667217849,0.805427165566,0.812184012049,0.8189378028,0.825688582834,0.832436396675,0.839181288356,0.845923301413,0.852662478891,0.859398863341,0.866132496825,0.872863420918,0.879591676711,0.886317304817,0.893040345375,0.899760838053,0.906478822055,0.913194336127,0.919907418558,0.926618107191,0.933326439425,0.940032452221,0.946736182112,0.953437665201,0.960136937173,0.966834033301,0.973528988446,0.98022183707,0.986912613237,0.993601350622,1.00028808252,1.00697284183,1.0136556611,1.0203365725,1.02701560784,1.03369279858,1.04036817582,1.04704177032,1.05371361251,1.06038373249,1.06705216001,1.07371892452,1.08038405516,1.08704758073,1.09370952976,1.10036993046,1.10702881075,1.11368619826,1.12034212036,1.1269966041,1.13364967629,1.14030136346,1.14695169189,1.1536006876,1.16024837633,1.16689478361,1.17353993472,1.18018385468,1.18682656831,1.19346810017,1.20010847463,1.20674771583,1.21338584768,1.2200228939,1.226658878,1.2332938233,1.23992775291,1.24656068976,1.25319265659,1.25982367596,1.26645377025,1.27308296168,1.27971127228,1.28633872393,1.29296533835,1.29959113711,1.3062161416,1.31284037309,1.31946385271,1.32608660142,1.33270864008,1.3393299894,1.34595066995,1.35257070221,1.3591901065,1.36580890306,1.37242711201,1.37904475333,1.38566184694,1.39227841262,1.39889447009,1.40551003895,1.41212513872,1.41873978883,1.42535400863,1.43196781739,1.43858123431,1.4451942785,1.45180696902,1.45841932487,1.46503136498,1.4716431082,1.47825457336,1.48486577923,1.49147674452,1.49808748791,1.50469802804,1.51130838349,1.51791857283,1.5245286146,1.5311385273,1.53774832941,1.54435803939,1.55096767569,1.55757725675,1.56418680098,1.57079632679,1.57740585261,1.58401539684,1.5906249779,1.5972346142,1.60384432418,1.61045412629,1.61706403899,1.62367408076,1.6302842701,1.63689462555,1.64350516567,1.65011590907,1.65672687436,1.66333808023,1.66994954539,1.67656128861,1.68317332872,1.68978568456,1.69639837509,1.70301141928,1.7096248362,1.71623864496,1.72285286476,1.72946751487,1.73608261464,1.7426981835,1.74931424097,1.75593080665,1.76254790026,1.76916554158,1.77578375052,1.78240254709,1.78902195138,1.79564198364,1.80226266419,1.80888401351,1.81550605217,1.82212880088,1.8287522805,1.83537651199,1.84200151648,1.84862731524,1.85525392966,1.86188138131,1.86850969191,1.87513888334,1.88176897763,1.888399997,1.89503196383,1.90166490068,1.90829883029,1.91493377559,1.92156975969,1.92820680591,1.93484493776,1.94148417896,1.94812455342,1.95476608528,1.96140879891,1.96805271887,1.97469786998,1.98134427726,1.98799196599,1.99464096169,2.00129129013,2.0079429773,2.01459604949,2.02125053323,2.02790645533,2.03456384284,2.04122272313,2.04788312383,2.05454507286,2.06120859843,2.06787372907,2.07454049358,2.0812089211,2.08787904108,2.09455088327,2.10122447777,2.10789985501,2.11457704575,2.12125608109,2.12793699249,2.13461981176,2.14130457107,2.14799130297,2.15468004035,2.16137081652,2.16806366514,2.17475862029,2.18145571642,2.18815498839,2.19485647148,2.20156020137,2.20826621417,2.2149745464,2.22168523503,2.22839831746,2.23511383153,2.24183181554,2.24855230821,2.25527534877,2.26200097688,2.26872923267,2.27546015676,2.28219379025,2.2889301747,2.29566935218,2.30241136523,2.30915625691,2.31590407076,2.32265485079,2.32940864154,2.33616548802,2.34292543574,2.34968853067,2.35645481926,2.3632243484,2.36999716543,2.37677331806,2.38355285441,2.39033582287,2.39712227212,2.403912251,2.4107058084,2.41750299319,2.42430385395,2.43110843886,2.43791679531,2.44472896964,2.45154500663,2.45836494891,2.46518883626,2.47201670462,2.47884858492,2.48568450154,2.49252447031,2.4993684961,2.50621656958,2.51306866324,2.5199247263,2.52678467816,2.53364840028,2.54051572574,2.54738642619,2.55426019536,2.5611366285,2.5680151967,2.5748952151,2.58177580396,2.58865584137,2.59553390685,2.60240821534,2.60927654205,2.61613614055,2.62298365835,2.62981505867,2.63662556093,2.64340961841,2.65016095619,2.65687269437,2.66353757839,2.6701483252,2.67669807137,2.68318087893,2.68959222541,2.69592938994,2.70219165704,2.70838029641,2.71449832827,2.72055013115,2.72654097452,2.73247655823,2.73836261923,2.74420463689,2.75000764173,2.75577611495,2.76151395764,2.76722450775,2.77291058565,2.77857455383,2.78421838083,2.78984370306,2.79545188122,2.80104404979,2.80662115924,2.81218401132,2.81773328819,2.82326957615,2.8287933848,2.83430516254,2.83980530882,2.84529418406,2.85077211743,2.85623941306,2.86169635498,2.86714321103,2.87258023594,2.87800767377,2.88342575985,2.88883472238,2.89423478357,2.89962616068,2.90500906677,2.91038371135,2.91575030085,2.92110903907,2.92646012747,2.93180376544,2.93714015055,2.94246947873,2.94779194438,2.95310774056,2.95841705904,2.96372009044,2.9690170243,2.97430804914,2.97959335251,2.98487312109,2.99014754073,2.99541679644,3.00068107253,3.00594055257,3.01119541946,3.01644585546,3.02169204225,3.02693416091,3.03217239199,3.03740691553,3.04263791109,3.04786555777,3.05309003425,3.05831151879,3.0635301893,3.06874622331,3.07395979804,3.0791710904,3.08438027702,3.08958753427,3.09479303829,3.09999696501,3.10519949015,3.11040078928,3.11560103782,3.12080041106,3.12599908419,3.1311972323,3.13639503044,3.14159265359,3.14679027675,3.15198807488,3.15718622299,3.16238489612,3.16758426936,3.1727845179,3.17798581703,3.18318834218,3.18839226889,3.19359777291,3.19880503016,3.20401421678,3.20922550914,3.21443908387,3.21965511788,3.22487378839,3.23009527293,3.23531974941,3.24054739609,3.24577839165,3.25101291519,3.25625114627,3.26149326493,3.26673945172,3.27198988772,3.27724475461,3.28250423465,3.28776851074,3.29303776645,3.29831218609,3.30359195467,3.30887725804,3.31416828288,3.31946521674,3.32476824814,3.33007756662,3.3353933628,3.34071582845,3.34604515663,3.35138154174,3.35672517971,3.3620762681,3.36743500632,3.37280159583,3.37817624041,3.3835591465,3.38895052361,3.3943505848,3.39975954732,3.40517763341,3.41060507124,3.41604209615,3.4214889522,3.42694589412,3.43241318975,3.43789112312,3.44337999836,3.44888014464,3.45439192238,3.45991573103,3.46545201899,3.47100129586,3.47656414794,3.48214125738,3.48773342596,3.49334160412,3.49896692635,3.50461075335,3.51027472153,3.51596079943,3.52167134954,3.52740919223,3.53317766545,3.53898067029,3.54482268795,3.55070874895,3.55664433266,3.56263517603,3.56868697891,3.57480501077,3.58099365014,3.58725591724,3.59359308177,3.60000442825,3.60648723581,3.61303698198,3.61964772878,3.62631261281,3.63302435099,3.63977568876,3.64655974625,3.65337024851,3.66020164883,3.66704916663,3.67390876512,3.68077709184,3.68765140033,3.69452946581,3.70140950322,3.70829009208,3.71517011048,3.72204867868,3.72892511182,3.73579888099,3.74266958144,3.74953690689,3.75640062901,3.76326058088,3.77011664394,3.7769687376,3.78381681108,3.79066083687,3.79750080564,3.80433672226,3.81116860256,3.81799647092,3.82482035827,3.83164030055,3.83845633753,3.84526851187,3.85207686832,3.85888145323,3.86568231399,3.87247949877,3.87927305618,3.88606303506,3.89284948431,3.89963245277,3.90641198912,3.91318814175,3.91996095878,3.92673048792,3.93349677651,3.94025987144,3.94701981916,3.95377666564,3.96053045639,3.96728123642,3.97402905026,3.98077394195,3.987515955,3.99425513248,4.00099151693,4.00772515042,4.01445607451,4.0211843303,4.02790995841,4.03463299896,4.04135349164,4.04807147564,4.05478698972,4.06150007215,4.06821076078,4.07491909301,4.08162510581,4.0883288357,4.09503031879,4.10172959076,4.10842668689,4.11512164204,4.12181449066,4.12850526683,4.13519400421,4.14188073611,4.14856549542,4.15524831469,4.16192922609,4.16860826143,4.17528545217,4.18196082941,4.18863442391,4.1953062661,4.20197638608,4.2086448136,4.21531157811,4.22197670875,4.22864023432,4.23530218335,4.24196258405,4.24862146434,4.25527885185,4.26193477394,4.26858925769,4.27524232988,4.28189401705,4.28854434548,4.29519334119,4.30184102992,4.3084874372,4.31513258831,4.32177650827,4.3284192219,4.33506075376,4.34170112822,4.34834036942,4.35497850127,4.36161554749,4.36825153159,4.37488647689,4.3815204065,4.38815334335,4.39478531018,4.40141632955,4.40804642384,4.41467561527,4.42130392587,4.42793137752,4.43455799194,4.4411837907,4.44780879519,4.45443302668,4.4610565063,4.46767925501,4.47430129367,4.48092264299,4.48754332354,4.4941633558,4.50078276009,4.50740155665,4.5140197656,4.52063740692,4.52725450053,4.53387106621,4.54048712368,4.54710269254,4.55371779231,4.56033244242,4.56694666222,4.57356047098,4.5801738879,4.58678693209,4.59339962261,4.60001197846,4.60662401857,4.61323576179,4.61984722695,4.62645843282,4.63306939811,4.6396801415,4.64629068163,4.65290103708,4.65951122642,4.66612126819,4.67273118089,4.67934098299,4.68595069298,4.69256032928,4.69916991034,4.70577945457,4.71238898038,4.7189985062,4.72560805043,4.73221763149,4.73882726779,4.74543697777,4.75204677988,4.75865669258,4.76526673435,4.77187692369,4.77848727914,4.78509781926,4.79170856266,4.79831952795,4.80493073382,4.81154219898,4.8181539422,4.82476598231,4.83137833815,4.83799102868,4.84460407287,4.85121748979,4.85783129855,4.86444551835,4.87106016846,4.87767526823,4.88429083709,4.89090689456,4.89752346024,4.90414055385,4.91075819517,4.91737640411,4.92399520068,4.93061460497,4.93723463723,4.94385531778,4.9504766671,4.95709870576,4.96372145447,4.97034493409,4.97696916558,4.98359417007,4.99021996883,4.99684658325,5.0034740349,5.0101023455,5.01673153693,5.02336163122,5.02999265059,5.03662461742,5.04325755427,5.04989148388,5.05652642918,5.06316241328,5.0697994595,5.07643759135,5.08307683255,5.08971720701,5.09635873887,5.1030014525,5.10964537246,5.11629052357,5.12293693085,5.12958461958,5.13623361528,5.14288394372,5.14953563089,5.15618870308,5.16284318682,5.16949910892,5.17615649643,5.18281537672,5.18947577742,5.19613772645,5.20280125202,5.20946638266,5.21613314717,5.22280157469,5.22947169467,5.23614353686,5.24281713136,5.2494925086,5.25616969934,5.26284873468,5.26952964608,5.27621246535,5.28289722466,5.28958395656,5.29627269394,5.30296347011,5.30965631873,5.31635127388,5.32304837001,5.32974764198,5.33644912507,5.34315285496,5.34985886775,5.35656719999,5.36327788862,5.36999097105,5.37670648512,5.38342446913,5.3901449618,5.39686800236,5.40359363047,5.41032188626,5.41705281035,5.42378644384,5.43052282829,5.43726200577,5.44400401882,5.4507489105,5.45749672435,5.46424750438,5.47100129513,5.47775814161,5.48451808933,5.49128118426,5.49804747285,5.50481700199,5.51158981902,5.51836597165,5.525145508,5.53192847646,5.53871492571,5.54550490459,5.55229846199,5.55909564678,5.56589650754,5.57270109245,5.5795094489,5.58632162323,5.59313766022,5.5999576025,5.60678148985,5.61360935821,5.62044123851,5.62727715513,5.6341171239,5.64096114969,5.64780922317,5.65466131683,5.66151737989,5.66837733175,5.67524105387,5.68210837933,5.68897907978,5.69585284895,5.70272928209,5.70960785029,5.71648786869,5.72336845755,5.73024849496,5.73712656044,5.74400086893,5.75086919564,5.75772879414,5.76457631194,5.77140771226,5.77821821452,5.785002272,5.79175360978,5.79846534796,5.80513023198,5.81174097879,5.81829072496,5.82477353252,5.831184879,5.83752204353,5.84378431063,5.84997295,5.85609098186,5.86214278474,5.86813362811,5.87406921182,5.87995527282,5.88579729048,5.89160029532,5.89736876854,5.90310661123,5.90881716134,5.91450323923,5.92016720742,5.92581103442,5.93143635665,5.93704453481,5.94263670338,5.94821381283,5.95377666491,5.95932594178,5.96486222974,5.97038603839,5.97589781613,5.98139796241,5.98688683765,5.99236477102,5.99783206665,6.00328900857,6.00873586462,6.01417288953,6.01960032736,6.02501841344,6.03042737597,6.03582743716,6.04121881427,6.04660172036,6.05197636494,6.05734295444,6.06270169266,6.06805278106,6.07339641903,6.07873280414,6.08406213232,6.08938459797,6.09470039415,6.10000971263,6.10531274403,6.11060967789,6.11590070273,6.1211860061,6.12646577468,6.13174019432,6.13700945003,6.14227372612,6.14753320616,6.15278807305,6.15803850905,6.16328469584,6.1685268145,6.17376504558,6.17899956912,6.18423056468,6.18945821136,6.19468268784,6.19990417238,6.20512284289,6.2103388769,6.21555245163,6.22076374399,6.22597293061,6.23118018786,6.23638569188,6.2415896186,6.24679214374,6.25199344287,6.25719369141,6.26239306465,6.26759173778,6.27278988589,6.27798768403,6.28318530718,6.28838293034,6.29358072847,6.30917692295}, {0.085375715712,0.0853652143387,0.0853533184262,0.0853419526262,0.085333562149,0.0853311153878,0.0853328629567,0.0853381063916,0.0853468478788,0.0853590910648,0.0853748410603,0.0853941044464,0.0854168892816,0.0854432051114,0.0854730629791,0.0855064754385,0.085543456568,0.0855840219874,0.0856281888757,0.0856759759912,0.0857274036934,0.0857824939671,0.0858412704482,0.0859037584522,0.0859699850046,0.086039978873,0.0861137706029,0.0861913925546,0.0862728789437,0.0863582658837,0.0864475914312,0.086540895635,0.0866382205872,0.0867396104781,0.086845111654,0.0869547726793,0.0870686444019,0.0871867800219,0.087309235166,0.0874360679649,0.0875673391359,0.087703112071,0.0878434529292,0.0879884307355,0.0881381174855,0.0882925882566,0.088451921326,0.0886161982966,0.0887855042311,0.0889599277946,0.0891395614077,0.0893245014102,0.0895148482361,0.0897107066031,0.0899121857163,0.0901193994892,0.0903324667841,0.0905515116751,0.0907766637363,0.0910080583613,0.0912458371178,0.0914901481451,0.0917411466018,0.0919989951746,0.092263864661,0.0925359346386,0.0928153942416,0.0931024430643,0.0933972922139,0.0937001655398,0.0940113010619,0.0943309526186,0.0946593917369,0.094996909704,0.0953438197662,0.0957004593008,0.0960671916754,0.0964444073222,0.0968325233012,0.0972319803141,0.0976432358137,0.0980667516277,0.0985029745536,0.0989523089016,0.0994150811622,0.0998914988723,0.100381608058,0.100885255664,0.101402064216,0.101931424939,0.102472512521,0.103024320527,0.103585712325,0.104155479758,0.104732401173,0.105315291862,0.105903042605,0.106494644852,0.107089203431,0.107685939103,0.10828418378,0.10888337117,0.109483025065,0.110082746931,0.110682203885,0.111281117684,0.111879255022,0.112476419217,0.113072443223,0.113667183868,0.114260517126,0.114852334302,0.115442538958,0.116031044451,0.11661777198,0.117202649024,0.117785608112,0.11836658585,0.118945522153,0.119522359633,0.120097043125,0.120669519313,0.121239736428,0.121807644018,0.122373192763,0.122936334331,0.123497021266,0.124055206891,0.124610845244,0.125163891019,0.12571429952,0.126262026627,0.126807028765,0.127349262885,0.127888686441,0.12842525738,0.128958934123,0.12948967556,0.130017441042,0.130542190369,0.131063883785,0.131582481977,0.132097946065,0.1326102376,0.133119318559,0.133625151343,0.134127698772,0.134626924083,0.135122790926,0.135615263363,0.136104305863,0.1365898833,0.137071960951,0.137550504495,0.138025480008,0.138496853959,0.138964593215,0.13942866503,0.13988903705,0.140345677304,0.140798554209,0.141247636562,0.141692893542,0.142134294706,0.142571809985,0.143005409689,0.143435064496,0.143860745456,0.144282423989,0.144700071881,0.145113661283,0.145523164709,0.145928555037,0.146329805501,0.146726889698,0.147119781577,0.147508455447,0.147892885967,0.148273048149,0.148648917357,0.149020469304,0.149387680048,0.149750525997,0.150108983901,0.150463030857,0.150812644301,0.151157802012,0.15149848211,0.15183466305,0.152166323629,0.152493442976,0.152816000558,0.153133976176,0.153447349962,0.153756102383,0.154060214234,0.154359666643,0.154654441062,0.154944519278,0.155229883398,0.15551051586,0.155786399427,0.156057517183,0.156323852539,0.156585389228,0.156842111304,0.157094003144,0.157341049443,0.157583235219,0.157820545806,0.158052966858,0.158280484347,0.158503084562,0.158720754106,0.158933479902,0.159141249186,0.159344049507,0.159541868732,0.159734695039,0.159922516919,0.160105323176,0.160283102928,0.160455845601,0.160623540935,0.160786178981,0.160943750097,0.161096244955,0.161243654533,0.161385970121,0.161523183316,0.161655286024,0.16178227046,0.161904129145,0.162020854908,0.162132440887,0.162238880524,0.162340167571,0.162436296083,0.162527260424,0.162613055261,0.162693675571,0.162769116632,0.162839374031,0.162904443657,0.162964321707,0.163019004682,0.163068489385,0.163112772928,0.163151852724,0.163185726494,0.163214392259,0.163237848347,0.16325609339,0.163269126324,0.163276946388,0.163279553127,0.163276946388,0.163269126324,0.16325609339,0.163237848347,0.163214392259,0.163185726494,0.163151852724,0.163112772928,0.163068489385,0.163019004682,0.162964321707,0.162904443657,0.162839374031,0.162769116632,0.162693675571,0.162613055261,0.162527260424,0.162436296083,0.162340167571,0.162238880524,0.162132440887,0.162020854908,0.161904129145,0.16178227046,0.161655286024,0.161523183316,0.161385970121,0.161243654533,0.161096244955,0.160943750097,0.160786178981,0.160623540935,0.160455845601,0.160283102928,0.160105323176,0.159922516919,0.159734695039,0.159541868732,0.159344049507,0.159141249186,0.158933479902,0.158720754106,0.158503084562,0.158280484347,0.158052966858,0.157820545806,0.157583235219,0.157341049443,0.157094003144,0.156842111304,0.156585389228,0.156323852539,0.156057517183,0.155786399427,0.155510515861,0.155229883398,0.154944519278,0.154654441062,0.154359666643,0.154060214235,0.153756102383,0.153447349962,0.153133976176,0.152816000558,0.152493442976,0.152166323629,0.15183466305,0.15149848211,0.151157802012,0.150812644301,0.150463030857,0.150108983901,0.149750525997,0.149387680048,0.149020469304,0.148648917358,0.148273048149,0.147892885967,0.147508455447,0.147119781577,0.146726889698,0.146329805501,0.145928555037,0.14552316471,0.145113661283,0.144700071881,0.144282423989,0.143860745456,0.143435064496,0.143005409689,0.142571809986,0.142134294706,0.141692893542,0.141247636562,0.140798554209,0.140345677304,0.13988903705,0.13942866503,0.138964593215,0.138496853959,0.138025480008,0.137550504496,0.137071960951,0.1365898833,0.136104305863,0.135615263363,0.135122790926,0.134626924083,0.134127698772,0.133625151343,0.133119318559,0.1326102376,0.132097946065,0.131582481977,0.131063883785,0.130542190369,0.130017441042,0.129489675561,0.128958934123,0.12842525738,0.127888686441,0.127349262885,0.126807028765,0.126262026627,0.12571429952,0.125163891019,0.124610845244,0.124055206891,0.123497021266,0.122936334332,0.122373192763,0.121807644018,0.121239736428,0.120669519313,0.120097043125,0.119522359633,0.118945522153,0.11836658585,0.117785608112,0.117202649024,0.11661777198,0.116031044452,0.115442538958,0.114852334302,0.114260517126,0.113667183868,0.113072443224,0.112476419217,0.111879255023,0.111281117684,0.110682203885,0.110082746931,0.109483025065,0.108883371171,0.10828418378,0.107685939103,0.107089203431,0.106494644852,0.105903042606,0.105315291863,0.104732401173,0.104155479758,0.103585712325,0.103024320527,0.102472512521,0.101931424939,0.101402064216,0.100885255664,0.100381608058,0.0998914988724,0.0994150811624,0.0989523089017,0.0985029745537,0.0980667516278,0.0976432358138,0.0972319803142,0.0968325233013,0.0964444073223,0.0960671916755,0.0957004593009,0.0953438197663,0.0949969097041,0.0946593917371,0.0943309526188,0.0940113010621,0.0937001655399,0.0933972922141,0.0931024430645,0.0928153942418,0.0925359346387,0.0922638646611,0.0919989951748,0.0917411466019,0.0914901481452,0.091245837118,0.0910080583614,0.0907766637364,0.0905515116752,0.0903324667843,0.0901193994893,0.0899121857164,0.0897107066032,0.0895148482362,0.0893245014103,0.0891395614079,0.0889599277947,0.0887855042312,0.0886161982968,0.0884519213261,0.0882925882567,0.0881381174856,0.0879884307356,0.0878434529293,0.0877031120711,0.0875673391361,0.087436067965,0.0873092351662,0.0871867800221,0.087068644402,0.0869547726795,0.0868451116541,0.0867396104782,0.0866382205874,0.0865408956352,0.0864475914313,0.0863582658838,0.0862728789439,0.0861913925547,0.086113770603,0.0860399788731,0.0859699850047,0.0859037584524,0.0858412704483,0.0857824939672,0.0857274036936,0.0856759759914,0.0856281888759,0.0855840219875,0.0855434565681,0.0855064754386,0.0854730629792,0.0854432051115,0.0854168892817,0.0853941044465,0.0853748410604,0.0853590910649,0.0853468478789,0.0853381063916,0.0853328629567,0.0853311153878,0.0853328629567,0.0853381063916,0.0853468478788,0.0853590910648,0.0853748410603,0.0853941044464,0.0854168892816,0.0854432051114,0.0854730629791,0.0855064754385,0.085543456568,0.0855840219874,0.0856281888757,0.0856759759912,0.0857274036934,0.0857824939671,0.0858412704482,0.0859037584522,0.0859699850046,0.086039978873,0.0861137706029,0.0861913925546,0.0862728789437,0.0863582658837,0.0864475914312,0.086540895635,0.0866382205872,0.0867396104781,0.086845111654,0.0869547726793,0.0870686444019,0.0871867800219,0.087309235166,0.0874360679649,0.0875673391359,0.087703112071,0.0878434529291,0.0879884307355,0.0881381174855,0.0882925882566,0.088451921326,0.0886161982966,0.0887855042311,0.0889599277946,0.0891395614077,0.0893245014102,0.0895148482361,0.0897107066031,0.0899121857163,0.0901193994892,0.0903324667841,0.0905515116751,0.0907766637363,0.0910080583613,0.0912458371178,0.0914901481451,0.0917411466017,0.0919989951746,0.092263864661,0.0925359346386,0.0928153942416,0.0931024430643,0.0933972922139,0.0937001655398,0.0940113010619,0.0943309526186,0.0946593917369,0.094996909704,0.0953438197662,0.0957004593008,0.0960671916754,0.0964444073222,0.0968325233012,0.0972319803141,0.0976432358136,0.0980667516277,0.0985029745536,0.0989523089016,0.0994150811622,0.0998914988723,0.100381608058,0.100885255664,0.101402064216,0.101931424939,0.102472512521,0.103024320527,0.103585712325,0.104155479758,0.104732401173,0.105315291862,0.105903042605,0.106494644852,0.107089203431,0.107685939103,0.10828418378,0.10888337117,0.109483025065,0.110082746931,0.110682203885,0.111281117684,0.111879255022,0.112476419217,0.113072443223,0.113667183868,0.114260517126,0.114852334302,0.115442538958,0.116031044451,0.11661777198,0.117202649024,0.117785608112,0.11836658585,0.118945522153,0.119522359633,0.120097043125,0.120669519313,0.121239736428,0.121807644018,0.122373192763,0.122936334331,0.123497021266,0.124055206891,0.124610845244,0.125163891019,0.12571429952,0.126262026627,0.126807028765,0.127349262885,0.127888686441,0.12842525738,0.128958934123,0.12948967556,0.130017441042,0.130542190369,0.131063883785,0.131582481977,0.132097946065,0.1326102376,0.133119318559,0.133625151343,0.134127698772,0.134626924083,0.135122790926,0.135615263363,0.136104305863,0.1365898833,0.137071960951,0.137550504495,0.138025480008,0.138496853959,0.138964593215,0.13942866503,0.13988903705,0.140345677304,0.140798554209,0.141247636562,0.141692893542,0.142134294706,0.142571809985,0.143005409689,0.143435064496,0.143860745456,0.144282423989,0.144700071881,0.145113661283,0.145523164709,0.145928555037,0.146329805501,0.146726889698,0.147119781577,0.147508455447,0.147892885967,0.148273048149,0.148648917357,0.149020469304,0.149387680048,0.149750525997,0.150108983901,0.150463030857,0.150812644301,0.151157802012,0.15149848211,0.15183466305,0.152166323629,0.152493442976,0.152816000558,0.153133976176,0.153447349962,0.153756102383,0.154060214234,0.154359666643,0.154654441062,0.154944519278,0.155229883398,0.15551051586,0.155786399427,0.156057517183,0.156323852539,0.156585389228,0.156842111304,0.157094003144,0.157341049443,0.157583235219,0.157820545806,0.158052966858,0.158280484347,0.158503084562,0.158720754106,0.158933479902,0.159141249186,0.159344049507,0.159541868732,0.159734695039,0.159922516919,0.160105323176,0.160283102928,0.160455845601,0.160623540935,0.160786178981,0.160943750097,0.161096244955,0.161243654533,0.161385970121,0.161523183316,0.161655286024,0.16178227046,0.161904129145,0.162020854908,0.162132440887,0.162238880524,0.162340167571,0.162436296083,0.162527260424,0.162613055261,0.162693675571,0.162769116632,0.162839374031,0.162904443657,0.162964321707,0.163019004682,0.163068489385,0.163112772928,0.163151852724,0.163185726494,0.163214392259,0.163237848347,0.16325609339,0.163269126324,0.163276946388,0.163279553127,0.163276946388,0.163269126324,0.16325609339,0.163237848347,0.163214392259,0.163185726494,0.163151852724,0.163112772928,0.163068489385,0.163019004682,0.162964321707,0.162904443657,0.162839374031,0.162769116632,0.162693675571,0.162613055261,0.162527260424,0.162436296083,0.162340167571,0.162238880524,0.162132440887,0.162020854908,0.161904129145,0.16178227046,0.161655286024,0.161523183316,0.161385970121,0.161243654533,0.161096244955,0.160943750097,0.160786178981,0.160623540935,0.160455845601,0.160283102928,0.160105323176,0.159922516919,0.159734695039,0.159541868732,0.159344049507,0.159141249186,0.158933479902,0.158720754106,0.158503084562,0.158280484347,0.158052966858,0.157820545806,0.157583235219,0.157341049443,0.157094003144,0.156842111304,0.156585389228,0.156323852539,0.156057517183,0.155786399427,0.155510515861,0.155229883398,0.154944519278,0.154654441062,0.154359666643,0.154060214235,0.153756102383,0.153447349962,0.153133976176,0.152816000558,0.152493442976,0.152166323629,0.15183466305,0.15149848211,0.151157802012,0.150812644301,0.150463030857,0.150108983901,0.149750525997,0.149387680048,0.149020469304,0.148648917358,0.148273048149,0.147892885967,0.147508455447,0.147119781577,0.146726889698,0.146329805501,0.145928555037,0.14552316471,0.145113661283,0.144700071881,0.144282423989,0.143860745456,0.143435064496,0.143005409689,0.142571809986,0.142134294706,0.141692893542,0.141247636562,0.140798554209,0.140345677304,0.13988903705,0.13942866503,0.138964593215,0.138496853959,0.138025480008,0.137550504496,0.137071960951,0.1365898833,0.136104305863,0.135615263363,0.135122790926,0.134626924083,0.134127698772,0.133625151343,0.133119318559,0.1326102376,0.132097946065,0.131582481977,0.131063883785,0.130542190369,0.130017441042,0.129489675561,0.128958934123,0.12842525738,0.127888686441,0.127349262885,0.126807028765,0.126262026627,0.12571429952,0.125163891019,0.124610845244,0.124055206891,0.123497021266,0.122936334332,0.122373192763,0.121807644018,0.121239736428,0.120669519313,0.120097043125,0.119522359633,0.118945522153,0.11836658585,0.117785608112,0.117202649024,0.11661777198,0.116031044452,0.115442538958,0.114852334302,0.114260517126,0.113667183868,0.113072443224,0.112476419217,0.111879255023,0.111281117684,0.110682203885,0.110082746931,0.109483025065,0.108883371171,0.10828418378,0.107685939103,0.107089203431,0.106494644852,0.105903042606,0.105315291863,0.104732401173,0.104155479758,0.103585712325,0.103024320527,0.102472512521,0.101931424939,0.101402064216,0.100885255664,0.100381608058,0.0998914988724,0.0994150811624,0.0989523089017,0.0985029745537,0.0980667516278,0.0976432358138,0.0972319803142,0.0968325233013,0.0964444073223,0.0960671916755,0.0957004593009,0.0953438197663,0.0949969097041,0.0946593917371,0.0943309526188,0.0940113010621,0.0937001655399,0.0933972922141,0.0931024430645,0.0928153942418,0.0925359346387,0.0922638646611,0.0919989951748,0.0917411466019,0.0914901481452,0.091245837118,0.0910080583614,0.0907766637364,0.0905515116752,0.0903324667843,0.0901193994893,0.0899121857164,0.0897107066032,0.0895148482362,0.0893245014103,0.0891395614079,0.0889599277947,0.0887855042312,0.0886161982968,0.0884519213261,0.0882925882567,0.0881381174856,0.0879884307356,0.0878434529293,0.0877031120711,0.0875673391361,0.087436067965,0.0873092351662,0.087186780022,0.087068644402,0.0869547726795,0.0868451116541,0.0867396104782,0.0866382205874,0.0865408956352,0.0864475914313,0.0863582658838,0.0862728789439,0.0861913925547,0.086113770603,0.0860399788731,0.0859699850047,0.0859037584524,0.0858412704483,0.0857824939672,0.0857274036936,0.0856759759914,0.0856281888759,0.0855840219875,0.0855434565681,0.0855064754386,0.0854730629792,0.0854432051115,0.0854168892817,0.0853941044465,0.0853748410604,0.0853590910649,0.0853468478789,0.0853381063916,0.0853328629567,0.0853311153878,0.085333562149,0.0853419526262,0.0853533184261,0.0853652143386,0.0853757157119}, "none");
-    return s(arg, der);
+    static const static_spline<5, false> s({-0.0259916157659,-0.0103954212891,-0.00519762315263,3.90788876463e-12,0.00519762315912,0.0103954212943,0.0155935694044,0.0207922425284,0.0259916157683,0.0311918643098,0.0363931634432,0.0415956885855,0.0467996153011,0.0520051193228,0.057212376575,0.0624215631947,0.0676328555542,0.0728464302834,0.0780624642933,0.0832811347986,0.0885026193425,0.0937270958193,0.0989547425011,0.104185738062,0.109420261603,0.114658492683,0.11990061134,0.125146798126,0.130397234132,0.13565210102,0.140911581057,0.146175857146,0.151445112863,0.156719532496,0.161999301082,0.167284604454,0.172575629286,0.177872563145,0.18317559455,0.188484913032,0.193800709207,0.199123174859,0.204452503035,0.209788888151,0.215132526121,0.220483614515,0.225842352735,0.231208942242,0.236583586821,0.241966492913,0.247357870021,0.252757931209,0.258166893735,0.263584979824,0.269012417648,0.274449442556,0.27989629861,0.285353240534,0.290820536161,0.296298469525,0.301787344767,0.307287491051,0.312799268787,0.318323077444,0.323859365398,0.329408642269,0.334971494348,0.340548603795,0.346140772367,0.351748950529,0.357374272758,0.363018099761,0.368682067945,0.374368145838,0.380078695948,0.385816538641,0.391585011859,0.3973880167,0.403230034357,0.40911609536,0.415051679068,0.421042522436,0.427094325316,0.433212357182,0.439400996548,0.445663263653,0.452000428183,0.458411774662,0.464894582216,0.471444328387,0.478055075195,0.484719959222,0.491431697403,0.498183035175,0.504967092659,0.511777594916,0.51860899524,0.525456513044,0.532316111535,0.539184438254,0.546058746738,0.552936812224,0.559816849632,0.566697438486,0.573577456889,0.580456025089,0.587332458234,0.594206227404,0.601076927845,0.607944253305,0.614807975425,0.621667927291,0.628523990346,0.635376084013,0.642224157491,0.649068183277,0.655908152051,0.662744068666,0.669575948971,0.676403817334,0.68322770468,0.690047646961,0.696863683945,0.703675858278,0.710484214733,0.717288799635,0.724089660402,0.730886845185,0.737680402592,0.744470381466,0.751256830716,0.75803979918,0.764819335526,0.771595488164,0.77836830519,0.785137834333,0.79190412292,0.798667217849,0.805427165566,0.812184012049,0.8189378028,0.825688582834,0.832436396675,0.839181288356,0.845923301413,0.852662478891,0.859398863341,0.866132496825,0.872863420918,0.879591676711,0.886317304817,0.893040345375,0.899760838053,0.906478822055,0.913194336127,0.919907418558,0.926618107191,0.933326439425,0.940032452221,0.946736182112,0.953437665201,0.960136937173,0.966834033301,0.973528988446,0.98022183707,0.986912613237,0.993601350622,1.00028808252,1.00697284183,1.0136556611,1.0203365725,1.02701560784,1.03369279858,1.04036817582,1.04704177032,1.05371361251,1.06038373249,1.06705216001,1.07371892452,1.08038405516,1.08704758073,1.09370952976,1.10036993046,1.10702881075,1.11368619826,1.12034212036,1.1269966041,1.13364967629,1.14030136346,1.14695169189,1.1536006876,1.16024837633,1.16689478361,1.17353993472,1.18018385468,1.18682656831,1.19346810017,1.20010847463,1.20674771583,1.21338584768,1.2200228939,1.226658878,1.2332938233,1.23992775291,1.24656068976,1.25319265659,1.25982367596,1.26645377025,1.27308296168,1.27971127228,1.28633872393,1.29296533835,1.29959113711,1.3062161416,1.31284037309,1.31946385271,1.32608660142,1.33270864008,1.3393299894,1.34595066995,1.35257070221,1.3591901065,1.36580890306,1.37242711201,1.37904475333,1.38566184694,1.39227841262,1.39889447009,1.40551003895,1.41212513872,1.41873978883,1.42535400863,1.43196781739,1.43858123431,1.4451942785,1.45180696902,1.45841932487,1.46503136498,1.4716431082,1.47825457336,1.48486577923,1.49147674452,1.49808748791,1.50469802804,1.51130838349,1.51791857283,1.5245286146,1.5311385273,1.53774832941,1.54435803939,1.55096767569,1.55757725675,1.56418680098,1.57079632679,1.57740585261,1.58401539684,1.5906249779,1.5972346142,1.60384432418,1.61045412629,1.61706403899,1.62367408076,1.6302842701,1.63689462555,1.64350516567,1.65011590907,1.65672687436,1.66333808023,1.66994954539,1.67656128861,1.68317332872,1.68978568456,1.69639837509,1.70301141928,1.7096248362,1.71623864496,1.72285286476,1.72946751487,1.73608261464,1.7426981835,1.74931424097,1.75593080665,1.76254790026,1.76916554158,1.77578375052,1.78240254709,1.78902195138,1.79564198364,1.80226266419,1.80888401351,1.81550605217,1.82212880088,1.8287522805,1.83537651199,1.84200151648,1.84862731524,1.85525392966,1.86188138131,1.86850969191,1.87513888334,1.88176897763,1.888399997,1.89503196383,1.90166490068,1.90829883029,1.91493377559,1.92156975969,1.92820680591,1.93484493776,1.94148417896,1.94812455342,1.95476608528,1.96140879891,1.96805271887,1.97469786998,1.98134427726,1.98799196599,1.99464096169,2.00129129013,2.0079429773,2.01459604949,2.02125053323,2.02790645533,2.03456384284,2.04122272313,2.04788312383,2.05454507286,2.06120859843,2.06787372907,2.07454049358,2.0812089211,2.08787904108,2.09455088327,2.10122447777,2.10789985501,2.11457704575,2.12125608109,2.12793699249,2.13461981176,2.14130457107,2.14799130297,2.15468004035,2.16137081652,2.16806366514,2.17475862029,2.18145571642,2.18815498839,2.19485647148,2.20156020137,2.20826621417,2.2149745464,2.22168523503,2.22839831746,2.23511383153,2.24183181554,2.24855230821,2.25527534877,2.26200097688,2.26872923267,2.27546015676,2.28219379025,2.2889301747,2.29566935218,2.30241136523,2.30915625691,2.31590407076,2.32265485079,2.32940864154,2.33616548802,2.34292543574,2.34968853067,2.35645481926,2.3632243484,2.36999716543,2.37677331806,2.38355285441,2.39033582287,2.39712227212,2.403912251,2.4107058084,2.41750299319,2.42430385395,2.43110843886,2.43791679531,2.44472896964,2.45154500663,2.45836494891,2.46518883626,2.47201670462,2.47884858492,2.48568450154,2.49252447031,2.4993684961,2.50621656958,2.51306866324,2.5199247263,2.52678467816,2.53364840028,2.54051572574,2.54738642619,2.55426019536,2.5611366285,2.5680151967,2.5748952151,2.58177580396,2.58865584137,2.59553390685,2.60240821534,2.60927654205,2.61613614055,2.62298365835,2.62981505867,2.63662556093,2.64340961841,2.65016095619,2.65687269437,2.66353757839,2.6701483252,2.67669807137,2.68318087893,2.68959222541,2.69592938994,2.70219165704,2.70838029641,2.71449832827,2.72055013115,2.72654097452,2.73247655823,2.73836261923,2.74420463689,2.75000764173,2.75577611495,2.76151395764,2.76722450775,2.77291058565,2.77857455383,2.78421838083,2.78984370306,2.79545188122,2.80104404979,2.80662115924,2.81218401132,2.81773328819,2.82326957615,2.8287933848,2.83430516254,2.83980530882,2.84529418406,2.85077211743,2.85623941306,2.86169635498,2.86714321103,2.87258023594,2.87800767377,2.88342575985,2.88883472238,2.89423478357,2.89962616068,2.90500906677,2.91038371135,2.91575030085,2.92110903907,2.92646012747,2.93180376544,2.93714015055,2.94246947873,2.94779194438,2.95310774056,2.95841705904,2.96372009044,2.9690170243,2.97430804914,2.97959335251,2.98487312109,2.99014754073,2.99541679644,3.00068107253,3.00594055257,3.01119541946,3.01644585546,3.02169204225,3.02693416091,3.03217239199,3.03740691553,3.04263791109,3.04786555777,3.05309003425,3.05831151879,3.0635301893,3.06874622331,3.07395979804,3.0791710904,3.08438027702,3.08958753427,3.09479303829,3.09999696501,3.10519949015,3.11040078928,3.11560103782,3.12080041106,3.12599908419,3.1311972323,3.13639503044,3.14159265359,3.14679027675,3.15198807488,3.15718622299,3.16238489612,3.16758426936,3.1727845179,3.17798581703,3.18318834218,3.18839226889,3.19359777291,3.19880503016,3.20401421678,3.20922550914,3.21443908387,3.21965511788,3.22487378839,3.23009527293,3.23531974941,3.24054739609,3.24577839165,3.25101291519,3.25625114627,3.26149326493,3.26673945172,3.27198988772,3.27724475461,3.28250423465,3.28776851074,3.29303776645,3.29831218609,3.30359195467,3.30887725804,3.31416828288,3.31946521674,3.32476824814,3.33007756662,3.3353933628,3.34071582845,3.34604515663,3.35138154174,3.35672517971,3.3620762681,3.36743500632,3.37280159583,3.37817624041,3.3835591465,3.38895052361,3.3943505848,3.39975954732,3.40517763341,3.41060507124,3.41604209615,3.4214889522,3.42694589412,3.43241318975,3.43789112312,3.44337999836,3.44888014464,3.45439192238,3.45991573103,3.46545201899,3.47100129586,3.47656414794,3.48214125738,3.48773342596,3.49334160412,3.49896692635,3.50461075335,3.51027472153,3.51596079943,3.52167134954,3.52740919223,3.53317766545,3.53898067029,3.54482268795,3.55070874895,3.55664433266,3.56263517603,3.56868697891,3.57480501077,3.58099365014,3.58725591724,3.59359308177,3.60000442825,3.60648723581,3.61303698198,3.61964772878,3.62631261281,3.63302435099,3.63977568876,3.64655974625,3.65337024851,3.66020164883,3.66704916663,3.67390876512,3.68077709184,3.68765140033,3.69452946581,3.70140950322,3.70829009208,3.71517011048,3.72204867868,3.72892511182,3.73579888099,3.74266958144,3.74953690689,3.75640062901,3.76326058088,3.77011664394,3.7769687376,3.78381681108,3.79066083687,3.79750080564,3.80433672226,3.81116860256,3.81799647092,3.82482035827,3.83164030055,3.83845633753,3.84526851187,3.85207686832,3.85888145323,3.86568231399,3.87247949877,3.87927305618,3.88606303506,3.89284948431,3.89963245277,3.90641198912,3.91318814175,3.91996095878,3.92673048792,3.93349677651,3.94025987144,3.94701981916,3.95377666564,3.96053045639,3.96728123642,3.97402905026,3.98077394195,3.987515955,3.99425513248,4.00099151693,4.00772515042,4.01445607451,4.0211843303,4.02790995841,4.03463299896,4.04135349164,4.04807147564,4.05478698972,4.06150007215,4.06821076078,4.07491909301,4.08162510581,4.0883288357,4.09503031879,4.10172959076,4.10842668689,4.11512164204,4.12181449066,4.12850526683,4.13519400421,4.14188073611,4.14856549542,4.15524831469,4.16192922609,4.16860826143,4.17528545217,4.18196082941,4.18863442391,4.1953062661,4.20197638608,4.2086448136,4.21531157811,4.22197670875,4.22864023432,4.23530218335,4.24196258405,4.24862146434,4.25527885185,4.26193477394,4.26858925769,4.27524232988,4.28189401705,4.28854434548,4.29519334119,4.30184102992,4.3084874372,4.31513258831,4.32177650827,4.3284192219,4.33506075376,4.34170112822,4.34834036942,4.35497850127,4.36161554749,4.36825153159,4.37488647689,4.3815204065,4.38815334335,4.39478531018,4.40141632955,4.40804642384,4.41467561527,4.42130392587,4.42793137752,4.43455799194,4.4411837907,4.44780879519,4.45443302668,4.4610565063,4.46767925501,4.47430129367,4.48092264299,4.48754332354,4.4941633558,4.50078276009,4.50740155665,4.5140197656,4.52063740692,4.52725450053,4.53387106621,4.54048712368,4.54710269254,4.55371779231,4.56033244242,4.56694666222,4.57356047098,4.5801738879,4.58678693209,4.59339962261,4.60001197846,4.60662401857,4.61323576179,4.61984722695,4.62645843282,4.63306939811,4.6396801415,4.64629068163,4.65290103708,4.65951122642,4.66612126819,4.67273118089,4.67934098299,4.68595069298,4.69256032928,4.69916991034,4.70577945457,4.71238898038,4.7189985062,4.72560805043,4.73221763149,4.73882726779,4.74543697777,4.75204677988,4.75865669258,4.76526673435,4.77187692369,4.77848727914,4.78509781926,4.79170856266,4.79831952795,4.80493073382,4.81154219898,4.8181539422,4.82476598231,4.83137833815,4.83799102868,4.84460407287,4.85121748979,4.85783129855,4.86444551835,4.87106016846,4.87767526823,4.88429083709,4.89090689456,4.89752346024,4.90414055385,4.91075819517,4.91737640411,4.92399520068,4.93061460497,4.93723463723,4.94385531778,4.9504766671,4.95709870576,4.96372145447,4.97034493409,4.97696916558,4.98359417007,4.99021996883,4.99684658325,5.0034740349,5.0101023455,5.01673153693,5.02336163122,5.02999265059,5.03662461742,5.04325755427,5.04989148388,5.05652642918,5.06316241328,5.0697994595,5.07643759135,5.08307683255,5.08971720701,5.09635873887,5.1030014525,5.10964537246,5.11629052357,5.12293693085,5.12958461958,5.13623361528,5.14288394372,5.14953563089,5.15618870308,5.16284318682,5.16949910892,5.17615649643,5.18281537672,5.18947577742,5.19613772645,5.20280125202,5.20946638266,5.21613314717,5.22280157469,5.22947169467,5.23614353686,5.24281713136,5.2494925086,5.25616969934,5.26284873468,5.26952964608,5.27621246535,5.28289722466,5.28958395656,5.29627269394,5.30296347011,5.30965631873,5.31635127388,5.32304837001,5.32974764198,5.33644912507,5.34315285496,5.34985886775,5.35656719999,5.36327788862,5.36999097105,5.37670648512,5.38342446913,5.3901449618,5.39686800236,5.40359363047,5.41032188626,5.41705281035,5.42378644384,5.43052282829,5.43726200577,5.44400401882,5.4507489105,5.45749672435,5.46424750438,5.47100129513,5.47775814161,5.48451808933,5.49128118426,5.49804747285,5.50481700199,5.51158981902,5.51836597165,5.525145508,5.53192847646,5.53871492571,5.54550490459,5.55229846199,5.55909564678,5.56589650754,5.57270109245,5.5795094489,5.58632162323,5.59313766022,5.5999576025,5.60678148985,5.61360935821,5.62044123851,5.62727715513,5.6341171239,5.64096114969,5.64780922317,5.65466131683,5.66151737989,5.66837733175,5.67524105387,5.68210837933,5.68897907978,5.69585284895,5.70272928209,5.70960785029,5.71648786869,5.72336845755,5.73024849496,5.73712656044,5.74400086893,5.75086919564,5.75772879414,5.76457631194,5.77140771226,5.77821821452,5.785002272,5.79175360978,5.79846534796,5.80513023198,5.81174097879,5.81829072496,5.82477353252,5.831184879,5.83752204353,5.84378431063,5.84997295,5.85609098186,5.86214278474,5.86813362811,5.87406921182,5.87995527282,5.88579729048,5.89160029532,5.89736876854,5.90310661123,5.90881716134,5.91450323923,5.92016720742,5.92581103442,5.93143635665,5.93704453481,5.94263670338,5.94821381283,5.95377666491,5.95932594178,5.96486222974,5.97038603839,5.97589781613,5.98139796241,5.98688683765,5.99236477102,5.99783206665,6.00328900857,6.00873586462,6.01417288953,6.01960032736,6.02501841344,6.03042737597,6.03582743716,6.04121881427,6.04660172036,6.05197636494,6.05734295444,6.06270169266,6.06805278106,6.07339641903,6.07873280414,6.08406213232,6.08938459797,6.09470039415,6.10000971263,6.10531274403,6.11060967789,6.11590070273,6.1211860061,6.12646577468,6.13174019432,6.13700945003,6.14227372612,6.14753320616,6.15278807305,6.15803850905,6.16328469584,6.1685268145,6.17376504558,6.17899956912,6.18423056468,6.18945821136,6.19468268784,6.19990417238,6.20512284289,6.2103388769,6.21555245163,6.22076374399,6.22597293061,6.23118018786,6.23638569188,6.2415896186,6.24679214374,6.25199344287,6.25719369141,6.26239306465,6.26759173778,6.27278988589,6.27798768403,6.28318530718,6.28838293034,6.29358072847,6.30917692295}, {0.085375715712,0.0853652143387,0.0853533184262,0.0853419526262,0.085333562149,0.0853311153878,0.0853328629567,0.0853381063916,0.0853468478788,0.0853590910648,0.0853748410603,0.0853941044464,0.0854168892816,0.0854432051114,0.0854730629791,0.0855064754385,0.085543456568,0.0855840219874,0.0856281888757,0.0856759759912,0.0857274036934,0.0857824939671,0.0858412704482,0.0859037584522,0.0859699850046,0.086039978873,0.0861137706029,0.0861913925546,0.0862728789437,0.0863582658837,0.0864475914312,0.086540895635,0.0866382205872,0.0867396104781,0.086845111654,0.0869547726793,0.0870686444019,0.0871867800219,0.087309235166,0.0874360679649,0.0875673391359,0.087703112071,0.0878434529292,0.0879884307355,0.0881381174855,0.0882925882566,0.088451921326,0.0886161982966,0.0887855042311,0.0889599277946,0.0891395614077,0.0893245014102,0.0895148482361,0.0897107066031,0.0899121857163,0.0901193994892,0.0903324667841,0.0905515116751,0.0907766637363,0.0910080583613,0.0912458371178,0.0914901481451,0.0917411466018,0.0919989951746,0.092263864661,0.0925359346386,0.0928153942416,0.0931024430643,0.0933972922139,0.0937001655398,0.0940113010619,0.0943309526186,0.0946593917369,0.094996909704,0.0953438197662,0.0957004593008,0.0960671916754,0.0964444073222,0.0968325233012,0.0972319803141,0.0976432358137,0.0980667516277,0.0985029745536,0.0989523089016,0.0994150811622,0.0998914988723,0.100381608058,0.100885255664,0.101402064216,0.101931424939,0.102472512521,0.103024320527,0.103585712325,0.104155479758,0.104732401173,0.105315291862,0.105903042605,0.106494644852,0.107089203431,0.107685939103,0.10828418378,0.10888337117,0.109483025065,0.110082746931,0.110682203885,0.111281117684,0.111879255022,0.112476419217,0.113072443223,0.113667183868,0.114260517126,0.114852334302,0.115442538958,0.116031044451,0.11661777198,0.117202649024,0.117785608112,0.11836658585,0.118945522153,0.119522359633,0.120097043125,0.120669519313,0.121239736428,0.121807644018,0.122373192763,0.122936334331,0.123497021266,0.124055206891,0.124610845244,0.125163891019,0.12571429952,0.126262026627,0.126807028765,0.127349262885,0.127888686441,0.12842525738,0.128958934123,0.12948967556,0.130017441042,0.130542190369,0.131063883785,0.131582481977,0.132097946065,0.1326102376,0.133119318559,0.133625151343,0.134127698772,0.134626924083,0.135122790926,0.135615263363,0.136104305863,0.1365898833,0.137071960951,0.137550504495,0.138025480008,0.138496853959,0.138964593215,0.13942866503,0.13988903705,0.140345677304,0.140798554209,0.141247636562,0.141692893542,0.142134294706,0.142571809985,0.143005409689,0.143435064496,0.143860745456,0.144282423989,0.144700071881,0.145113661283,0.145523164709,0.145928555037,0.146329805501,0.146726889698,0.147119781577,0.147508455447,0.147892885967,0.148273048149,0.148648917357,0.149020469304,0.149387680048,0.149750525997,0.150108983901,0.150463030857,0.150812644301,0.151157802012,0.15149848211,0.15183466305,0.152166323629,0.152493442976,0.152816000558,0.153133976176,0.153447349962,0.153756102383,0.154060214234,0.154359666643,0.154654441062,0.154944519278,0.155229883398,0.15551051586,0.155786399427,0.156057517183,0.156323852539,0.156585389228,0.156842111304,0.157094003144,0.157341049443,0.157583235219,0.157820545806,0.158052966858,0.158280484347,0.158503084562,0.158720754106,0.158933479902,0.159141249186,0.159344049507,0.159541868732,0.159734695039,0.159922516919,0.160105323176,0.160283102928,0.160455845601,0.160623540935,0.160786178981,0.160943750097,0.161096244955,0.161243654533,0.161385970121,0.161523183316,0.161655286024,0.16178227046,0.161904129145,0.162020854908,0.162132440887,0.162238880524,0.162340167571,0.162436296083,0.162527260424,0.162613055261,0.162693675571,0.162769116632,0.162839374031,0.162904443657,0.162964321707,0.163019004682,0.163068489385,0.163112772928,0.163151852724,0.163185726494,0.163214392259,0.163237848347,0.16325609339,0.163269126324,0.163276946388,0.163279553127,0.163276946388,0.163269126324,0.16325609339,0.163237848347,0.163214392259,0.163185726494,0.163151852724,0.163112772928,0.163068489385,0.163019004682,0.162964321707,0.162904443657,0.162839374031,0.162769116632,0.162693675571,0.162613055261,0.162527260424,0.162436296083,0.162340167571,0.162238880524,0.162132440887,0.162020854908,0.161904129145,0.16178227046,0.161655286024,0.161523183316,0.161385970121,0.161243654533,0.161096244955,0.160943750097,0.160786178981,0.160623540935,0.160455845601,0.160283102928,0.160105323176,0.159922516919,0.159734695039,0.159541868732,0.159344049507,0.159141249186,0.158933479902,0.158720754106,0.158503084562,0.158280484347,0.158052966858,0.157820545806,0.157583235219,0.157341049443,0.157094003144,0.156842111304,0.156585389228,0.156323852539,0.156057517183,0.155786399427,0.155510515861,0.155229883398,0.154944519278,0.154654441062,0.154359666643,0.154060214235,0.153756102383,0.153447349962,0.153133976176,0.152816000558,0.152493442976,0.152166323629,0.15183466305,0.15149848211,0.151157802012,0.150812644301,0.150463030857,0.150108983901,0.149750525997,0.149387680048,0.149020469304,0.148648917358,0.148273048149,0.147892885967,0.147508455447,0.147119781577,0.146726889698,0.146329805501,0.145928555037,0.14552316471,0.145113661283,0.144700071881,0.144282423989,0.143860745456,0.143435064496,0.143005409689,0.142571809986,0.142134294706,0.141692893542,0.141247636562,0.140798554209,0.140345677304,0.13988903705,0.13942866503,0.138964593215,0.138496853959,0.138025480008,0.137550504496,0.137071960951,0.1365898833,0.136104305863,0.135615263363,0.135122790926,0.134626924083,0.134127698772,0.133625151343,0.133119318559,0.1326102376,0.132097946065,0.131582481977,0.131063883785,0.130542190369,0.130017441042,0.129489675561,0.128958934123,0.12842525738,0.127888686441,0.127349262885,0.126807028765,0.126262026627,0.12571429952,0.125163891019,0.124610845244,0.124055206891,0.123497021266,0.122936334332,0.122373192763,0.121807644018,0.121239736428,0.120669519313,0.120097043125,0.119522359633,0.118945522153,0.11836658585,0.117785608112,0.117202649024,0.11661777198,0.116031044452,0.115442538958,0.114852334302,0.114260517126,0.113667183868,0.113072443224,0.112476419217,0.111879255023,0.111281117684,0.110682203885,0.110082746931,0.109483025065,0.108883371171,0.10828418378,0.107685939103,0.107089203431,0.106494644852,0.105903042606,0.105315291863,0.104732401173,0.104155479758,0.103585712325,0.103024320527,0.102472512521,0.101931424939,0.101402064216,0.100885255664,0.100381608058,0.0998914988724,0.0994150811624,0.0989523089017,0.0985029745537,0.0980667516278,0.0976432358138,0.0972319803142,0.0968325233013,0.0964444073223,0.0960671916755,0.0957004593009,0.0953438197663,0.0949969097041,0.0946593917371,0.0943309526188,0.0940113010621,0.0937001655399,0.0933972922141,0.0931024430645,0.0928153942418,0.0925359346387,0.0922638646611,0.0919989951748,0.0917411466019,0.0914901481452,0.091245837118,0.0910080583614,0.0907766637364,0.0905515116752,0.0903324667843,0.0901193994893,0.0899121857164,0.0897107066032,0.0895148482362,0.0893245014103,0.0891395614079,0.0889599277947,0.0887855042312,0.0886161982968,0.0884519213261,0.0882925882567,0.0881381174856,0.0879884307356,0.0878434529293,0.0877031120711,0.0875673391361,0.087436067965,0.0873092351662,0.0871867800221,0.087068644402,0.0869547726795,0.0868451116541,0.0867396104782,0.0866382205874,0.0865408956352,0.0864475914313,0.0863582658838,0.0862728789439,0.0861913925547,0.086113770603,0.0860399788731,0.0859699850047,0.0859037584524,0.0858412704483,0.0857824939672,0.0857274036936,0.0856759759914,0.0856281888759,0.0855840219875,0.0855434565681,0.0855064754386,0.0854730629792,0.0854432051115,0.0854168892817,0.0853941044465,0.0853748410604,0.0853590910649,0.0853468478789,0.0853381063916,0.0853328629567,0.0853311153878,0.0853328629567,0.0853381063916,0.0853468478788,0.0853590910648,0.0853748410603,0.0853941044464,0.0854168892816,0.0854432051114,0.0854730629791,0.0855064754385,0.085543456568,0.0855840219874,0.0856281888757,0.0856759759912,0.0857274036934,0.0857824939671,0.0858412704482,0.0859037584522,0.0859699850046,0.086039978873,0.0861137706029,0.0861913925546,0.0862728789437,0.0863582658837,0.0864475914312,0.086540895635,0.0866382205872,0.0867396104781,0.086845111654,0.0869547726793,0.0870686444019,0.0871867800219,0.087309235166,0.0874360679649,0.0875673391359,0.087703112071,0.0878434529291,0.0879884307355,0.0881381174855,0.0882925882566,0.088451921326,0.0886161982966,0.0887855042311,0.0889599277946,0.0891395614077,0.0893245014102,0.0895148482361,0.0897107066031,0.0899121857163,0.0901193994892,0.0903324667841,0.0905515116751,0.0907766637363,0.0910080583613,0.0912458371178,0.0914901481451,0.0917411466017,0.0919989951746,0.092263864661,0.0925359346386,0.0928153942416,0.0931024430643,0.0933972922139,0.0937001655398,0.0940113010619,0.0943309526186,0.0946593917369,0.094996909704,0.0953438197662,0.0957004593008,0.0960671916754,0.0964444073222,0.0968325233012,0.0972319803141,0.0976432358136,0.0980667516277,0.0985029745536,0.0989523089016,0.0994150811622,0.0998914988723,0.100381608058,0.100885255664,0.101402064216,0.101931424939,0.102472512521,0.103024320527,0.103585712325,0.104155479758,0.104732401173,0.105315291862,0.105903042605,0.106494644852,0.107089203431,0.107685939103,0.10828418378,0.10888337117,0.109483025065,0.110082746931,0.110682203885,0.111281117684,0.111879255022,0.112476419217,0.113072443223,0.113667183868,0.114260517126,0.114852334302,0.115442538958,0.116031044451,0.11661777198,0.117202649024,0.117785608112,0.11836658585,0.118945522153,0.119522359633,0.120097043125,0.120669519313,0.121239736428,0.121807644018,0.122373192763,0.122936334331,0.123497021266,0.124055206891,0.124610845244,0.125163891019,0.12571429952,0.126262026627,0.126807028765,0.127349262885,0.127888686441,0.12842525738,0.128958934123,0.12948967556,0.130017441042,0.130542190369,0.131063883785,0.131582481977,0.132097946065,0.1326102376,0.133119318559,0.133625151343,0.134127698772,0.134626924083,0.135122790926,0.135615263363,0.136104305863,0.1365898833,0.137071960951,0.137550504495,0.138025480008,0.138496853959,0.138964593215,0.13942866503,0.13988903705,0.140345677304,0.140798554209,0.141247636562,0.141692893542,0.142134294706,0.142571809985,0.143005409689,0.143435064496,0.143860745456,0.144282423989,0.144700071881,0.145113661283,0.145523164709,0.145928555037,0.146329805501,0.146726889698,0.147119781577,0.147508455447,0.147892885967,0.148273048149,0.148648917357,0.149020469304,0.149387680048,0.149750525997,0.150108983901,0.150463030857,0.150812644301,0.151157802012,0.15149848211,0.15183466305,0.152166323629,0.152493442976,0.152816000558,0.153133976176,0.153447349962,0.153756102383,0.154060214234,0.154359666643,0.154654441062,0.154944519278,0.155229883398,0.15551051586,0.155786399427,0.156057517183,0.156323852539,0.156585389228,0.156842111304,0.157094003144,0.157341049443,0.157583235219,0.157820545806,0.158052966858,0.158280484347,0.158503084562,0.158720754106,0.158933479902,0.159141249186,0.159344049507,0.159541868732,0.159734695039,0.159922516919,0.160105323176,0.160283102928,0.160455845601,0.160623540935,0.160786178981,0.160943750097,0.161096244955,0.161243654533,0.161385970121,0.161523183316,0.161655286024,0.16178227046,0.161904129145,0.162020854908,0.162132440887,0.162238880524,0.162340167571,0.162436296083,0.162527260424,0.162613055261,0.162693675571,0.162769116632,0.162839374031,0.162904443657,0.162964321707,0.163019004682,0.163068489385,0.163112772928,0.163151852724,0.163185726494,0.163214392259,0.163237848347,0.16325609339,0.163269126324,0.163276946388,0.163279553127,0.163276946388,0.163269126324,0.16325609339,0.163237848347,0.163214392259,0.163185726494,0.163151852724,0.163112772928,0.163068489385,0.163019004682,0.162964321707,0.162904443657,0.162839374031,0.162769116632,0.162693675571,0.162613055261,0.162527260424,0.162436296083,0.162340167571,0.162238880524,0.162132440887,0.162020854908,0.161904129145,0.16178227046,0.161655286024,0.161523183316,0.161385970121,0.161243654533,0.161096244955,0.160943750097,0.160786178981,0.160623540935,0.160455845601,0.160283102928,0.160105323176,0.159922516919,0.159734695039,0.159541868732,0.159344049507,0.159141249186,0.158933479902,0.158720754106,0.158503084562,0.158280484347,0.158052966858,0.157820545806,0.157583235219,0.157341049443,0.157094003144,0.156842111304,0.156585389228,0.156323852539,0.156057517183,0.155786399427,0.155510515861,0.155229883398,0.154944519278,0.154654441062,0.154359666643,0.154060214235,0.153756102383,0.153447349962,0.153133976176,0.152816000558,0.152493442976,0.152166323629,0.15183466305,0.15149848211,0.151157802012,0.150812644301,0.150463030857,0.150108983901,0.149750525997,0.149387680048,0.149020469304,0.148648917358,0.148273048149,0.147892885967,0.147508455447,0.147119781577,0.146726889698,0.146329805501,0.145928555037,0.14552316471,0.145113661283,0.144700071881,0.144282423989,0.143860745456,0.143435064496,0.143005409689,0.142571809986,0.142134294706,0.141692893542,0.141247636562,0.140798554209,0.140345677304,0.13988903705,0.13942866503,0.138964593215,0.138496853959,0.138025480008,0.137550504496,0.137071960951,0.1365898833,0.136104305863,0.135615263363,0.135122790926,0.134626924083,0.134127698772,0.133625151343,0.133119318559,0.1326102376,0.132097946065,0.131582481977,0.131063883785,0.130542190369,0.130017441042,0.129489675561,0.128958934123,0.12842525738,0.127888686441,0.127349262885,0.126807028765,0.126262026627,0.12571429952,0.125163891019,0.124610845244,0.124055206891,0.123497021266,0.122936334332,0.122373192763,0.121807644018,0.121239736428,0.120669519313,0.120097043125,0.119522359633,0.118945522153,0.11836658585,0.117785608112,0.117202649024,0.11661777198,0.116031044452,0.115442538958,0.114852334302,0.114260517126,0.113667183868,0.113072443224,0.112476419217,0.111879255023,0.111281117684,0.110682203885,0.110082746931,0.109483025065,0.108883371171,0.10828418378,0.107685939103,0.107089203431,0.106494644852,0.105903042606,0.105315291863,0.104732401173,0.104155479758,0.103585712325,0.103024320527,0.102472512521,0.101931424939,0.101402064216,0.100885255664,0.100381608058,0.0998914988724,0.0994150811624,0.0989523089017,0.0985029745537,0.0980667516278,0.0976432358138,0.0972319803142,0.0968325233013,0.0964444073223,0.0960671916755,0.0957004593009,0.0953438197663,0.0949969097041,0.0946593917371,0.0943309526188,0.0940113010621,0.0937001655399,0.0933972922141,0.0931024430645,0.0928153942418,0.0925359346387,0.0922638646611,0.0919989951748,0.0917411466019,0.0914901481452,0.091245837118,0.0910080583614,0.0907766637364,0.0905515116752,0.0903324667843,0.0901193994893,0.0899121857164,0.0897107066032,0.0895148482362,0.0893245014103,0.0891395614079,0.0889599277947,0.0887855042312,0.0886161982968,0.0884519213261,0.0882925882567,0.0881381174856,0.0879884307356,0.0878434529293,0.0877031120711,0.0875673391361,0.087436067965,0.0873092351662,0.087186780022,0.087068644402,0.0869547726795,0.0868451116541,0.0867396104782,0.0866382205874,0.0865408956352,0.0864475914313,0.0863582658838,0.0862728789439,0.0861913925547,0.086113770603,0.0860399788731,0.0859699850047,0.0859037584524,0.0858412704483,0.0857824939672,0.0857274036936,0.0856759759914,0.0856281888759,0.0855840219875,0.0855434565681,0.0855064754386,0.0854730629792,0.0854432051115,0.0854168892817,0.0853941044465,0.0853748410604,0.0853590910649,0.0853468478789,0.0853381063916,0.0853328629567,0.0853311153878,0.085333562149,0.0853419526262,0.0853533184261,0.0853652143386,0.0853757157119});
+    return s.eval_all<maxder>(arg, rho);
 }
 
 // inline double spline_kz(double arg, int der=0)
@@ -56,28 +58,57 @@ inline double spline_rho(double arg, int der=0)
 //     return s(arg, der);
 // }
 
-inline Mat2x2 sub_M(double const& theta, double const& phi)
+// rho holds the value and derivatives of spline_rho at phi
+inline Mat2x2 sub_M(double const& theta, double const& phi, double const* rho)
 {
-    auto rho_val = spline_rho(phi);
-    auto rho_d1_val = spline_rho(phi, 1);
+    auto rho_val = rho[0];
+    auto rho_d1_val = rho[1];
     return Mat2x2(0.003*pow(rho_val, 2)*pow(sin(phi), 2) + 0.003*pow(rho_val, 2)*pow(cos(phi), 2) + 0.0015816125, 0.003*sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2))*(-rho_val*(rho_d1_val*sin(phi) + rho_val*cos(phi))*cos(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + rho_val*(rho_d1_val*cos(phi) - rho_val*sin(phi))*sin(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) - 0.0183347079152333), 0.003*sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2))*(-rho_val*(rho_d1_val*sin(phi) + rho_val*cos(phi))*cos(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + rho_val*(rho_d1_val*cos(phi) - rho_val*sin(phi))*sin(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) - 0.0183347079152333), 0.00793951612903226*pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + 0.00793951612903226*pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2));
 }
 
-inline Mat2x2 sub_C(double const& theta, double const& phi, double const& dtheta, double const& dphi)
+inline Mat2x2 sub_C(double const& theta, double const& phi, double const& dtheta, double const& dphi, double const* rho)
 {
-    auto rho_val = spline_rho(phi);
-    auto rho_d1_val = spline_rho(phi, 1);
-    auto rho_d2_val = spline_rho(phi, 2);
+    auto rho_val = rho[0];
+    auto rho_d1_val = rho[1];
+    auto rho_d2_val = rho[2];
     return Mat2x2(0.003*dphi*(rho_val*(rho_d1_val*sin(phi) + rho_val*cos(phi))*sin(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + rho_val*(rho_d1_val*cos(phi) - rho_val*sin(phi))*cos(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)))*sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)), 0.003*dphi*(((rho_d1_val*sin(phi) + rho_val*cos(phi))*(2*rho_d1_val*cos(phi) + rho_d2_val*sin(phi) - rho_val*sin(phi)) + (-rho_d1_val*cos(phi) + rho_val*sin(phi))*(2*rho_d1_val*sin(phi) - rho_d2_val*cos(phi) + rho_val*cos(phi)))*(-rho_val*(rho_d1_val*sin(phi) + rho_val*cos(phi))*cos(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + rho_val*(rho_d1_val*cos(phi) - rho_val*sin(phi))*sin(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) - 0.0183347079152333)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + (-rho_val*((rho_d1_val*sin(phi) + rho_val*cos(phi))*(-(rho_d1_val*sin(phi) + rho_val*cos(phi))*(2*rho_d1_val*cos(phi) + rho_d2_val*sin(phi) - rho_val*sin(phi)) - (-rho_d1_val*cos(phi) + rho_val*sin(phi))*(2*rho_d1_val*sin(phi) - rho_d2_val*cos(phi) + rho_val*cos(phi)))/pow(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2), 3.0L/2.0L) + (2*rho_d1_val*cos(phi) + rho_d2_val*sin(phi) - rho_val*sin(phi))/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)))*cos(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + rho_val*((rho_d1_val*cos(phi) - rho_val*sin(phi))*(-(rho_d1_val*sin(phi) + rho_val*cos(phi))*(2*rho_d1_val*cos(phi) + rho_d2_val*sin(phi) - rho_val*sin(phi)) - (-rho_d1_val*cos(phi) + rho_val*sin(phi))*(2*rho_d1_val*sin(phi) - rho_d2_val*cos(phi) + rho_val*cos(phi)))/pow(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2), 3.0L/2.0L) + (-2*rho_d1_val*sin(phi) + rho_d2_val*cos(phi) - rho_val*cos(phi))/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)))*sin(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)))*(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2))) + 0.003*dtheta*(rho_val*(rho_d1_val*sin(phi) + rho_val*cos(phi))*sin(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + rho_val*(rho_d1_val*cos(phi) - rho_val*sin(phi))*cos(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)))*sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)), 0.003*dtheta*(-rho_val*(rho_d1_val*sin(phi) + rho_val*cos(phi))*sin(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) - rho_val*(rho_d1_val*cos(phi) - rho_val*sin(phi))*cos(phi)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)))*sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)), 0.00793951612903226*dphi*((rho_d1_val*sin(phi) + rho_val*cos(phi))*(2*rho_d1_val*cos(phi) + rho_d2_val*sin(phi) - rho_val*sin(phi)) + (-rho_d1_val*cos(phi) + rho_val*sin(phi))*(2*rho_d1_val*sin(phi) - rho_d2_val*cos(phi) + rho_val*cos(phi))));
 }
 
-inline Vec2 sub_G(double const& theta, double const& phi)
+inline Vec2 sub_G(double const& theta, double const& phi, double const* rho)
 {
-    auto rho_val = spline_rho(phi);
-    auto rho_d1_val = spline_rho(phi, 1);
+    auto rho_val = rho[0];
+    auto rho_d1_val = rho[1];
     return Vec2(0.02943*rho_val*sin(phi)*cos(theta) - 0.02943*rho_val*sin(theta)*cos(phi), 0.02943*((rho_d1_val*sin(phi) + rho_val*cos(phi))*sin(theta)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)) + (rho_d1_val*cos(phi) - rho_val*sin(phi))*cos(theta)/sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)))*sqrt(pow(rho_d1_val*sin(phi) + rho_val*cos(phi), 2) + pow(rho_d1_val*cos(phi) - rho_val*sin(phi), 2)));
 }
 
+template <int maxder>
+inline void spline_rho_checked(double phi, double* rho)
+{
+    if (!spline_rho<maxder>(phi, rho))
+        throw_runtime_error("spline_rho: phi is out of range: ", phi);
+}
+
+inline Mat2x2 sub_M(double const& theta, double const& phi)
+{
+    double rho[2];
+    spline_rho_checked<1>(phi, rho);
+    return sub_M(theta, phi, rho);
+}
+
+inline Mat2x2 sub_C(double const& theta, double const& phi, double const& dtheta, double const& dphi)
+{
+    double rho[3];
+    spline_rho_checked<2>(phi, rho);
+    return sub_C(theta, phi, dtheta, dphi, rho);
+}
+
+inline Vec2 sub_G(double const& theta, double const& phi)
+{
+    double rho[2];
+    spline_rho_checked<1>(phi, rho);
+    return sub_G(theta, phi, rho);
+}
+
 // double get_torque(double theta, double phi, double dtheta, double dphi, double phi2)
 // static double get_torque(double theta, double phi, double dtheta, double dphi)
 // {
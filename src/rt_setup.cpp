@@ -0,0 +1,209 @@
+#include <sys/resource.h>
+#include <malloc.h>
+#include <errno.h>
+#include <string.h>
+#include <fstream>
+#include <cppmisc/threads.h>
+#include <cppmisc/traces.h>
+#include <cppmisc/throws.h>
+#include "rt_setup.h"
+
+using namespace std;
+
+
+namespace
+{
+    int parse_policy(string const& name)
+    {
+        if (name == "other")
+            return SCHED_OTHER;
+        if (name == "fifo")
+            return SCHED_FIFO;
+        if (name == "rr")
+            return SCHED_RR;
+        throw_runtime_error("unknown rt policy: ", name);
+        return SCHED_OTHER;
+    }
+
+    char const* policy_name(int policy)
+    {
+        switch (policy)
+        {
+        case SCHED_OTHER:   return "other";
+        case SCHED_FIFO:    return "fifo";
+        case SCHED_RR:      return "rr";
+        default:            return "unknown";
+        }
+    }
+
+    string cpus_str(vector<int> const& cpus)
+    {
+        string s;
+        for (int cpu : cpus)
+            s += (s.empty() ? "" : ",") + to_string(cpu);
+        return s;
+    }
+
+    // a "Vm*:" value of /proc/self/status in kB, -1 if not found
+    int64_t proc_status_kb(char const* key)
+    {
+        ifstream f("/proc/self/status");
+        string line;
+        size_t n = strlen(key);
+        while (getline(f, line))
+        {
+            if (line.compare(0, n, key) == 0 && line.size() > n && line[n] == ':')
+                return stoll(line.substr(n + 1));
+        }
+        return -1;
+    }
+
+    // usage of the thread when its setup was applied
+    thread_local rusage usage_baseline;
+}
+
+RtSetup::RtSetup() :
+    m_enabled(false),
+    m_policy(SCHED_OTHER),
+    m_priority(0),
+    m_io_priority(0),
+    m_mlockall(false),
+    m_prefault_stack_kb(0),
+    m_require_memlock(false)
+{
+}
+
+void RtSetup::init(Json::Value const& cfg)
+{
+    m_enabled = true;
+
+    if (json_has(cfg, "policy"))
+        m_policy = parse_policy(json_get<string>(cfg, "policy"));
+
+    if (json_has(cfg, "priority"))
+        json_get(cfg, "priority", m_priority);
+
+    m_io_priority = m_priority;
+    if (json_has(cfg, "io_priority"))
+        json_get(cfg, "io_priority", m_io_priority);
+
+    if (json_has(cfg, "cpus"))
+        json_get(cfg, "cpus", m_cpus);
+
+    m_io_cpus = m_cpus;
+    if (json_has(cfg, "io_cpus"))
+        json_get(cfg, "io_cpus", m_io_cpus);
+
+    if (json_has(cfg, "mlockall"))
+        m_mlockall = cfg["mlockall"].asBool();
+
+    if (json_has(cfg, "prefault_stack_kb"))
+        json_get(cfg, "prefault_stack_kb", m_prefault_stack_kb);
+
+    if (json_has(cfg, "require_memlock"))
+        m_require_memlock = cfg["require_memlock"].asBool();
+
+    if (m_require_memlock && !m_mlockall)
+        throw_runtime_error("rt require_memlock needs \"mlockall\": true");
+
+    int min_priority = sched_get_priority_min(m_policy);
+    int max_priority = sched_get_priority_max(m_policy);
+    if (m_priority < min_priority || m_priority > max_priority ||
+        m_io_priority < min_priority || m_io_priority > max_priority)
+    {
+        throw_runtime_error("rt priority of policy ", policy_name(m_policy),
+            " must be in [", min_priority, ", ", max_priority, "]");
+    }
+}
+
+void RtSetup::apply_process() const
+{
+    if (!m_enabled || !m_mlockall)
+        return;
+
+    int err = lock_process_memory();
+    if (err != 0)
+    {
+        int64_t limit = memlock_limit();
+        auto const& msg = format("rt: mlockall failed: ", strerror(err), ", RLIMIT_MEMLOCK ",
+            limit < 0 ? string("unlimited") : to_string(limit / 1024) + " kB");
+        if (m_require_memlock)
+            throw_runtime_error(msg);
+        warn_msg(msg);
+        return;
+    }
+
+    // keep freed heap memory in the process instead of returning it to
+    // the kernel, where it would fault again on the next allocation
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    int64_t locked = proc_status_kb("VmLck");
+    int64_t rss = proc_status_kb("VmRSS");
+    info_msg("rt: memory locked, VmLck ", locked, " kB, VmRSS ", rss, " kB");
+
+    // the vdso and vvar pages are resident but never locked
+    const int64_t unlockable_kb = 64;
+    if (locked + unlockable_kb < rss)
+    {
+        auto const& msg = format("rt: only ", locked, " kB of ", rss, " kB resident memory are locked");
+        if (m_require_memlock)
+            throw_runtime_error(msg);
+        warn_msg(msg);
+    }
+}
+
+void RtSetup::apply_thread(char const* name, int priority, vector<int> const& cpus) const
+{
+    if (!m_enabled)
+        return;
+
+    pthread_t self = pthread_self();
+
+    int err = set_thread_sched(self, m_policy, priority);
+    if (err != 0)
+        warn_msg("rt: can't set policy ", policy_name(m_policy), " priority ", priority,
+            " for ", name, " thread: ", strerror(err));
+
+    if (!cpus.empty())
+    {
+        err = set_thread_affinity(self, cpus);
+        if (err != 0)
+            warn_msg("rt: can't pin ", name, " thread to cpus ", cpus_str(cpus), ": ", strerror(err));
+    }
+
+    if (m_prefault_stack_kb > 0)
+        prefault_stack(size_t(m_prefault_stack_kb) * 1024);
+
+    getrusage(RUSAGE_THREAD, &usage_baseline);
+
+    int policy = -1, prio = -1;
+    get_thread_sched(self, policy, prio);
+    info_msg("rt: ", name, " thread: policy ", policy_name(policy), ", priority ", prio,
+        ", cpus ", cpus_str(get_thread_affinity(self)));
+}
+
+void RtSetup::apply_control_thread() const
+{
+    apply_thread("control", m_priority, m_cpus);
+}
+
+void RtSetup::apply_io_thread(char const* name) const
+{
+    apply_thread(name, m_io_priority, m_io_cpus);
+}
+
+void RtSetup::report_thread_usage(char const* name) const
+{
+    if (!m_enabled)
+        return;
+
+    rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) != 0)
+        return;
+
+    info_msg("rt: ", name, " thread: ",
+        usage.ru_minflt - usage_baseline.ru_minflt, " minor faults, ",
+        usage.ru_majflt - usage_baseline.ru_majflt, " major faults, ",
+        usage.ru_nivcsw - usage_baseline.ru_nivcsw, " involuntary context switches since setup");
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cppmisc/json.h>
+
+
+/*
+ * Real-time setup of the controller process and its threads
+ *
+ * Configured by the optional "rt" block of the "controller" section:
+ *
+ *   "rt": {
+ *       "policy": "fifo",           // "other", "fifo" or "rr"
+ *       "priority": 80,
+ *       "cpus": [2],                // affinity of the control thread
+ *       "io_priority": 79,          // defaults to priority
+ *       "io_cpus": [3],             // defaults to cpus
+ *       "mlockall": true,
+ *       "prefault_stack_kb": 256,
+ *       "require_memlock": true     // fail unless all memory got locked
+ *   }
+ *
+ * Every step is read back and reported; a setting that could not be
+ * applied produces a warning, except for require_memlock.
+ */
+class RtSetup
+{
+private:
+    bool                m_enabled;
+    int                 m_policy;
+    int                 m_priority;
+    int                 m_io_priority;
+    std::vector<int>    m_cpus;
+    std::vector<int>    m_io_cpus;
+    bool                m_mlockall;
+    int                 m_prefault_stack_kb;
+    bool                m_require_memlock;
+
+    void apply_thread(char const* name, int priority, std::vector<int> const& cpus) const;
+
+public:
+    RtSetup();
+
+    void init(Json::Value const& cfg);
+    inline bool enabled() const { return m_enabled; }
+
+    // memory locking; call before spawning the threads
+    void apply_process() const;
+    // applied by the threads to themselves
+    void apply_control_thread() const;
+    void apply_io_thread(char const* name) const;
+    // page faults and context switches of the calling thread since its setup
+    void report_thread_usage(char const* name) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <type_traits>
+
+
+/*
+ * Single-writer sequence lock holding the latest value of T
+ *
+ * The writer never waits; a reader retries only if it raced with the writer
+ * while copying. T must be trivially copyable. The sequence counter is even
+ * while the slot is stable, so version() / 2 is the number of stores made.
+ */
+template <typename T>
+class SeqLock
+{
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+    alignas(64) std::atomic<uint32_t>   m_seq;
+    T                                   m_value;
+
+    SeqLock(SeqLock const&) = delete;
+
+public:
+    SeqLock() : m_seq(0), m_value() {}
+
+    inline void store(T const& value)
+    {
+        uint32_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_value = value;
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /*
+     * returns the version of the value copied into result;
+     * 0 means nothing has been stored yet
+     */
+    inline uint32_t load(T& result) const
+    {
+        while (true)
+        {
+            uint32_t seq1 = m_seq.load(std::memory_order_acquire);
+            if (seq1 & 1)
+                continue;
+
+            result = m_value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            uint32_t seq2 = m_seq.load(std::memory_order_relaxed);
+            if (seq1 == seq2)
+                return seq1 / 2;
+        }
+    }
+
+    inline uint32_t version() const
+    {
+        return m_seq.load(std::memory_order_acquire) / 2;
+    }
+};
@@ -0,0 +1,265 @@
+#pragma once
+#include <type_traits>
+#include "serializer.h"
+
+
+namespace ser
+{
+    /*
+     * Schema declared messages
+     *
+     * A message is a struct that lists its fields once:
+     *
+     *     struct Measurement
+     *     {
+     *         int64_t ts;
+     *         double x;
+     *
+     *         template <typename V>
+     *         void fields(V& v)
+     *         {
+     *             v(SER_KEY("ts")(), ts);
+     *             v(SER_KEY("x")(), x);
+     *         }
+     *     };
+     *
+     * pack_message() writes the fields in this order in the usual ser
+     * format. A MessageDecoder learns where the fields are in the first
+     * packet it gets and from then on reads them at the same offsets, only
+     * checking the type and name of each one; a packet laid out differently
+     * is scanned again. Only numeric fields are supported.
+     */
+
+    namespace detail
+    {
+        struct MessageSizer
+        {
+            int size;
+
+            template <typename Key, typename T>
+            inline void operator()(Key const& k, T const& val)
+            {
+                size += get_var_size(k, val);
+            }
+        };
+
+        struct MessageWriter
+        {
+            ostream_t& s;
+            bool ok;
+
+            template <typename Key, typename T>
+            inline void operator()(Key const& k, T const& val)
+            {
+                ok = ok && s.append_var(k, val);
+            }
+        };
+    }
+
+    template <typename Msg>
+    inline int get_message_size(Msg const& msg)
+    {
+        detail::MessageSizer v = {pack_header_size};
+        const_cast<Msg&>(msg).fields(v);
+        return v.size;
+    }
+
+    // returns the packet size or -1 if buf is too short
+    template <typename Msg>
+    inline int pack_message(char* buf, int buf_len, Msg const& msg)
+    {
+        ostream_t s(buf, buf_len);
+        ostream_t s_bgn = s;
+        if (!s.put(magic))
+            return -1;
+
+        ostream_t s_sz = s;
+        if (!s.put<uint32_t>(0))
+            return -1;
+
+        detail::MessageWriter v = {s, true};
+        const_cast<Msg&>(msg).fields(v);
+        if (!v.ok)
+            return -1;
+
+        uint32_t sz = (uint32_t)s.sub(s_bgn);
+        if (!s_sz.put(sz))
+            return -1;
+
+        return sz;
+    }
+
+    template <typename Msg>
+    class MessageDecoder
+    {
+    public:
+        static const int max_fields = PacketView::max_entries;
+
+    private:
+        struct Field
+        {
+            uint32_t    hash;
+            uint8_t     type_id;
+            int         offset;     // of the type byte from the packet start
+        };
+
+        Field       m_fields[max_fields];
+        int         m_nfields;
+        int         m_size;         // packet size of the learned layout, 0 if none
+        uint64_t    m_decoded;
+        uint64_t    m_relearned;
+
+        // collects the names and types of the message fields
+        struct Lister
+        {
+            Field* fields;
+            int n;
+
+            template <uint32_t Hash, typename T>
+            inline void operator()(key<Hash> const&, T& val)
+            {
+                assert(n < max_fields);
+                fields[n].hash = Hash;
+                fields[n].type_id = std::get<1>(get_numeric_type(val));
+                fields[n].offset = -1;
+                ++ n;
+            }
+        };
+
+        // reads the fields at the learned offsets, stops at the first mismatch
+        struct Reader
+        {
+            char const* buf;
+            Field const* fields;
+            int n;
+            bool ok;
+
+            template <uint32_t Hash, typename T>
+            inline void operator()(key<Hash> const&, T& val)
+            {
+                typedef typename std::tuple_element<0, decltype(get_numeric_type(val))>::type Wire;
+
+                if (!ok)
+                    return;
+
+                char const* p = buf + fields[n].offset;
+                uint8_t type_id = uint8_t(p[0]);
+                uint32_t hash;
+                memcpy(&hash, p + sizeof(uint8_t), sizeof(hash));
+                if (type_id != fields[n].type_id || hash != Hash)
+                {
+                    ok = false;
+                    return;
+                }
+
+                Wire w;
+                memcpy(&w, p + sizeof(uint8_t) + sizeof(uint32_t), sizeof(w));
+                val = static_cast<T>(w);
+                ++ n;
+            }
+        };
+
+        // finds the message fields in the packet; the last entry of a name wins
+        int learn(char const* buf, int len)
+        {
+            Field fields[max_fields];
+            Lister lister = {fields, 0};
+            Msg msg;
+            msg.fields(lister);
+
+            istream_t s(buf, len);
+            istream_t s_bgn = s;
+
+            if (s.fetch_and_compare(magic) <= 0)
+                return -1;
+
+            uint32_t sz;
+            if (s.fetch(sz) <= 0)
+                return -1;
+
+            if ((int)sz != len)
+                return -1;
+
+            while ((int)s.sub(s_bgn) < (int)sz)
+            {
+                int offset = (int)s.sub(s_bgn);
+                uint8_t type_id = uint8_t(*s.s);
+                uint32_t var_hash;
+                int status = s.skip_var(var_hash);
+                if (status <= 0)
+                    return status;
+
+                for (int i = 0; i < lister.n; ++ i)
+                {
+                    if (fields[i].hash == var_hash)
+                    {
+                        fields[i].offset = type_id == fields[i].type_id ? offset : -1;
+                        break;
+                    }
+                }
+            }
+
+            if ((int)s.sub(s_bgn) > (int)sz)
+                return -1;
+
+            for (int i = 0; i < lister.n; ++ i)
+            {
+                if (fields[i].offset < 0)
+                    return -1;
+            }
+
+            memcpy(m_fields, fields, sizeof(Field) * lister.n);
+            m_nfields = lister.n;
+            m_size = len;
+            ++ m_relearned;
+            return 1;
+        }
+
+    public:
+        MessageDecoder() : m_nfields(0), m_size(0), m_decoded(0), m_relearned(0) {}
+
+        /*
+         * buf holds a complete packet of len bytes
+         *  -1 -- the packet doesn't carry all the message fields, or
+         *        is corrupted; msg may be partially filled
+         *   1 -- msg filled
+         */
+        int decode(char const* buf, int len, Msg& msg)
+        {
+            if (len == m_size)
+            {
+                Reader reader = {buf, m_fields, 0, true};
+                msg.fields(reader);
+                if (reader.ok)
+                {
+                    ++ m_decoded;
+                    return 1;
+                }
+            }
+
+            if (learn(buf, len) <= 0)
+                return -1;
+
+            Reader reader = {buf, m_fields, 0, true};
+            msg.fields(reader);
+            assert(reader.ok);
+            ++ m_decoded;
+            return 1;
+        }
+
+        int decode(PacketRef const& pack, Msg& msg)
+        {
+            return decode(pack.data, pack.size, msg);
+        }
+
+        // forgets the learned layout, e.g. on reconnect
+        void reset()
+        {
+            m_size = 0;
+        }
+
+        // packets decoded and how many times the layout had to be learned
+        inline uint64_t decoded() const { return m_decoded; }
+        inline uint64_t relearned() const { return m_relearned; }
+    };
+}
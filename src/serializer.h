@@ -9,6 +9,9 @@
 #include <memory.h>
 #include <memory>
 #include <functional>
+#include <vector>
+#include <algorithm>
+#include "mirrored_buffer.h"
 
 
 namespace ser
@@ -29,6 +32,13 @@ namespace ser
         hash of name    4b
         length          4b
         data            xx
+
+    array variable:
+        type            1b
+        hash of name    4b
+        element type    1b
+        count           4b
+        elements        count * element size
     */
 
 
@@ -46,11 +56,13 @@ namespace ser
     inline int pack(std::string& result, Vars const&... vars);
 
     template <typename ... Vars>
-    inline int unpack(char const* buf, int buf_len, Vars&... result);
+    inline int unpack(char const* buf, int buf_len, Vars&&... result);
 
     inline int get_buf_pack_size(char const* buf, int buf_len);
 
     class Packet;
+    class PacketView;
+    struct PacketRef;
     class PacketReader;
     typedef std::shared_ptr<PacketReader> PacketReaderPtr;
 
@@ -80,11 +92,130 @@ namespace ser
        return hash;
     }
 
+    // compile time fnv_hash; chars are sign extended the same way
+    constexpr uint32_t fnv_hash_const(char const* s, uint32_t hash = OFFSET_BASIS)
+    {
+        return *s == '\0' ? hash : fnv_hash_const(s + 1, (hash ^ uint32_t(int32_t(*s))) * FNV_PRIME);
+    }
+
+    /*
+     * Variable names with precomputed hashes. Anywhere a name is expected,
+     * "x"_h or SER_KEY("x") can be passed instead of "x". The hash of a key
+     * is a template argument and so always computed at compile time; "x"_h
+     * is folded by the optimizer.
+     */
+    struct name_t
+    {
+        uint32_t hash;
+        constexpr explicit name_t(uint32_t hash) : hash(hash) {}
+    };
+
+    template <uint32_t Hash>
+    struct key
+    {
+        static const uint32_t hash = Hash;
+    };
+
+    #define SER_KEY(name) ::ser::key<::ser::fnv_hash_const(name)>
+
+    inline namespace literals
+    {
+        constexpr name_t operator "" _h(char const* s, size_t)
+        {
+            return name_t(fnv_hash_const(s));
+        }
+    }
+
+    inline uint32_t name_hash(char const* name)
+    {
+        return fnv_hash(name);
+    }
+
+    constexpr uint32_t name_hash(name_t const& name)
+    {
+        return name.hash;
+    }
+
+    template <uint32_t Hash>
+    constexpr uint32_t name_hash(key<Hash> const&)
+    {
+        return Hash;
+    }
+
+    /*
+     * Expected order of the variables in a packet. A PacketView lookup
+     * through a layout checks the slot the key has in it first and falls
+     * back to searching when the packet is laid out differently.
+     */
+    template <typename ... Keys>
+    struct layout {};
+
+    template <uint32_t Hash, typename Layout, int Index = 0>
+    struct slot_of;
+
+    template <uint32_t Hash, int Index>
+    struct slot_of<Hash, layout<>, Index>
+    {
+        static const int value = -1;
+    };
+
+    template <uint32_t Hash, uint32_t First, typename ... Rest, int Index>
+    struct slot_of<Hash, layout<key<First>, Rest...>, Index>
+    {
+        static const int value = Hash == First ? Index : slot_of<Hash, layout<Rest...>, Index + 1>::value;
+    };
+
     struct const_str_t {
         char const* s;
         int len;
     };
 
+    // numeric values to pack as an array variable
+    template <typename T>
+    struct array_t {
+        T const* data;
+        int len;
+    };
+
+    template <typename T>
+    inline array_t<T> make_array(T const* data, int len)
+    {
+        array_t<T> result = {data, len};
+        return result;
+    }
+
+    /*
+     * Array variable in a parsed packet, not copied. The elements are not
+     * aligned in the packet, so they are read through memcpy.
+     */
+    template <typename T>
+    class array_view
+    {
+    private:
+        char const* m_data;
+        int         m_size;
+
+    public:
+        array_view() : m_data(nullptr), m_size(0) {}
+        array_view(char const* data, int size) : m_data(data), m_size(size) {}
+
+        inline int size() const { return m_size; }
+        inline bool empty() const { return m_size == 0; }
+        inline char const* bytes() const { return m_data; }
+
+        inline T operator[](int i) const
+        {
+            T v;
+            memcpy(&v, m_data + i * sizeof(T), sizeof(T));
+            return v;
+        }
+
+        inline void copy_to(T* dst) const
+        {
+            memcpy(dst, m_data, m_size * sizeof(T));
+        }
+    };
+
     enum VarID {
         ID_int8 = 1,
         ID_uint8 = 2,
@@ -95,6 +226,7 @@ namespace ser
         ID_float = 7,
         ID_double = 8,
         ID_string = 9,
+        ID_array = 10,
     };
 
     static const char* magic = "MGic";
@@ -109,6 +241,21 @@ namespace ser
     inline std::tuple<float, uint8_t, int>    get_numeric_type(float x) { return std::make_tuple(x, ID_float, (int)sizeof(x)); }
     inline std::tuple<double, uint8_t, int>   get_numeric_type(double x) { return std::make_tuple(x, ID_double, (int)sizeof(x)); }
 
+    // element types of arrays are sent as they are, so bool isn't one
+    template <typename T>
+    struct is_array_element
+    {
+        static const bool value = std::is_same<T,
+            typename std::tuple_element<0, decltype(get_numeric_type(T()))>::type>::value;
+    };
+
+    template <typename T>
+    inline uint8_t get_array_element_id()
+    {
+        static_assert(is_array_element<T>::value, "array elements must be numeric");
+        return std::get<1>(get_numeric_type(T()));
+    }
+
     inline int get_numeric_type_sz(uint8_t type_id)
     {
         switch (type_id)
@@ -171,24 +318,25 @@ namespace ser
             return put(str, (int)strlen(str));
         }
 
-        template <typename T>
-        inline bool append_var(char const* name, T const& _value)
+        template <typename Name, typename T>
+        inline bool append_var(Name const& name, T const& _value)
         {
             auto const& value = get_numeric_type(_value);
             if (!put(std::get<1>(value)))
                 return false;
-            if (!put(fnv_hash(name)))
+            if (!put(name_hash(name)))
                 return false;
             if (!put(std::get<0>(value)))
                 return false;
             return true;
         }
 
-        inline bool append_var(char const* name, char const* str)
+        template <typename Name>
+        inline bool append_var(Name const& name, char const* str)
         {
             if (!put<uint8_t>(ID_string))
                 return false;
-            if (!put(fnv_hash(name)))
+            if (!put(name_hash(name)))
                 return false;
             if (!put((uint32_t)strlen(str)))
                 return false;
@@ -197,11 +345,12 @@ namespace ser
             return true;
         }
 
-        inline bool append_var(char const* name, std::string const& str)
+        template <typename Name>
+        inline bool append_var(Name const& name, std::string const& str)
         {
             if (!put<uint8_t>(ID_string))
                 return false;
-            if (!put(fnv_hash(name)))
+            if (!put(name_hash(name)))
                 return false;
             int sz = (int)str.size();
             if (!put(uint32_t(sz)))
@@ -211,11 +360,12 @@ namespace ser
             return true;
         }
 
-        inline bool append_var(char const* name, const_str_t const& str)
+        template <typename Name>
+        inline bool append_var(Name const& name, const_str_t const& str)
         {
             if (!put<uint8_t>(ID_string))
                 return false;
-            if (!put(fnv_hash(name)))
+            if (!put(name_hash(name)))
                 return false;
             if (!put(uint32_t(str.len)))
                 return false;
@@ -224,8 +374,30 @@ namespace ser
             return true;
         }
 
-        template <typename T, typename ... Etc>
-        inline bool append_var_list(char const* name, T const& val, Etc const&... etc)
+        template <typename Name, typename T>
+        inline bool append_var(Name const& name, array_t<T> const& arr)
+        {
+            if (!put<uint8_t>(ID_array))
+                return false;
+            if (!put(name_hash(name)))
+                return false;
+            if (!put(get_array_element_id<T>()))
+                return false;
+            if (!put(uint32_t(arr.len)))
+                return false;
+            if (!put(reinterpret_cast<char const*>(arr.data), int(arr.len * sizeof(T))))
+                return false;
+            return true;
+        }
+
+        template <typename Name, typename T>
+        inline bool append_var(Name const& name, std::vector<T> const& v)
+        {
+            return append_var(name, make_array(v.data(), int(v.size())));
+        }
+
+        template <typename Name, typename T, typename ... Etc>
+        inline bool append_var_list(Name const& name, T const& val, Etc const&... etc)
         {
             if (!append_var(name, val))
                 return false;
@@ -234,42 +406,57 @@ namespace ser
             return true;
         }
 
-        template <typename T>
-        inline bool append_var_list(char const* name, T const& val)
+        template <typename Name, typename T>
+        inline bool append_var_list(Name const& name, T const& val)
         {
             return append_var(name, val);
         }
     };
 
-    template <typename T>
-    inline int get_var_size(char const* name, T const& value)
+    template <typename Name, typename T>
+    inline int get_var_size(Name const& name, T const& value)
     {
         auto t = get_numeric_type(value);
         return sizeof(uint8_t) + sizeof(uint32_t) + std::get<2>(t);
     }
 
-    inline int get_var_size(char const* name, char const* value)
+    template <typename Name>
+    inline int get_var_size(Name const& name, char const* value)
     {
         return int(sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t) + strlen(value));
     }
 
-    inline int get_var_size(char const* name, std::string const& s)
+    template <typename Name>
+    inline int get_var_size(Name const& name, std::string const& s)
     {
         return int(sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t) + s.size());
     }
 
-    inline int get_var_size(char const* name, const_str_t const& s)
+    template <typename Name>
+    inline int get_var_size(Name const& name, const_str_t const& s)
     {
         return int(sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t) + s.len);
     }
 
+    template <typename Name, typename T>
+    inline int get_var_size(Name const& name, array_t<T> const& arr)
+    {
+        return int(sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t) + arr.len * sizeof(T));
+    }
+
+    template <typename Name, typename T>
+    inline int get_var_size(Name const& name, std::vector<T> const& v)
+    {
+        return get_var_size(name, make_array(v.data(), int(v.size())));
+    }
+
     inline int get_var_list_size()
     {
         return 0;
     }
 
-    template <typename T, typename ... Etc>
-    inline int get_var_list_size(char const* name, T const& value, Etc const&... etc)
+    template <typename Name, typename T, typename ... Etc>
+    inline int get_var_list_size(Name const& name, T const& value, Etc const&... etc)
     {
         return get_var_size(name, value) + get_var_list_size(etc...);
     }
@@ -321,16 +508,87 @@ namespace ser
         return pack(const_cast<char*>(result.data()), (int)result.size(), vars...);
     }
 
+    // small packets are packed on the stack
     template <typename Writer, typename ... Vars>
     inline int send_pack(Writer& writer, Vars const&... vars)
     {
+        char stack_buf[512];
+        int sz = get_packed_size(vars...);
+        if (sz <= (int)sizeof(stack_buf))
+        {
+            sz = pack(stack_buf, sz, vars...);
+            if (sz <= 0)
+                return sz;
+            return writer(stack_buf, sz);
+        }
+
         std::string buf;
-        int sz = pack(buf, vars...);
+        sz = pack(buf, vars...);
         if (sz <= 0)
             return sz;
         return writer(buf.data(), sz);
     }
 
+    /*
+     * Packs messages one after another into a reusable buffer, so that
+     * several of them go out in one write. The buffer only grows; once it
+     * is large enough, sending does not allocate.
+     */
+    class PacketWriter
+    {
+    private:
+        std::vector<char>   m_buf;
+        int                 m_filled;
+
+        char* reserve(int len)
+        {
+            if (m_filled + len > (int)m_buf.size())
+                m_buf.resize(std::max<size_t>(m_filled + len, 2 * m_buf.size()));
+            return m_buf.data() + m_filled;
+        }
+
+    public:
+        explicit PacketWriter(int capacity = 1024) : m_buf(capacity), m_filled(0) {}
+
+        // returns the packet size or -1
+        template <typename ... Vars>
+        int append(Vars const&... vars)
+        {
+            int sz = get_packed_size(vars...);
+            sz = pack(reserve(sz), sz, vars...);
+            if (sz <= 0)
+                return sz;
+            m_filled += sz;
+            return sz;
+        }
+
+        // an already serialized packet
+        void append_raw(char const* data, int len)
+        {
+            memcpy(reserve(len), data, len);
+            m_filled += len;
+        }
+
+        /*
+         * hands everything appended so far to writer(char const*, int) and
+         * clears the buffer; returns the writer result, 0 if there was nothing
+         */
+        template <typename Writer>
+        int flush(Writer&& writer)
+        {
+            if (m_filled == 0)
+                return 0;
+            int status = writer(m_buf.data(), m_filled);
+            m_filled = 0;
+            return status;
+        }
+
+        inline char const* data() const { return m_buf.data(); }
+        inline int size() const { return m_filled; }
+        inline bool empty() const { return m_filled == 0; }
+        inline void clear() { m_filled = 0; }
+    };
+
 
     /*
      * deserialization
@@ -428,6 +686,57 @@ namespace ser
             return 1;
         }
 
+        template <typename T>
+        inline int fetch_var(uint32_t& name_hash, array_view<T>& arr)
+        {
+            int status;
+            uint8_t type_id;
+
+            status = fetch(type_id);
+            if (status <= 0)
+                return status;
+
+            if (type_id != ID_array)
+                return -1;
+
+            status = fetch(name_hash);
+            if (status <= 0)
+                return status;
+
+            uint8_t elem_id;
+            status = fetch(elem_id);
+            if (status <= 0)
+                return status;
+
+            if (elem_id != get_array_element_id<T>())
+                return -1;
+
+            uint32_t n;
+            status = fetch(n);
+            if (status <= 0)
+                return status;
+
+            if (n > rest / sizeof(T))
+                return -1;
+
+            arr = array_view<T>(s, int(n));
+            s += n * sizeof(T);
+            rest -= int(n * sizeof(T));
+            return 1;
+        }
+
+        template <typename T>
+        inline int fetch_var(uint32_t& name_hash, std::vector<T>& v)
+        {
+            array_view<T> arr;
+            int status = fetch_var(name_hash, arr);
+            if (status <= 0)
+                return status;
+            v.resize(arr.size());
+            arr.copy_to(v.data());
+            return 1;
+        }
+
         template <typename T>
         inline int fetch_var(uint32_t& name_hash, T& var)
         {
@@ -462,6 +771,19 @@ namespace ser
                 peek(len);
                 return sizeof(len) + len;
             }
+            else if (type_id == ID_array)
+            {
+                const int hdr = sizeof(uint8_t) + sizeof(uint32_t);
+                if (rest < hdr)
+                    return -1;
+
+                uint32_t n;
+                memcpy(&n, s + sizeof(uint8_t), sizeof(n));
+                int elem_sz = get_numeric_type_sz(uint8_t(*s));
+                if (elem_sz <= 0 || n > uint32_t(rest - hdr) / elem_sz)
+                    return -1;
+                return hdr + int(n) * elem_sz;
+            }
             else
             {
                 return get_numeric_type_sz(type_id);
@@ -507,28 +829,16 @@ namespace ser
         return 1;
     }
 
-    template <typename T>
-    inline int extract_values(std::map<uint32_t, istream_t> const& entries, char const* var_name, T& var_value)
-    {
-        uint32_t name_hash = fnv_hash(var_name);
-        auto it = entries.find(name_hash);
-        if (it == entries.end())
-            return -1;
-
-        istream_t s = it->second;
-        return s.fetch_var(name_hash, var_value);
-    }
-
-    template <typename T, typename ... Etc>
-    inline int extract_values(std::map<uint32_t, istream_t> const& entries, char const* var_name, T& var_value, Etc&... etc)
+    template <typename Name, typename T, typename ... Etc>
+    inline int extract_values(std::map<uint32_t, istream_t> const& entries, Name const& var_name, T& var_value, Etc&&... etc)
     {
-        uint32_t name_hash = fnv_hash(var_name);
-        auto it = entries.find(name_hash);
+        uint32_t var_hash = name_hash(var_name);
+        auto it = entries.find(var_hash);
         if (it == entries.end())
             return -1;
 
         istream_t s = it->second;
-        int status = s.fetch_var(name_hash, var_value);
+        int status = s.fetch_var(var_hash, var_value);
         if (status <= 0)
             return status;
         return extract_values(entries, etc...);
@@ -550,7 +860,7 @@ namespace ser
     }
 
     template <typename ... Vars>
-    inline int unpack(char const* buf, int buf_len, Vars&... result)
+    inline int unpack(char const* buf, int buf_len, Vars&&... result)
     {
         int status;
         istream_t s(buf, buf_len);
@@ -593,7 +903,7 @@ namespace ser
     }
 
     template <typename ... Vars>
-    inline int unpack(std::string const& buf, Vars&... result)
+    inline int unpack(std::string const& buf, Vars&&... result)
     {
         return unpack(buf.data(), (int)buf.size(), result...);
     }
@@ -641,14 +951,14 @@ namespace ser
             return 1;
         }
 
-        template <typename Value, typename ... Vars>
-        inline int get(char const* name, Value& val, Vars&... result)
+        template <typename Name, typename Value, typename ... Vars>
+        inline int get(Name const& name, Value& val, Vars&&... result)
         {
             return extract_values(m_entries, name, val, result...);
         }
 
-        template <typename T>
-        inline T get(char const* name)
+        template <typename T, typename Name>
+        inline T get(Name const& name)
         {
         	T result;
         	int status = extract_values<T>(m_entries, name, result);
@@ -664,90 +974,437 @@ namespace ser
     };
 
 
+    /*
+     * Packet parsed in place: the view refers to the parsed buffer, which
+     * must outlive it, and indexes up to max_entries variables in a flat
+     * array. Variables past that are not indexed but scanned on lookup,
+     * like the Packet used to. Nothing is allocated or copied.
+     */
+    class PacketView
+    {
+    public:
+        static const int max_entries = 32;
+
+    private:
+        uint32_t    m_hashes[max_entries];
+        istream_t   m_locations[max_entries];
+        int         m_nentries;
+        istream_t   m_unindexed;    // variables past max_entries
+        int         m_nunindexed;
+
+        inline bool find(uint32_t var_hash, istream_t& location) const
+        {
+            // the last entry of a name wins, as in Packet
+            if (m_nunindexed > 0)
+            {
+                bool found = false;
+                istream_t s = m_unindexed;
+                for (int i = 0; i < m_nunindexed; ++ i)
+                {
+                    uint32_t hash;
+                    istream_t loc;
+                    s.skip_var(hash, loc);
+                    if (hash == var_hash)
+                    {
+                        location = loc;
+                        found = true;
+                    }
+                }
+                if (found)
+                    return true;
+            }
+
+            for (int i = m_nentries - 1; i >= 0; -- i)
+            {
+                if (m_hashes[i] == var_hash)
+                {
+                    location = m_locations[i];
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline int extract() const
+        {
+            return 1;
+        }
+
+        template <typename Name, typename Value, typename ... Vars>
+        inline int extract(Name const& name, Value& val, Vars&&... result) const
+        {
+            uint32_t var_hash = name_hash(name);
+            istream_t s;
+            if (!find(var_hash, s))
+                return -1;
+
+            int status = s.fetch_var(var_hash, val);
+            if (status <= 0)
+                return status;
+            return extract(result...);
+        }
+
+        template <typename Layout>
+        inline int extract_layout(Layout const&) const
+        {
+            return 1;
+        }
+
+        template <typename Layout, uint32_t Hash, typename Value, typename ... Vars>
+        inline int extract_layout(Layout const& l, key<Hash> const&, Value& val, Vars&&... result) const
+        {
+            const int slot = slot_of<Hash, Layout>::value;
+            istream_t s;
+            if (slot >= 0 && slot < m_nentries && m_hashes[slot] == Hash)
+                s = m_locations[slot];
+            else if (!find(Hash, s))
+                return -1;
+
+            uint32_t var_hash = Hash;
+            int status = s.fetch_var(var_hash, val);
+            if (status <= 0)
+                return status;
+            return extract_layout(l, result...);
+        }
+
+    public:
+        PacketView() : m_nentries(0), m_nunindexed(0) {}
+
+        int parse(char const* buf, int len)
+        {
+            m_nentries = 0;
+            m_nunindexed = 0;
+            istream_t s(buf, len);
+            istream_t s_bgn = s;
+
+            // read magic
+            if (s.fetch_and_compare(magic) <= 0)
+                return -1;
+
+            // read size
+            uint32_t sz;
+            if (s.fetch(sz) <= 0)
+                return -1;
+
+            if ((int)sz != len)
+                return -1;
+
+            while ((int)s.sub(s_bgn) < (int)sz)
+            {
+                if (m_nentries == max_entries)
+                {
+                    if (m_nunindexed == 0)
+                        m_unindexed = s;
+
+                    uint32_t hash;
+                    int status = s.skip_var(hash);
+                    if (status <= 0)
+                        return status;
+                    ++ m_nunindexed;
+                    continue;
+                }
+
+                int status = s.skip_var(m_hashes[m_nentries], m_locations[m_nentries]);
+                if (status <= 0)
+                    return status;
+                ++ m_nentries;
+            }
+
+            if ((int)s.sub(s_bgn) > (int)sz)
+                return -1;
+
+            return 1;
+        }
+
+        template <typename Name, typename Value, typename ... Vars>
+        inline int get(Name const& name, Value& val, Vars&&... result) const
+        {
+            return extract(name, val, result...);
+        }
+
+        // keys only; a key found in its layout slot costs one comparison
+        template <typename ... Keys, uint32_t Hash, typename Value, typename ... Vars>
+        inline int get(layout<Keys...> const& l, key<Hash> const& k, Value& val, Vars&&... result) const
+        {
+            return extract_layout(l, k, val, result...);
+        }
+
+        template <typename T, typename Name>
+        inline T get(Name const& name) const
+        {
+            T result;
+            int status = extract(name, result);
+            if (status < 0)
+                return T();
+            return result;
+        }
+
+        inline int nentries() const
+        {
+            return m_nentries + m_nunindexed;
+        }
+    };
+
+    /*
+     * Unparsed packet in the reader buffer, e.g. for a MessageDecoder;
+     * valid until the next fetch, like a PacketView
+     */
+    struct PacketRef
+    {
+        char const* data;
+        int size;
+
+        PacketRef() : data(nullptr), size(0) {}
+
+        int parse(char const* buf, int len)
+        {
+            data = buf;
+            size = len;
+            return 1;
+        }
+    };
+
+    /*
+     * Reads packets from a byte stream into a mirrored ring buffer. A read
+     * pulls as much as there is room for, consuming a packet only advances
+     * the read position, and the buffer grows for packets that don't fit.
+     */
     class PacketReader
     {
     private:
-        static const int    m_buf_total = 8192;
-        char                m_buf[m_buf_total];
-        int                 m_buf_filled;
+        static const int    m_initial_size = 64 * 1024;
+        static const int    m_max_packet = 16 * 1024 * 1024;   // larger sizes are taken for corrupted data
+
+        MirroredBuffer      m_buf;
+        uint64_t            m_head;         // read position
+        uint64_t            m_tail;         // write position
+        int                 m_pending;      // size of the packet held by a PacketView
         PacketReaderCbPtr   m_reader;
 
-        void rotate_buf(int offset)
+        inline int filled() const
         {
-            assert(offset <= m_buf_filled);
-            memmove(m_buf, m_buf + offset, m_buf_filled - offset);
-            m_buf_filled = m_buf_filled - offset;
+            return int(m_tail - m_head);
+        }
+
+        inline int space() const
+        {
+            return int(m_buf.size()) - filled();
         }
 
         int fill_buffer()
         {
-        	if (m_buf_filled == m_buf_total)
-        		return 0;
+            if (space() == 0)
+                return 0;
 
-            int len = (*m_reader)(m_buf + m_buf_filled, m_buf_total - m_buf_filled);
+            int len = (*m_reader)(m_buf.at(m_tail), space());
             if (len <= 0)
                 return len;
 
-            m_buf_filled += len;
+            m_tail += len;
             return len;
         }
 
+        // makes the buffer hold at least size bytes, keeping the data
+        int reserve(int size)
+        {
+            if (size <= int(m_buf.size()))
+                return 1;
+            if (size > m_max_packet)
+                return -1;
 
-    public:
-        PacketReader(PacketReaderCbPtr reader) : m_buf_filled(0), m_reader(reader) {}
-
-        PacketReader(PacketReader const& src) = delete;
+            MirroredBuffer buf(size);
+            int n = filled();
+            memcpy(buf.data(), m_buf.at(m_head), n);
+            m_buf.swap(buf);
+            m_head = 0;
+            m_tail = n;
+            return 1;
+        }
 
-        PacketReader(PacketReader&& src)
+        int packet_size(uint64_t pos)
         {
-            memcpy(this->m_buf, src.m_buf, src.m_buf_filled);
-            this->m_buf_filled = src.m_buf_filled;
-            this->m_reader = src.m_reader;
-
-            src.m_reader = nullptr;
+            // a size field below the header, 0 included, is corrupted
+            int pack_sz = get_buf_pack_size(m_buf.at(pos), int(m_tail - pos));
+            if (pack_sz < pack_header_size || pack_sz > m_max_packet)
+                return -1;
+            return pack_sz;
         }
 
-        int fetch_next(Packet& result)
+        // the packet handed out as a view is consumed on the next fetch
+        void release_pending()
         {
-            int status;
+            m_head += m_pending;
+            m_pending = 0;
+        }
 
-            if (m_buf_filled < pack_header_size)
+        /*
+         * makes a complete packet available at the read position;
+         * returns its size, 0 if there is none yet, -1 on errors
+         */
+        int next_packet()
+        {
+            if (filled() < pack_header_size)
             {
-                status = fill_buffer();
+                int status = fill_buffer();
                 if (status <= 0)
                     return status;
 
-                return fetch_next(result);
+                if (filled() < pack_header_size)
+                    return 0;
             }
 
-            int pack_sz = get_buf_pack_size(m_buf, m_buf_filled);
+            int pack_sz = packet_size(m_head);
             if (pack_sz <= 0)
                 return pack_sz;
 
-            if (pack_sz > m_buf_filled)
+            if (pack_sz > filled())
             {
-                if (pack_sz > m_buf_total)
-                {
-                	// TODO not implemented
-                	return -1;
-                }
+                if (reserve(pack_sz) <= 0)
+                    return -1;
 
-                status = fill_buffer();
+                int status = fill_buffer();
                 if (status <= 0)
                     return status;
 
-                if (pack_sz > m_buf_filled)
+                if (pack_sz > filled())
                     return 0;
             }
 
-            std::string packet_buf(m_buf, pack_sz);
+            return pack_sz;
+        }
+
+        /*
+         * drains the reader and moves the read position to the newest
+         * complete packet; returns its size, 0 if there is none, -1 on errors
+         */
+        int latest_packet(int& skipped)
+        {
+            skipped = 0;
+            int latest_sz = 0;
+            bool drained = false;
+
+            while (true)
+            {
+                uint64_t pos = m_head;
+                uint64_t latest = m_head;
+                int npacks = 0;
+                int incomplete_sz = 0;
+
+                while (int(m_tail - pos) >= pack_header_size)
+                {
+                    int pack_sz = packet_size(pos);
+                    if (pack_sz <= 0)
+                        return pack_sz;
+                    if (pack_sz > int(m_tail - pos))
+                    {
+                        incomplete_sz = pack_sz;
+                        break;
+                    }
+
+                    latest = pos;
+                    latest_sz = pack_sz;
+                    pos += pack_sz;
+                    ++ npacks;
+                }
+
+                // older packets are dropped by moving past them
+                if (npacks > 0)
+                {
+                    skipped += npacks - 1;
+                    m_head = latest;
+                }
+
+                if (drained)
+                    break;
+
+                // room for the newest complete packet and the incomplete one
+                if (incomplete_sz > 0 && reserve(int(pos - m_head) + incomplete_sz) <= 0)
+                    return -1;
+
+                // a short read means the source is drained
+                int room = space();
+                int status = fill_buffer();
+                if (status < 0)
+                    return status;
+                drained = status == 0 || status < room;
+            }
+
+            return latest_sz;
+        }
+
+        int extract(Packet& result, int pack_sz)
+        {
+            std::string packet_buf(m_buf.at(m_head), pack_sz);
             int extracted = result.parse(packet_buf);
             if (extracted <= 0)
                 return extracted;
 
-            rotate_buf(pack_sz);
+            m_head += pack_sz;
+            return 1;
+        }
+
+        // PacketView and PacketRef refer to the buffer in place
+        template <typename View>
+        int extract(View& result, int pack_sz)
+        {
+            int extracted = result.parse(m_buf.at(m_head), pack_sz);
+            if (extracted <= 0)
+                return extracted;
+
+            m_pending = pack_sz;
             return 1;
         }
+
+    public:
+        PacketReader(PacketReaderCbPtr reader) :
+            m_buf(m_initial_size), m_head(0), m_tail(0), m_pending(0), m_reader(reader) {}
+
+        PacketReader(PacketReader const& src) = delete;
+
+        PacketReader(PacketReader&& src) :
+            m_buf(std::move(src.m_buf)), m_head(src.m_head), m_tail(src.m_tail),
+            m_pending(src.m_pending), m_reader(src.m_reader)
+        {
+            src.m_reader = nullptr;
+        }
+
+        /*
+         * return values:
+         *  -1 -- failed
+         *   0 -- no complete packet yet
+         *   1 -- result filled
+         *
+         * A PacketView refers to the reader buffer and stays valid until
+         * the next fetch; a Packet keeps a copy of the data.
+         */
+        template <typename PacketT>
+        int fetch_next(PacketT& result)
+        {
+            release_pending();
+
+            int pack_sz = next_packet();
+            if (pack_sz <= 0)
+                return pack_sz;
+
+            return extract(result, pack_sz);
+        }
+
+        /*
+         * Drains everything the reader has and parses only the newest
+         * complete packet; older packets are skipped without parsing and
+         * counted in skipped. Return values are the same as of fetch_next.
+         */
+        template <typename PacketT>
+        int fetch_latest(PacketT& result, int& skipped)
+        {
+            release_pending();
+
+            int pack_sz = latest_packet(skipped);
+            if (pack_sz <= 0)
+                return pack_sz;
+
+            return extract(result, pack_sz);
+        }
     };
 
     template <typename Fun>
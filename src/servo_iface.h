@@ -1,50 +1,388 @@
 #pragma once
 
 #include <memory>
+#include <atomic>
 #include <networking/tcp.h>
+#include <networking/udp.h>
 #include <cppmisc/json.h>
 #include <cppmisc/timing.h>
 #include "device_manager.h"
 #include "servo_protocol.h"
+#include "uring_io.h"
 
 
+/*
+ * Servo link over TCP or, with "transport": "udp" in the servo config,
+ * over UDP. The UDP link needs protocol v2: each datagram carries whole
+ * packets, and a lost or late one is just skipped.
+ *
+ * With "safe_timeout_usec" set (20 ms by default over UDP), torque
+ * commands are replaced by zero torque while no state has arrived for
+ * that long; stale state is worse than no state. Over UDP the zero torque
+ * is also sent while waiting for state: a blocking read times out after
+ * safe_timeout_usec, and the reader threads call keep_safe().
+ *
+ * "io_backend": "uring" moves TCP reads and writes to io_uring, see UringIo.
+ * The ring is single-threaded, so it needs the controller io_mode inline or
+ * epoll, where state reads and torque writes come from the same thread.
+ */
 class ServoIfc
 {
 private:
     std::shared_ptr<Connection> m_connection;
+    UdpPtr          m_udp;
+    UringIoPtr      m_uring;
     std::string     m_server_ip;
     int             m_server_port;
+    SocketProfile   m_socket_profile;
+    bool            m_use_udp;
+    int             m_local_port;   // of the udp socket, 0 for any
+    bool            m_use_uring;
 
-    ServoIfc() {}
+    int64_t         m_safe_timeout_usec;
+    std::atomic<int64_t> m_last_rx_nsec;    // written by the reader, read by set_torque
+    std::atomic<bool>       m_safe_torque;  // the last command was replaced
+    std::atomic<uint64_t>   m_safe_torques;
+
+    int             m_version;      // of the state packets requested on start
+    bool            m_compact;      // float payload in v2
+
+    // received bytes not decoded yet
+    char            m_rx_buf[4096];
+    int             m_rx_pos;
+    int             m_rx_filled;
+
+    // samples of the last decoded packet not handed out yet
+    Servo::Sample   m_samples[Servo::max_samples];
+    int             m_sample_pos;
+    int             m_nsamples;
+
+    uint64_t        m_skipped;
+    uint32_t        m_next_seq;
+    bool            m_seq_valid;
+    uint64_t        m_lost;
+    uint64_t        m_late;
+
+    // commands sent together on the next flush()
+    static const int max_queued = 8;
+    Servo::CmdPack  m_tx[max_queued];
+    int             m_tx_count;
+
+    ServoIfc() :
+        m_server_port(0), m_use_udp(false), m_local_port(0), m_use_uring(false),
+        m_safe_timeout_usec(0), m_last_rx_nsec(0), m_safe_torque(false), m_safe_torques(0),
+        m_version(1), m_compact(false), m_rx_pos(0), m_rx_filled(0), m_sample_pos(0), m_nsamples(0),
+        m_skipped(0), m_next_seq(0), m_seq_valid(false), m_lost(0), m_late(0), m_tx_count(0) {}
     ServoIfc(ServoIfc const&) = delete;
 
+    Servo::CmdPack* next_cmd()
+    {
+        if (m_tx_count == max_queued)
+            flush();
+        Servo::CmdPack* pack = &m_tx[m_tx_count ++];
+        memset(pack, 0, sizeof(*pack));
+        return pack;
+    }
+
+    bool connected() const
+    {
+        return m_connection || m_udp;
+    }
+
+    void reset_rx()
+    {
+        m_rx_pos = 0;
+        m_rx_filled = 0;
+        m_sample_pos = 0;
+        m_nsamples = 0;
+        m_seq_valid = false;
+    }
+
+    /*
+     * decodes the next complete state packet of the receive buffer into
+     * m_samples; returns 0 if there is none. Late v2 packets are dropped.
+     */
+    int decode_next()
+    {
+        while (true)
+        {
+            char const* p = m_rx_buf + m_rx_pos;
+            int size = Servo::get_info_size(p, m_rx_filled - m_rx_pos);
+            if (size < 0 && m_udp)
+            {
+                // the rest of a bad datagram
+                m_rx_pos = m_rx_filled;
+                return 0;
+            }
+            if (size < 0)
+                throw_runtime_error("server sent corrupted answer");
+            if (size == 0 || size > m_rx_filled - m_rx_pos)
+                return 0;
+
+            m_rx_pos += size;
+            m_sample_pos = 0;
+            m_last_rx_nsec.store(monotonic_nsec(), std::memory_order_relaxed);
+
+            if (!Servo::is_info_v2(p))
+            {
+                Servo::InfoPack ans;
+                memcpy(&ans, p, sizeof(ans));
+                m_samples[0].t = ans.t;
+                m_samples[0].theta = ans.theta;
+                m_samples[0].dtheta = ans.dtheta;
+                m_nsamples = 1;
+                return 1;
+            }
+
+            Servo::InfoHeaderV2 hdr;
+            m_nsamples = Servo::deserialize_info_v2(p, hdr, m_samples);
+
+            int32_t gap = int32_t(hdr.seq - m_next_seq);
+            if (m_seq_valid && gap < 0)
+            {
+                ++ m_late;
+                m_nsamples = 0;
+                continue;
+            }
+            if (m_seq_valid)
+                m_lost += gap;
+
+            m_next_seq = hdr.seq + 1;
+            m_seq_valid = true;
+            return 1;
+        }
+    }
+
+    bool stale() const
+    {
+        return m_safe_timeout_usec > 0 &&
+            monotonic_nsec() - m_last_rx_nsec.load(std::memory_order_relaxed) > m_safe_timeout_usec * 1000;
+    }
+
+    void count_safe_torque()
+    {
+        if (!m_safe_torque.exchange(true, std::memory_order_relaxed))
+            warn_msg("no servo state for ", m_safe_timeout_usec, "us, applying zero torque");
+        m_safe_torques.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*
+     * a datagram of its own, bypassing the command queue, so that the
+     * reader thread can send it while the control thread queues commands
+     */
+    void send_safe_torque()
+    {
+        Servo::CmdPack cmd;
+        memset(&cmd, 0, sizeof(cmd));
+        Servo::init_cmd_torque(epoch_usec(), 0., cmd);
+        count_safe_torque();
+        if (!m_udp->write(reinterpret_cast<char const*>(&cmd), sizeof(cmd)))
+            err_msg("can't send packet to server");
+    }
+
+    // a blocking read sends zero torque every safe_timeout_usec without state
+    int read_udp(char* buf, int sz, bool blocking)
+    {
+        if (!blocking || m_safe_timeout_usec <= 0)
+            return m_udp->read(buf, sz, blocking);
+
+        while (true)
+        {
+            int status = m_udp->read(buf, sz, m_safe_timeout_usec);
+            if (status != 0)
+                return status;
+            send_safe_torque();
+        }
+    }
+
+    /*
+     * reads what the socket has into the receive buffer; returns the
+     * number of bytes read, 0 if none, -1 if the connection was closed
+     * while blocking
+     */
+    int receive(bool blocking, int& space)
+    {
+        // packets don't span datagrams
+        if (m_udp)
+            m_rx_pos = m_rx_filled;
+
+        if (m_rx_pos > 0)
+        {
+            m_rx_filled -= m_rx_pos;
+            memmove(m_rx_buf, m_rx_buf + m_rx_pos, m_rx_filled);
+            m_rx_pos = 0;
+        }
+
+        space = sizeof(m_rx_buf) - m_rx_filled;
+        int status;
+        if (m_udp)
+            status = read_udp(m_rx_buf + m_rx_filled, space, blocking);
+        else if (m_uring)
+            status = m_uring->read(m_rx_buf + m_rx_filled, space, blocking);
+        else
+            status = m_connection->read(m_rx_buf + m_rx_filled, space, blocking);
+        if (status < 0)
+            throw_runtime_error("can't read from server");
+        if (status == 0)
+        {
+            if (blocking)
+            {
+                dbg_msg("connection was closed by server");
+                return -1;
+            }
+            return 0;
+        }
+
+        m_rx_filled += status;
+        return status;
+    }
+
+    // the start command may get lost, so it is repeated until state arrives
+    void start_udp()
+    {
+        m_udp = std::make_shared<Udp>(m_server_ip, m_server_port, m_local_port);
+        m_udp->set_profile(m_socket_profile);
+
+        const int attempts = 10;
+        for (int i = 0; i < attempts; ++ i)
+        {
+            Servo::init_cmd_start(epoch_usec(), m_version, m_compact, *next_cmd());
+            if (flush() < 0)
+                throw_runtime_error("can't send the start command to servo");
+
+            int status = m_udp->wait_for_data(100000);
+            if (status < 0)
+                throw_runtime_error("servo udp socket failed: ", m_udp->status());
+            if (status > 0)
+                return;
+        }
+
+        throw_runtime_error("servo ", m_server_ip, ":", m_server_port, " doesn't answer over udp");
+    }
+
 public:
     void init(Json::Value const& jscfg)
     {
         auto const& servocfg = json_get<Json::Value>(jscfg, "servo");
         json_get(servocfg, "ip", m_server_ip);
         json_get(servocfg, "port", m_server_port);
+        if (json_has(servocfg, "socket"))
+            json_get(servocfg, "socket", m_socket_profile);
+        if (json_has(servocfg, "protocol"))
+            json_get(servocfg, "protocol", m_version);
+        if (json_has(servocfg, "compact"))
+            m_compact = json_get(servocfg, "compact").asBool();
+        if (m_version != 1 && m_version != 2)
+            throw_runtime_error("unknown servo protocol version ", m_version);
+
+        std::string transport = "tcp";
+        if (json_has(servocfg, "transport"))
+            json_get(servocfg, "transport", transport);
+        if (transport != "tcp" && transport != "udp")
+            throw_runtime_error("unknown servo transport ", transport);
+        m_use_udp = transport == "udp";
+        if (m_use_udp && m_version != 2)
+            throw_runtime_error("servo udp transport needs protocol 2");
+
+        if (json_has(servocfg, "local_port"))
+            json_get(servocfg, "local_port", m_local_port);
+
+        std::string io_backend = "socket";
+        if (json_has(servocfg, "io_backend"))
+            json_get(servocfg, "io_backend", io_backend);
+        if (io_backend != "socket" && io_backend != "uring")
+            throw_runtime_error("unknown servo io_backend ", io_backend);
+        m_use_uring = io_backend == "uring";
+        if (m_use_uring && m_use_udp)
+            throw_runtime_error("servo io_backend uring works over tcp only");
+
+        m_safe_timeout_usec = m_use_udp ? 20000 : 0;
+        if (json_has(servocfg, "safe_timeout_usec"))
+            json_get(servocfg, "safe_timeout_usec", m_safe_timeout_usec);
     }
 
     void start()
     {
-        m_connection = Connection::connect(m_server_ip, m_server_port);
+        m_tx_count = 0;
+        reset_rx();
+        m_last_rx_nsec.store(monotonic_nsec(), std::memory_order_relaxed);
+        m_safe_torque = false;
+
+        if (m_use_udp)
+        {
+            start_udp();
+            return;
+        }
+
+        m_connection = Connection::connect(m_server_ip, m_server_port, m_socket_profile);
         if (!m_connection)
             throw_runtime_error("can't connect to ", m_server_ip, ":", m_server_port);
+        if (m_use_uring)
+            m_uring = std::make_shared<UringIo>(m_connection->fd());
 
-        int64_t t = epoch_usec();
-        Servo::CmdPack pack;
-        Servo::init_cmd_start(t, pack);
-        if (!m_connection->write(reinterpret_cast<char*>(&pack), sizeof(pack)))
+        Servo::init_cmd_start(epoch_usec(), m_version, m_compact, *next_cmd());
+        if (flush() < 0)
             throw_runtime_error("servo connection broken");
     }
 
+    // zeroes the torque and sends the stop command in one write
     void stop()
     {
+        if (connected())
+        {
+            queue_torque(0.);
+            queue_stop();
+            flush();
+        }
+
+        m_uring.reset();
         m_connection.reset();
+        m_udp.reset();
+        reset_rx();
+        m_tx_count = 0;
+    }
+
+    bool uses_uring() const
+    {
+        return m_use_uring;
+    }
+
+    int fd() const
+    {
+        if (!connected())
+            throw_runtime_error("servo is not connected");
+        if (m_udp)
+            return m_udp->fd();
+        return m_uring ? m_uring->fd() : m_connection->fd();
+    }
+
+    /*
+     * return value:
+     *  -1 -- failed
+     *   0 -- timed out
+     *   1 -- data available
+     */
+    int wait_for_data(int64_t usec)
+    {
+        if (!connected())
+            throw_runtime_error("can't wait for state: not connected");
+
+        int status;
+        if (m_udp)
+            status = m_udp->wait_for_data(usec);
+        else if (m_uring)
+            status = m_uring->wait_for_data(usec);
+        else
+            status = m_connection->wait_for_data(usec);
+        if (status < 0)
+            return -1;
+        return status > 0 ? 1 : 0;
     }
 
     /*
+     * Hands out the received samples one by one, in order. A v2 packet
+     * carries several of them, so a call may return without reading.
+     *
      * return value:
      *  -1 -- connection closed
      *   0 -- no data received (non-blocking mode)
@@ -52,56 +390,178 @@ public:
      */
     int get_state(int64_t& t, double& theta, double& dtheta, bool blocking)
     {
-        if (!m_connection)
+        if (!connected())
             throw_runtime_error("can't read state: not connected");
 
-        Servo::InfoPack ans;
-        int status = m_connection->read(reinterpret_cast<char*>(&ans), sizeof(ans), blocking);
-        if (status == 0)
+        while (m_sample_pos == m_nsamples)
         {
-            if (blocking)
+            if (decode_next())
+                continue;
+
+            int space;
+            int status = receive(blocking, space);
+            if (status <= 0)
+                return status;
+        }
+
+        Servo::Sample const& sample = m_samples[m_sample_pos ++];
+        t = sample.t;
+        theta = sample.theta;
+        dtheta = sample.dtheta;
+        return 1;
+    }
+
+    /*
+     * Drains all complete packets the socket has and returns only the
+     * newest sample; the older ones are counted in skipped(). A single
+     * read usually suffices. Return values are the same as of get_state.
+     */
+    int get_latest_state(int64_t& t, double& theta, double& dtheta, bool blocking)
+    {
+        if (!connected())
+            throw_runtime_error("can't read state: not connected");
+
+        Servo::Sample latest;
+        int64_t nsamples = 0;
+        bool drained = false;
+
+        while (true)
+        {
+            do
             {
-                dbg_msg("connection was closed by server");
-                return -1;
+                if (m_sample_pos < m_nsamples)
+                {
+                    nsamples += m_nsamples - m_sample_pos;
+                    latest = m_samples[m_nsamples - 1];
+                    m_sample_pos = m_nsamples;
+                }
             }
-            return 0;
+            while (decode_next());
+
+            // with blocking, wait until there is a sample
+            if (drained && !(blocking && nsamples == 0))
+                break;
+
+            int space;
+            int status = receive(blocking && nsamples == 0, space);
+            if (status < 0)
+                return -1;
+
+            // a short read means the socket is drained; a datagram is
+            // always short, so with udp only an empty read does
+            drained = m_udp ? status == 0 : status < space;
         }
 
-        if (status < 0)
-            throw_runtime_error("can't read from server");
+        if (nsamples == 0)
+            return 0;
 
-        if (status == sizeof(ans))
+        m_skipped += nsamples - 1;
+        t = latest.t;
+        theta = latest.theta;
+        dtheta = latest.dtheta;
+        return 1;
+    }
+
+    // number of states dropped by get_latest_state
+    uint64_t skipped() const
+    {
+        return m_skipped;
+    }
+
+    // v2 packets that never arrived and that arrived after a newer one
+    uint64_t lost() const
+    {
+        return m_lost;
+    }
+
+    uint64_t late() const
+    {
+        return m_late;
+    }
+
+    /*
+     * Commands are queued and go out in a single write on flush();
+     * a full queue is flushed first
+     */
+    void queue_torque(double torque)
+    {
+        Servo::init_cmd_torque(epoch_usec(), torque, *next_cmd());
+    }
+
+    void queue_stop()
+    {
+        Servo::init_cmd_stop(epoch_usec(), *next_cmd());
+    }
+
+    int flush()
+    {
+        if (m_tx_count == 0)
+            return 0;
+
+        if (!connected())
         {
-            if (!Servo::verify_pack(ans))
-                throw_runtime_error("server sent corrupted answer");
+            err_msg("can't send commands: not connected");
+            m_tx_count = 0;
+            return -1;
+        }
 
-            t = ans.t;
-            theta = ans.theta;
-            dtheta = ans.dtheta;
-            return 1;
+        // with udp the queued commands make up one datagram
+        int len = m_tx_count * int(sizeof(Servo::CmdPack));
+        m_tx_count = 0;
+        char const* data = reinterpret_cast<char const*>(m_tx);
+        bool ok;
+        if (m_udp)
+            ok = m_udp->write(data, len);
+        else if (m_uring)
+            ok = m_uring->write(data, len);
+        else
+            ok = m_connection->write(data, len);
+        if (!ok)
+        {
+            err_msg("can't send packet to server");
+            return -1;
         }
 
-        throw_runtime_error("unexpected answer from server");
+        return 0;
     }
 
     int set_torque(double const& torque)
     {
-        if (!m_connection)
+        if (!connected())
         {
             err_msg("can't set torque: not connected");
             return -1;
         }
 
-        int64_t t = epoch_usec();
-        Servo::CmdPack pack;
-        Servo::init_cmd_torque(t, torque, pack);
-        if (!m_connection->write(reinterpret_cast<char*>(&pack), sizeof(pack)))
+        if (stale())
         {
-            err_msg("can't send packet to server");
-            return -1;
+            count_safe_torque();
+            queue_torque(0.);
+        }
+        else
+        {
+            m_safe_torque.store(false, std::memory_order_relaxed);
+            queue_torque(torque);
         }
 
-        return 0;
+        return flush();
+    }
+
+    /*
+     * sends zero torque over UDP if no state has come for safe_timeout_usec;
+     * for loops that wait for state without reading, as nothing calls
+     * set_torque() meanwhile. Callable from the reader thread.
+     */
+    void keep_safe()
+    {
+        if (m_udp && stale())
+            send_safe_torque();
+    }
+
+    // torque commands replaced by zero torque because of stale state
+    uint64_t safe_torques() const
+    {
+        return m_safe_torques.load(std::memory_order_relaxed);
     }
 
     static std::shared_ptr<ServoIfc> capture_instance()
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <cstring>
 #include <assert.h>
+#include <algorithm>
 
 namespace Servo
 {
@@ -12,6 +13,8 @@ namespace Servo
     static const char _cmd_start[] = "start";
     static const char _cmd_stop[] = "stop";
     static const char _cmd_torque[] = "torque";
+    static const char _cmd_start_v2[] = "startv2";
+    static const char _cmd_start_v2f[] = "startv2f";
     static const int _magic_len = 8;
     static const int _cmd_len = 8;
 
@@ -21,6 +24,8 @@ namespace Servo
         CmdStart = 1,
         CmdStop = 2,
         CmdTorque = 3,
+        CmdStartV2 = 4,
+        CmdStartV2F = 5,
     };
 
     struct alignas(8) InfoPack
@@ -43,15 +48,19 @@ namespace Servo
     static_assert(sizeof(_cmd_torque) - 1 <= sizeof(CmdPack::cmd), "incorrect _cmd_torque");
     static_assert(sizeof(_cmd_stop) - 1 <= sizeof(CmdPack::cmd), "incorrect _cmd_stop");
     static_assert(sizeof(_cmd_start) - 1 <= sizeof(CmdPack::cmd), "incorrect _cmd_start");
+    static_assert(sizeof(_cmd_start_v2f) - 1 <= sizeof(CmdPack::cmd), "incorrect _cmd_start_v2f");
 
     inline void 
     set_cmd(CmdPack& pack, Cmd cmd_type)
     {
+        std::memset(pack.cmd, 0, sizeof(pack.cmd));
         switch (cmd_type)
         {
         case CmdStart: std::memcpy(pack.cmd, _cmd_start, sizeof(_cmd_start) - 1); break;
         case CmdStop: std::memcpy(pack.cmd, _cmd_stop, sizeof(_cmd_stop) - 1); break;
         case CmdTorque: std::memcpy(pack.cmd, _cmd_torque, sizeof(_cmd_torque) - 1); break;
+        case CmdStartV2: std::memcpy(pack.cmd, _cmd_start_v2, sizeof(_cmd_start_v2) - 1); break;
+        case CmdStartV2F: std::memcpy(pack.cmd, _cmd_start_v2f, sizeof(_cmd_start_v2f) - 1); break;
         default: assert(false);
         };
     }
@@ -59,6 +68,11 @@ namespace Servo
     inline Cmd 
     get_cmd(CmdPack const& pack)
     {
+        // v2 starts first: v1 firmware takes them for a plain start
+        if (std::memcmp(pack.cmd, _cmd_start_v2f, sizeof(_cmd_start_v2f) - 1) == 0)
+            return CmdStartV2F;
+        if (std::memcmp(pack.cmd, _cmd_start_v2, sizeof(_cmd_start_v2)) == 0)
+            return CmdStartV2;
         if (std::memcmp(pack.cmd, _cmd_start, sizeof(_cmd_start) - 1) == 0)
             return CmdStart;
         if (std::memcmp(pack.cmd, _cmd_stop, sizeof(_cmd_stop) - 1) == 0)
@@ -198,6 +212,21 @@ namespace Servo
         pack.torque = 0.0;
     }
 
+    // v1 firmware ignores the version and answers with InfoPack
+    inline void
+    init_cmd_start(
+        int64_t const& t,
+        int version,
+        bool compact,
+        CmdPack& pack
+        )
+    {
+        set_magic(pack);
+        set_cmd(pack, version < 2 ? CmdStart : compact ? CmdStartV2F : CmdStartV2);
+        pack.t = t;
+        pack.torque = 0.0;
+    }
+
     inline void
     serialize_cmd_stop(
         int64_t const& t,
@@ -212,6 +241,18 @@ namespace Servo
         p->torque = 0.0;
     }
 
+    inline void
+    init_cmd_stop(
+        int64_t const& t,
+        CmdPack& pack
+        )
+    {
+        set_magic(pack);
+        set_cmd(pack, CmdStop);
+        pack.t = t;
+        pack.torque = 0.0;
+    }
+
     inline void
     serialize_cmd_torque(
         int64_t const& t,
@@ -267,4 +308,177 @@ namespace Servo
         return deserialize_cmd(reinterpret_cast<char const*>(&buf[0]), buf.size(), result);
     }
 
+
+    /*
+     * State packets v2
+     *
+     * Requested with the startv2 (double payload) or startv2f (float
+     * payload) command. A packet is a header followed by nsamples samples;
+     * seq counts packets from 0, so the receiver can tell lost and late
+     * ones. The integer magic distinguishes v2 from v1 packets on the same
+     * stream.
+     */
+    static const uint32_t _magic_v2 = 0x32767273;  // "srv2"
+    static const int max_samples = 32;
+
+    enum Encoding
+    {
+        EncodingDouble = 0,
+        EncodingFloat = 1,
+    };
+
+    struct alignas(8) InfoHeaderV2
+    {
+        uint32_t magic;
+        uint32_t seq;
+        uint16_t size;          // of the whole packet
+        uint8_t  encoding;
+        uint8_t  nsamples;
+        uint32_t reserved;
+    };
+
+    struct Sample
+    {
+        int64_t t;
+        double theta;
+        double dtheta;
+    };
+
+    struct SampleF
+    {
+        int64_t t;
+        float theta;
+        float dtheta;
+    };
+
+    static_assert(sizeof(InfoHeaderV2) == 16, "unexpected InfoHeaderV2 layout");
+    static_assert(sizeof(Sample) == 24 && sizeof(SampleF) == 16, "unexpected sample layout");
+
+    inline int
+    get_sample_size(int encoding)
+    {
+        return encoding == EncodingFloat ? sizeof(SampleF) : sizeof(Sample);
+    }
+
+    inline int
+    get_info_v2_size(int encoding, int nsamples)
+    {
+        return sizeof(InfoHeaderV2) + nsamples * get_sample_size(encoding);
+    }
+
+    // buf holds at least 4 bytes
+    inline bool
+    is_info_v2(char const* buf)
+    {
+        uint32_t magic;
+        memcpy(&magic, buf, sizeof(magic));
+        return magic == _magic_v2;
+    }
+
+    /*
+     * size of the state packet, v1 or v2, at the beginning of buf;
+     * 0 if more data is needed, -1 if it is not a state packet
+     */
+    inline int
+    get_info_size(char const* buf, int len)
+    {
+        if (len < (int)sizeof(uint32_t))
+            return 0;
+
+        if (is_info_v2(buf))
+        {
+            if (len < (int)sizeof(InfoHeaderV2))
+                return 0;
+
+            InfoHeaderV2 hdr;
+            memcpy(&hdr, buf, sizeof(hdr));
+            if (hdr.encoding > EncodingFloat || hdr.nsamples > max_samples ||
+                hdr.size != get_info_v2_size(hdr.encoding, hdr.nsamples))
+                return -1;
+            return hdr.size;
+        }
+
+        int n = std::min<int>(len, sizeof(_magic) - 1);
+        if (memcmp(buf, _magic, n) != 0)
+            return -1;
+        return sizeof(InfoPack);
+    }
+
+    /*
+     * returns the packet size or -1 if it doesn't fit
+     */
+    inline int
+    serialize_info_v2(
+        uint32_t seq,
+        Sample const* samples,
+        int nsamples,
+        int encoding,
+        char* buf,
+        int bufsz
+        )
+    {
+        assert(nsamples <= max_samples);
+        int size = get_info_v2_size(encoding, nsamples);
+        if (bufsz < size)
+            return -1;
+
+        InfoHeaderV2 hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.magic = _magic_v2;
+        hdr.seq = seq;
+        hdr.size = uint16_t(size);
+        hdr.encoding = uint8_t(encoding);
+        hdr.nsamples = uint8_t(nsamples);
+        memcpy(buf, &hdr, sizeof(hdr));
+
+        char* p = buf + sizeof(hdr);
+        for (int i = 0; i < nsamples; ++ i)
+        {
+            if (encoding == EncodingFloat)
+            {
+                SampleF sf = {samples[i].t, float(samples[i].theta), float(samples[i].dtheta)};
+                memcpy(p, &sf, sizeof(sf));
+                p += sizeof(sf);
+            }
+            else
+            {
+                memcpy(p, &samples[i], sizeof(Sample));
+                p += sizeof(Sample);
+            }
+        }
+        return size;
+    }
+
+    /*
+     * buf holds a complete packet as sized by get_info_size; returns the
+     * number of samples
+     */
+    inline int
+    deserialize_info_v2(
+        char const* buf,
+        InfoHeaderV2& hdr,
+        Sample* samples
+        )
+    {
+        memcpy(&hdr, buf, sizeof(hdr));
+        char const* p = buf + sizeof(hdr);
+        for (int i = 0; i < hdr.nsamples; ++ i)
+        {
+            if (hdr.encoding == EncodingFloat)
+            {
+                SampleF sf;
+                memcpy(&sf, p, sizeof(sf));
+                samples[i].t = sf.t;
+                samples[i].theta = sf.theta;
+                samples[i].dtheta = sf.dtheta;
+                p += sizeof(sf);
+            }
+            else
+            {
+                memcpy(&samples[i], p, sizeof(Sample));
+                p += sizeof(Sample);
+            }
+        }
+        return hdr.nsamples;
+    }
 }
@@ -0,0 +1,225 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include <cppmisc/throws.h>
+#include <cppmisc/timing.h>
+#include "shm_ring.h"
+
+using namespace std;
+
+
+namespace
+{
+    const uint32_t magic = 0x474e5252;  // "RRNG"
+
+    // the word is in shared memory, so the futex can't be process private
+    int futex_wait(std::atomic<uint32_t>* addr, uint32_t val, int64_t usec)
+    {
+        timespec ts;
+        ts.tv_sec = usec / 1000000;
+        ts.tv_nsec = (usec % 1000000) * 1000;
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, val, &ts, nullptr, 0);
+    }
+
+    void futex_wake(std::atomic<uint32_t>* addr)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+}
+
+const uint32_t ShmRing::version;
+const int ShmRing::header_size;
+
+ShmRing::ShmRing(string const& name, bool owner, void* p, size_t mapped) :
+    m_name(name),
+    m_owner(owner),
+    m_hdr(reinterpret_cast<Header*>(p)),
+    m_data(reinterpret_cast<char*>(p) + header_size),
+    m_mask(m_hdr->capacity - 1),
+    m_mapped(mapped)
+{
+}
+
+ShmRing::~ShmRing()
+{
+    if (m_owner)
+    {
+        // a consumer sleeping in wait_for_data() learns about it at once
+        m_hdr->closed.store(1, std::memory_order_release);
+        m_hdr->wakeup.fetch_add(1, std::memory_order_seq_cst);
+        if (m_hdr->waiters.load(std::memory_order_seq_cst) > 0)
+            futex_wake(&m_hdr->wakeup);
+    }
+
+    munmap(m_hdr, m_mapped);
+    if (m_owner)
+        shm_unlink(m_name.c_str());
+}
+
+ShmRingPtr ShmRing::create(string const& name, size_t capacity)
+{
+    size_t cap = 4096;
+    while (cap < capacity)
+        cap *= 2;
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        throw_runtime_error("can't create shared memory ", name, ": ", strerror(errno));
+
+    size_t size = header_size + cap;
+    if (ftruncate(fd, size) < 0)
+    {
+        int err = errno;
+        close(fd);
+        shm_unlink(name.c_str());
+        throw_runtime_error("can't resize shared memory ", name, ": ", strerror(err));
+    }
+
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        throw_runtime_error("can't map shared memory ", name, ": ", strerror(err));
+    }
+
+    Header* hdr = new (p) Header;
+    hdr->version = version;
+    hdr->capacity = cap;
+    hdr->head.store(0, std::memory_order_relaxed);
+    hdr->tail.store(0, std::memory_order_relaxed);
+    hdr->wakeup.store(0, std::memory_order_relaxed);
+    hdr->waiters.store(0, std::memory_order_relaxed);
+    hdr->heartbeat.store(monotonic_nsec(), std::memory_order_relaxed);
+    hdr->closed.store(0, std::memory_order_relaxed);
+
+    // the magic tells the consumer the header is complete
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr->magic = magic;
+
+    return ShmRingPtr(new ShmRing(name, true, p, size));
+}
+
+ShmRingPtr ShmRing::open(string const& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        throw_runtime_error("can't open shared memory ", name, ": ", strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < header_size)
+    {
+        close(fd);
+        throw_runtime_error("shared memory ", name, " is not a ring");
+    }
+
+    size_t size = st.st_size;
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (p == MAP_FAILED)
+        throw_runtime_error("can't map shared memory ", name, ": ", strerror(err));
+
+    Header* hdr = reinterpret_cast<Header*>(p);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t cap = hdr->capacity;
+    bool pow2 = cap > 0 && (cap & (cap - 1)) == 0;
+    if (hdr->magic != magic || hdr->version != version || !pow2 || header_size + cap != size)
+    {
+        munmap(p, size);
+        throw_runtime_error("shared memory ", name, " is not a ring of version ", version);
+    }
+
+    return ShmRingPtr(new ShmRing(name, false, p, size));
+}
+
+bool ShmRing::write(char const* data, int len)
+{
+    uint64_t head = m_hdr->head.load(std::memory_order_relaxed);
+    uint64_t tail = m_hdr->tail.load(std::memory_order_acquire);
+    if (head - tail + len > capacity())
+        return false;
+
+    uint64_t offset = head & m_mask;
+    uint64_t first = std::min<uint64_t>(len, capacity() - offset);
+    memcpy(m_data + offset, data, first);
+    memcpy(m_data, data + first, len - first);
+    m_hdr->head.store(head + len, std::memory_order_release);
+    m_hdr->heartbeat.store(monotonic_nsec(), std::memory_order_relaxed);
+
+    // a sleeping consumer registers itself before it checks head again
+    m_hdr->wakeup.fetch_add(1, std::memory_order_seq_cst);
+    if (m_hdr->waiters.load(std::memory_order_seq_cst) > 0)
+        futex_wake(&m_hdr->wakeup);
+    return true;
+}
+
+void ShmRing::heartbeat()
+{
+    m_hdr->heartbeat.store(monotonic_nsec(), std::memory_order_relaxed);
+}
+
+int ShmRing::read(char* buf, int len)
+{
+    uint64_t tail = m_hdr->tail.load(std::memory_order_relaxed);
+    uint64_t head = m_hdr->head.load(std::memory_order_acquire);
+    uint64_t n = std::min<uint64_t>(len, head - tail);
+    if (n == 0)
+        return 0;
+
+    uint64_t offset = tail & m_mask;
+    uint64_t first = std::min<uint64_t>(n, capacity() - offset);
+    memcpy(buf, m_data + offset, first);
+    memcpy(buf + first, m_data, n - first);
+    m_hdr->tail.store(tail + n, std::memory_order_release);
+    return int(n);
+}
+
+int ShmRing::available() const
+{
+    uint64_t tail = m_hdr->tail.load(std::memory_order_relaxed);
+    uint64_t head = m_hdr->head.load(std::memory_order_acquire);
+    return int(head - tail);
+}
+
+int ShmRing::wait_for_data(int64_t usec)
+{
+    if (available() > 0)
+        return 1;
+    if (m_hdr->closed.load(std::memory_order_acquire))
+        return -1;
+
+    m_hdr->waiters.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t seq = m_hdr->wakeup.load(std::memory_order_seq_cst);
+    int status = 1;
+    if (available() == 0)
+    {
+        int res = futex_wait(&m_hdr->wakeup, seq, usec);
+        if (res < 0 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+            status = -1;
+    }
+    m_hdr->waiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    if (status < 0)
+        return -1;
+    if (available() > 0)
+        return 1;
+    return m_hdr->closed.load(std::memory_order_acquire) ? -1 : 0;
+}
+
+bool ShmRing::producer_alive(int64_t timeout_usec) const
+{
+    if (m_hdr->closed.load(std::memory_order_acquire))
+        return false;
+    if (timeout_usec <= 0)
+        return true;
+    return monotonic_nsec() - m_hdr->heartbeat.load(std::memory_order_relaxed) <= timeout_usec * 1000;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+
+/*
+ * Single-producer single-consumer byte ring in POSIX shared memory
+ *
+ * For processes on the same host, e.g. the camera server and the
+ * controller. The producer create()s the object and writes whole messages;
+ * the consumer open()s it and reads bytes as from a socket. Neither side
+ * makes a syscall while data flows: the consumer sleeps on a futex only
+ * in wait_for_data(), and only then does the producer wake it.
+ *
+ * The producer's destructor marks the ring closed, and every write stamps
+ * a heartbeat, so the consumer can tell a producer that is gone from one
+ * that has nothing to say; a producer that may be idle for long calls
+ * heartbeat().
+ *
+ * Layout:
+ *   header      4096 bytes (magic, version, capacity, positions, futex,
+ *               liveness)
+ *   data        capacity bytes, a power of two
+ */
+class ShmRing;
+typedef std::shared_ptr<ShmRing> ShmRingPtr;
+
+class ShmRing
+{
+public:
+    static const uint32_t version = 2;
+    static const int header_size = 4096;
+
+private:
+    struct Header
+    {
+        uint32_t                magic;
+        uint32_t                version;
+        uint64_t                capacity;
+        alignas(64) std::atomic<uint64_t> head;     // bytes written, by the producer
+        alignas(64) std::atomic<uint64_t> tail;     // bytes read, by the consumer
+        alignas(64) std::atomic<uint32_t> wakeup;   // futex word, bumped on writes
+        std::atomic<uint32_t>   waiters;
+        alignas(64) std::atomic<int64_t> heartbeat; // CLOCK_MONOTONIC nsec of the last write
+        std::atomic<uint32_t>   closed;             // set by the producer when it goes away
+    };
+
+    static_assert(sizeof(Header) <= header_size, "ShmRing header doesn't fit");
+
+    std::string m_name;
+    bool        m_owner;
+    Header*     m_hdr;
+    char*       m_data;
+    uint64_t    m_mask;
+    size_t      m_mapped;
+
+    ShmRing(std::string const& name, bool owner, void* p, size_t mapped);
+    ShmRing(ShmRing const&) = delete;
+
+public:
+    ~ShmRing();
+
+    // producer side; capacity is rounded up to a power of two
+    static ShmRingPtr create(std::string const& name, size_t capacity);
+
+    // consumer side
+    static ShmRingPtr open(std::string const& name);
+
+    // writes all of len bytes, or nothing if they don't fit
+    bool write(char const* data, int len);
+
+    // tells the consumer the producer is alive without writing
+    void heartbeat();
+
+    // copies up to len bytes; returns the number copied, 0 if empty
+    int read(char* buf, int len);
+
+    // bytes ready for read()
+    int available() const;
+
+    /*
+     * blocks the consumer until there is data, at most usec
+     *  1 -- data available
+     *  0 -- timed out
+     * -1 -- failed, or the producer closed the ring and it is drained
+     */
+    int wait_for_data(int64_t usec);
+
+    /*
+     * false once the producer has closed the ring, or when it has been
+     * silent for more than timeout_usec; timeout_usec <= 0 checks only
+     * the former
+     */
+    bool producer_alive(int64_t timeout_usec) const;
+
+    inline uint64_t capacity() const { return m_mask + 1; }
+};
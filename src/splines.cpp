@@ -5,20 +5,18 @@
 #include <string>
 #include <algorithm>
 #include <cppmisc/throws.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 #include "splines.h"
+#include "static_spline.h"
 #include "math_helpers.h"
 
 
 using namespace std;
-
-
-/*
- * k!
- */
-constexpr int fact(int k)
-{
-	return k > 0 ? k * fact(k-1) : 1;
-}
+using spline_detail::fact;
 
 /*
  * n! / k! (n-k)! for k=0..n
@@ -40,6 +38,92 @@ T max_value(vector<T> const& a)
 	return *max_element(a.begin(), a.end());
 }
 
+/*
+ * polynomial of degree up to n, c[k] is the coefficient of t^k;
+ * the B-spline recursions run on it to get the power basis form
+ */
+template <int n>
+struct poly
+{
+	double c[n + 1];
+
+	poly(double c0 = 0.0, double c1 = 0.0)
+	{
+		fill(c, c + n + 1, 0.0);
+		c[0] = c0;
+		if (n > 0)
+			c[1] = c1;
+	}
+};
+
+template <int n>
+inline poly<n> operator + (poly<n> const& a, poly<n> const& b)
+{
+	poly<n> r;
+	for (int k = 0; k <= n; ++ k)
+		r.c[k] = a.c[k] + b.c[k];
+	return r;
+}
+
+template <int n>
+inline poly<n> operator + (poly<n> const& a, double b)
+{
+	poly<n> r = a;
+	r.c[0] += b;
+	return r;
+}
+
+template <int n>
+inline poly<n> operator - (poly<n> const& a, double b)
+{
+	poly<n> r = a;
+	r.c[0] -= b;
+	return r;
+}
+
+template <int n>
+inline poly<n> operator - (double a, poly<n> const& b)
+{
+	poly<n> r;
+	for (int k = 0; k <= n; ++ k)
+		r.c[k] = -b.c[k];
+	r.c[0] += a;
+	return r;
+}
+
+template <int n>
+inline poly<n> operator - (poly<n> const& a)
+{
+	return 0.0 - a;
+}
+
+template <int n>
+inline poly<n> operator / (poly<n> const& a, double b)
+{
+	poly<n> r;
+	for (int k = 0; k <= n; ++ k)
+		r.c[k] = a.c[k] / b;
+	return r;
+}
+
+// the recursions never make the degree exceed n
+template <int n>
+inline poly<n> operator * (poly<n> const& a, poly<n> const& b)
+{
+	poly<n> r;
+	for (int i = 0; i <= n; ++ i)
+		for (int j = 0; i + j <= n; ++ j)
+			r.c[i + j] += a.c[i] * b.c[j];
+	return r;
+}
+
+
+void basic_spline::eval(double const* x, double* y, size_t len, int der) const
+{
+	for (size_t i = 0; i < len; ++ i)
+		y[i] = val(x[i], der);
+}
+
 
 /*
  * non-uniform knots spline
@@ -59,8 +143,8 @@ private:
 	 * $ A_{k,j}=\frac{x-u_{l-j}}{u_{l+k-j}-u_{l-j}} $
 	 * $ B_{k,j}=\frac{u_{l-j+k}-x}{u_{l-j+k}-u_{l-j}} $, $k = 1..n, j = 0..n-1$
 	 */
-	template <int k, int j>
-	inline double sum(int l, double x) const
+	template <int k, int j, typename X>
+	inline X sum(int l, X const& x) const
 	{
 		if (k == n + 1)
 			return coefs[l - j];
@@ -68,8 +152,8 @@ private:
 		constexpr int nk = k > n ? k : k + 1;
 		constexpr int nj = k > n ? j : j + 1;
 
-		double const Akj = (x - knots[l - j]) / (knots[l - j + k] - knots[l - j]);
-		double const Bkj = 1.0 - Akj;
+		X const Akj = (x - knots[l - j]) / (knots[l - j + k] - knots[l - j]);
+		X const Bkj = 1.0 - Akj;
 
 		return Akj * sum<nk,j>(l, x) + Bkj * sum<nk,nj>(l, x);	
 	}
@@ -205,6 +289,24 @@ public:
 	{
 	}
 
+	/*
+	 * intervals [knots[l], knots[l+1]) of nonzero length the recursion
+	 * can evaluate, in the power basis of x - knots[l]
+	 */
+	void power_basis(vector<double>& breaks, vector<double>& pcoefs) const
+	{
+		int const last = min(int(knots.size()) - 1 - n, int(coefs.size()) - 1);
+		for (int l = n; l <= last; ++ l)
+		{
+			if (knots[l + 1] <= knots[l])
+				continue;
+
+			poly<n> const p = sum<1,0>(l, poly<n>(knots[l], 1.0));
+			breaks.push_back(knots[l]);
+			pcoefs.insert(pcoefs.end(), p.c, p.c + n + 1);
+		}
+	}
+
 	~non_uniform_spline()
 	{
 	}
@@ -239,6 +341,53 @@ public:
 		int const l = get_knot(x);
 		return der3_sum(l, x);
 	}
+
+	virtual void eval_all(double x, double* out, int maxder) const
+	{
+		if (maxder > 3)
+			throw_runtime_error("can't evaluare derivative");
+
+		int const l = get_knot(x);
+		out[0] = sum(l, x);
+		if (maxder >= 1)
+			out[1] = der_sum(l, x);
+		if (maxder >= 2)
+			out[2] = der2_sum(l, x);
+		if (maxder >= 3)
+			out[3] = der3_sum(l, x);
+	}
+
+	/*
+	 * sorted arguments walk the knots from the interval of the previous one
+	 */
+	virtual void eval(double const* x, double* y, size_t len, int der) const
+	{
+		if (der < 0 || der > 3)
+			throw_runtime_error("can't evaluare derivative");
+
+		if (len == 0 || !is_sorted(x, x + len))
+		{
+			basic_spline::eval(x, y, len, der);
+			return;
+		}
+
+		int l = get_knot(x[0]);
+		int const nknots = int(knots.size());
+		for (size_t i = 0; i < len; ++ i)
+		{
+			double const xi = x[i];
+			while (l + 1 < nknots && xi >= knots[l + 1])
+				++ l;
+
+			switch (der)
+			{
+			case 0: y[i] = sum(l, xi); break;
+			case 1: y[i] = der_sum(l, xi); break;
+			case 2: y[i] = der2_sum(l, xi); break;
+			default: y[i] = der3_sum(l, xi); break;
+			}
+		}
+	}
 };
 
 
@@ -254,8 +403,8 @@ private:
 	vector<double> coefs;
 
 private:
-	template <int k, int j>
-	inline double sum(int l, double x) const
+	template <int k, int j, typename X>
+	inline X sum(int l, X const& x) const
 	{
 		if (k == n + 1)
 			return coefs[l - j];
@@ -263,8 +412,8 @@ private:
 		constexpr int nk = k > n ? k : k + 1;
 		constexpr int nj = k > n ? j : j + 1;
 
-		double const Akj = (x - l + j);
-		double const Bkj = -(x - l + j -k);
+		X const Akj = (x - l + j);
+		X const Bkj = -(x - l + j -k);
 
 		return Akj * sum<nk,j>(l, x) + Bkj * sum<nk,nj>(l, x);
 	}
@@ -349,6 +498,21 @@ public:
 		step = (maxval - minval) / (coefs.size() - 1);
 	}
 
+	/*
+	 * intervals l = n.. the recursion can evaluate, in the power basis of
+	 * u = (x - minval) / step - l
+	 */
+	void power_basis(double& origin, double& interval, vector<double>& pcoefs) const
+	{
+		origin = minval;
+		interval = step;
+		for (int l = n; l < int(coefs.size()); ++ l)
+		{
+			poly<n> const p = sum<1,0>(l, poly<n>(l, 1.0)) / fact(n);
+			pcoefs.insert(pcoefs.end(), p.c, p.c + n + 1);
+		}
+	}
+
 	~uniform_spline()
 	{
 	}
@@ -384,8 +548,293 @@ public:
 		return der3_sum(l, x);
 	}
 
+	virtual void eval_all(double x, double* out, int maxder) const
+	{
+		if (maxder > 3)
+			throw_runtime_error("can't evaluare derivative");
+
+		int const l = get_knot(x);
+		out[0] = sum(l, x);
+		if (maxder >= 1)
+			out[1] = der_sum(l, x);
+		if (maxder >= 2)
+			out[2] = der2_sum(l, x);
+		if (maxder >= 3)
+			out[3] = der3_sum(l, x);
+	}
+
+};
+
+
+/*
+ * batch kernels of the power basis
+ *
+ * Arrays are evaluated in chunks. The interval of each argument is found
+ * first: arithmetically for uniform intervals, by walking the breaks for
+ * sorted arguments and by a branchless binary search otherwise. Then the
+ * polynomials of the chunk are evaluated side by side, with AVX2 or NEON
+ * when the target has them.
+ */
+namespace batch
+{
+	int const chunk = 256;
+
+	template <int n>
+	void locate_uniform(double const* x, int len, double origin, double inv_step, int nintervals, int* idx, double* t)
+	{
+		int i = 0;
+#if defined(__AVX2__)
+		__m256d const org = _mm256_set1_pd(origin);
+		__m256d const inv = _mm256_set1_pd(inv_step);
+		__m128i const deg = _mm_set1_epi32(n);
+		__m128i const last = _mm_set1_epi32(nintervals - 1);
+		for (; i + 4 <= len; i += 4)
+		{
+			__m256d const xs = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(x + i), org), inv);
+			__m128i j = _mm_sub_epi32(_mm256_cvttpd_epi32(xs), deg);
+			j = _mm_min_epi32(_mm_max_epi32(j, _mm_setzero_si128()), last);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(idx + i), j);
+			_mm256_storeu_pd(t + i, _mm256_sub_pd(xs, _mm256_cvtepi32_pd(_mm_add_epi32(j, deg))));
+		}
+#endif
+		for (; i < len; ++ i)
+		{
+			double const xs = (x[i] - origin) * inv_step;
+			int const j = clamp(static_cast<int>(xs) - n, 0, nintervals - 1);
+			idx[i] = j;
+			t[i] = xs - (j + n);
+		}
+	}
+
+	/*
+	 * x is sorted, j is the interval of the previous argument
+	 */
+	void locate_sorted(double const* x, int len, double const* breaks, int nintervals, int& j, int* idx, double* t)
+	{
+		for (int i = 0; i < len; ++ i)
+		{
+			while (j + 1 < nintervals && x[i] >= breaks[j + 1])
+				++ j;
+			idx[i] = j;
+			t[i] = x[i] - breaks[j];
+		}
+	}
+
+	/*
+	 * the last break not greater than x, or the first one; the number of
+	 * steps only depends on nintervals, so the lanes go together
+	 */
+	void locate(double const* x, int len, double const* breaks, int nintervals, int* idx, double* t)
+	{
+		int i = 0;
+#if defined(__AVX2__)
+		__m256i const lo_halves = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+		for (; i + 4 <= len; i += 4)
+		{
+			__m256d const xv = _mm256_loadu_pd(x + i);
+			__m128i base = _mm_setzero_si128();
+			for (int size = nintervals; size > 1; )
+			{
+				int const half = size / 2;
+				__m128i const probe = _mm_add_epi32(base, _mm_set1_epi32(half));
+				__m256d const le = _mm256_cmp_pd(_mm256_i32gather_pd(breaks, probe, 8), xv, _CMP_LE_OQ);
+				__m128i const le32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(le), lo_halves));
+				base = _mm_blendv_epi8(base, probe, le32);
+				size -= half;
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(idx + i), base);
+			_mm256_storeu_pd(t + i, _mm256_sub_pd(xv, _mm256_i32gather_pd(breaks, base, 8)));
+		}
+#endif
+		for (; i < len; ++ i)
+		{
+			int base = 0;
+			for (int size = nintervals; size > 1; )
+			{
+				int const half = size / 2;
+				base = breaks[base + half] <= x[i] ? base + half : base;
+				size -= half;
+			}
+			idx[i] = base;
+			t[i] = x[i] - breaks[base];
+		}
+	}
+
+	/*
+	 * y[i] = scale * d^r/dt^r of the polynomial idx[i] at t[i]
+	 */
+	template <int n, int r>
+	void horner(double const* pcoefs, int const* idx, double const* t, double* y, int len, double scale)
+	{
+		if (r > n)
+		{
+			fill(y, y + len, 0.0);
+			return;
+		}
+
+		int i = 0;
+#if defined(__AVX2__)
+		__m256d const sc = _mm256_set1_pd(scale);
+		for (; i + 4 <= len; i += 4)
+		{
+			__m128i const base = _mm_mullo_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(idx + i)), _mm_set1_epi32(n + 1));
+			__m256d const tv = _mm256_loadu_pd(t + i);
+			__m256d yv = _mm256_mul_pd(_mm256_i32gather_pd(pcoefs + n, base, 8), _mm256_set1_pd(fact(n) / fact(n - r)));
+			for (int k = n - 1; k >= r; -- k)
+			{
+				__m256d const ck = _mm256_mul_pd(_mm256_i32gather_pd(pcoefs + k, base, 8), _mm256_set1_pd(fact(k) / fact(k - r)));
+				yv = _mm256_add_pd(_mm256_mul_pd(yv, tv), ck);
+			}
+			_mm256_storeu_pd(y + i, _mm256_mul_pd(yv, sc));
+		}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+		for (; i + 2 <= len; i += 2)
+		{
+			double const* c0 = pcoefs + idx[i] * (n + 1);
+			double const* c1 = pcoefs + idx[i + 1] * (n + 1);
+			float64x2_t const tv = vld1q_f64(t + i);
+			float64x2_t yv = vmulq_n_f64(vcombine_f64(vld1_f64(c0 + n), vld1_f64(c1 + n)), fact(n) / fact(n - r));
+			for (int k = n - 1; k >= r; -- k)
+			{
+				float64x2_t const ck = vmulq_n_f64(vcombine_f64(vld1_f64(c0 + k), vld1_f64(c1 + k)), fact(k) / fact(k - r));
+				yv = vfmaq_f64(ck, yv, tv);
+			}
+			vst1q_f64(y + i, vmulq_n_f64(yv, scale));
+		}
+#endif
+		for (; i < len; ++ i)
+		{
+			double const* c = pcoefs + idx[i] * (n + 1);
+			double v = c[n] * (fact(n) / fact(n - r));
+			for (int k = n - 1; k >= r; -- k)
+				v = v * t[i] + c[k] * (fact(k) / fact(k - r));
+			y[i] = v * scale;
+		}
+	}
+}
+
+
+/*
+ * power_pieces behind the basic_spline interface
+ */
+template <int n /* degree of the spline */, bool uniform>
+class power_spline : 
+	public basic_spline,
+	private power_pieces<n, uniform>
+{
+private:
+	typedef power_pieces<n, uniform> pieces;
+
+	template <int r>
+	void eval_batch(double const* x, double* y, size_t len) const
+	{
+		int idx[batch::chunk];
+		double t[batch::chunk];
+
+		bool const sorted = !uniform && is_sorted(x, x + len);
+		int j = 0;
+		if (sorted && len > 0)
+			j = clamp(int(upper_bound(this->breaks.begin(), this->breaks.end(), x[0]) - this->breaks.begin()) - 1, 0, this->nintervals - 1);
+
+		for (size_t i0 = 0; i0 < len; i0 += batch::chunk)
+		{
+			int const m = int(min<size_t>(batch::chunk, len - i0));
+			if (uniform)
+				batch::locate_uniform<n>(x + i0, m, this->origin, this->inv_step, this->nintervals, idx, t);
+			else if (sorted)
+				batch::locate_sorted(x + i0, m, this->breaks.data(), this->nintervals, j, idx, t);
+			else
+				batch::locate(x + i0, m, this->breaks.data(), this->nintervals, idx, t);
+
+			batch::horner<n, r>(this->pcoefs.data(), idx, t, y + i0, m, this->scale[r]);
+		}
+	}
+
+public:
+	power_spline(double origin, double step, vector<double> const& breaks, vector<double> const& pcoefs) :
+		pieces(origin, step, breaks, pcoefs)
+	{
+	}
+
+	virtual double val(double x, int der=0) const
+	{
+		switch (der)
+		{
+		case 0: return pieces::template eval<0>(x);
+		case 1: return pieces::template eval<1>(x);
+		case 2: return pieces::template eval<2>(x);
+		case 3: return pieces::template eval<3>(x);
+		default: throw_runtime_error("can't evaluare derivative");
+		}
+	}
+
+	virtual double der(double x) const
+	{
+		return pieces::template eval<1>(x);
+	}
+
+	virtual double der2(double x) const
+	{
+		return pieces::template eval<2>(x);
+	}
+
+	virtual double der3(double x) const
+	{
+		return pieces::template eval<3>(x);
+	}
+
+	virtual void eval_all(double x, double* out, int maxder) const
+	{
+		switch (maxder)
+		{
+		case 0: pieces::template eval_all<0>(x, out); break;
+		case 1: pieces::template eval_all<1>(x, out); break;
+		case 2: pieces::template eval_all<2>(x, out); break;
+		case 3: pieces::template eval_all<3>(x, out); break;
+		default: throw_runtime_error("can't evaluare derivative");
+		}
+	}
+
+	virtual void eval(double const* x, double* y, size_t len, int der) const
+	{
+		switch (der)
+		{
+		case 0: eval_batch<0>(x, y, len); break;
+		case 1: eval_batch<1>(x, y, len); break;
+		case 2: eval_batch<2>(x, y, len); break;
+		case 3: eval_batch<3>(x, y, len); break;
+		default: throw_runtime_error("can't evaluare derivative");
+		}
+	}
 };
 
+template <int n>
+basic_spline* make_power_spline(uniform_spline<n> const& s)
+{
+	double origin, step;
+	vector<double> pcoefs;
+	s.power_basis(origin, step, pcoefs);
+	return new power_spline<n, true>(origin, step, vector<double>(), pcoefs);
+}
+
+template <int n>
+basic_spline* make_power_spline(non_uniform_spline<n> const& s)
+{
+	vector<double> breaks, pcoefs;
+	s.power_basis(breaks, pcoefs);
+	return new power_spline<n, false>(0.0, 1.0, breaks, pcoefs);
+}
+
+template <typename S>
+basic_spline* make_spline(S* s, bool power)
+{
+	if (!power)
+		return s;
+
+	unique_ptr<S> bspline(s);
+	return make_power_spline(*bspline);
+}
+
 
 /*
  * spline wrapper
@@ -407,12 +856,85 @@ bool is_uniform(vector<double> const& v, double eps)
 	return true;
 }
 
-spline::spline(
+/*
+ * the knots of a non-uniform spline: the first one is repeated when the
+ * coefficients outnumber them
+ */
+vector<double> full_knots(unsigned int degree, vector<double> const& knots, size_t ncoefs)
+{
+	vector<double> knots1;
+
+	if (knots.size() + degree - 1 == ncoefs)
+	{
+		knots1.resize(ncoefs + 1);
+		fill(knots1.begin(), knots1.begin() + degree, knots[0]);
+		copy(knots.begin(), knots.end(), knots1.begin() + degree);
+	}
+	else if (knots.size() == ncoefs)
+	{
+		knots1 = knots;
+	}
+
+	return knots1;
+}
+
+template <int n>
+void power_basis(
+	vector<double> const& knots, 
+	vector<double> const& coefs, 
+	bool uniform, 
+	double& origin, 
+	double& step, 
+	vector<double>& breaks, 
+	vector<double>& pcoefs
+)
+{
+	origin = 0.0;
+	step = 1.0;
+	breaks.clear();
+	pcoefs.clear();
+
+	if (uniform)
+	{
+		uniform_spline<n> s(knots.front(), knots.back(), coefs);
+		s.power_basis(origin, step, pcoefs);
+	}
+	else
+	{
+		non_uniform_spline<n> s(full_knots(n, knots, coefs.size()), coefs);
+		s.power_basis(breaks, pcoefs);
+	}
+}
+
+void spline_power_basis(
 	unsigned int degree, 
 	vector<double> const& knots, 
 	vector<double> const& coefs, 
-	std::string const& extrap
+	bool uniform, 
+	double& origin, 
+	double& step, 
+	vector<double>& breaks, 
+	vector<double>& pcoefs
 )
+{
+	if (knots.size() <= degree * 2)
+		throw_runtime_error("parameter knots is invalid");
+
+	if (is_uniform(knots, 1e-10) != uniform)
+		throw_runtime_error("spline knots are ", uniform ? "not uniform" : "uniform");
+
+	switch (degree)
+	{
+	case 1: power_basis<1>(knots, coefs, uniform, origin, step, breaks, pcoefs); break;
+	case 2: power_basis<2>(knots, coefs, uniform, origin, step, breaks, pcoefs); break;
+	case 3: power_basis<3>(knots, coefs, uniform, origin, step, breaks, pcoefs); break;
+	case 4: power_basis<4>(knots, coefs, uniform, origin, step, breaks, pcoefs); break;
+	case 5: power_basis<5>(knots, coefs, uniform, origin, step, breaks, pcoefs); break;
+	default: throw_runtime_error("unsupported degree of spline: ", degree);
+	}
+}
+
+spline_domain::spline_domain(vector<double> const& knots, std::string const& extrap)
 {
 	if (extrap == "none")
 		extr = extrapolation::none;
@@ -423,12 +945,80 @@ spline::spline(
 	else
 		throw_runtime_error("parameter extrap is invalid");
 
-	if (knots.size() <= degree * 2)
+	if (knots.empty())
 		throw_runtime_error("parameter knots is invalid");
 
 	minval = min_value(knots);
 	maxval = max_value(knots);
 	period = maxval - minval;
+}
+
+inline bool spline_domain::try_fix_arg(double& x) const noexcept
+{
+	if (!is_finite(x))
+		return false;
+
+	switch (extr)
+	{
+	case extrapolation::none: return x >= minval && x <= maxval;
+	case extrapolation::periodic: x -= period * floor((x - minval) / period); return true;
+	case extrapolation::end_value: x = clamp(x, minval, maxval); return true;
+	default: return false;
+	}
+}
+
+inline double spline_domain::fix_arg(double x) const
+{
+	if (!try_fix_arg(x))
+		throw runtime_error("spline: the value is out of range");
+	return x;
+}
+
+void spline_domain::fix_args(double const* x, double* y, size_t len) const
+{
+	// a NaN passes the range checks and would reach the int conversions of
+	// the interval search
+	for (size_t i = 0; i < len; ++ i)
+	{
+		if (!is_finite(x[i])) throw runtime_error("spline: the value is out of range");
+	}
+
+	switch (extr)
+	{
+	case extrapolation::none:
+		for (size_t i = 0; i < len; ++ i)
+		{
+			if (x[i] < minval || x[i] > maxval) throw runtime_error("spline: the value is out of range");
+		}
+		if (y != x)
+			copy(x, x + len, y);
+		break;
+	case extrapolation::periodic:
+		for (size_t i = 0; i < len; ++ i)
+			y[i] = x[i] - period * floor((x[i] - minval) / period);
+		break;
+	case extrapolation::end_value:
+		for (size_t i = 0; i < len; ++ i)
+			y[i] = clamp(x[i], minval, maxval);
+		break;
+	default: throw_runtime_error("unknown extrapolation method");
+	}
+}
+
+spline::spline(
+	unsigned int degree, 
+	vector<double> const& knots, 
+	vector<double> const& coefs, 
+	std::string const& extrap,
+	std::string const& basis
+) : domain(knots, extrap)
+{
+	if (basis != "bspline" && basis != "power")
+		throw_runtime_error("parameter basis is invalid");
+	bool const power = basis == "power";
+
+	if (knots.size() <= degree * 2)
+		throw_runtime_error("parameter knots is invalid");
 
 	if (is_uniform(knots, 1e-10))
 	{
@@ -437,74 +1027,181 @@ spline::spline(
 
 		switch (degree)
 		{
-		case 1: s.reset(new uniform_spline<1>(fisrst, last, coefs)); break;
-		case 2: s.reset(new uniform_spline<2>(fisrst, last, coefs)); break;
-		case 3: s.reset(new uniform_spline<3>(fisrst, last, coefs)); break;
-		case 4: s.reset(new uniform_spline<4>(fisrst, last, coefs)); break;
-		case 5: s.reset(new uniform_spline<5>(fisrst, last, coefs)); break;
+		case 1: s.reset(make_spline(new uniform_spline<1>(fisrst, last, coefs), power)); break;
+		case 2: s.reset(make_spline(new uniform_spline<2>(fisrst, last, coefs), power)); break;
+		case 3: s.reset(make_spline(new uniform_spline<3>(fisrst, last, coefs), power)); break;
+		case 4: s.reset(make_spline(new uniform_spline<4>(fisrst, last, coefs), power)); break;
+		case 5: s.reset(make_spline(new uniform_spline<5>(fisrst, last, coefs), power)); break;
 		default: throw_runtime_error("unsupported degree of spline: " + degree);
 		}
 	}
 	else
 	{
-		vector<double> knots1;
-
-		if (knots.size() + degree - 1 == coefs.size())
-		{
-			knots1.resize(coefs.size() + 1);
-			fill(knots1.begin(), knots1.begin() + degree, knots[0]);
-			copy(knots.begin(), knots.end(), knots1.begin() + degree);
-		}
-		else if (knots.size() == coefs.size())
-		{
-			knots1 = knots;
-		}
+		vector<double> const knots1 = full_knots(degree, knots, coefs.size());
 
 		switch (degree)
 		{
-		case 1: s.reset(new non_uniform_spline<1>(knots1, coefs)); break;
-		case 2: s.reset(new non_uniform_spline<2>(knots1, coefs)); break;
-		case 3: s.reset(new non_uniform_spline<3>(knots1, coefs)); break;
-		case 4: s.reset(new non_uniform_spline<4>(knots1, coefs)); break;
-		case 5: s.reset(new non_uniform_spline<5>(knots1, coefs)); break;
+		case 1: s.reset(make_spline(new non_uniform_spline<1>(knots1, coefs), power)); break;
+		case 2: s.reset(make_spline(new non_uniform_spline<2>(knots1, coefs), power)); break;
+		case 3: s.reset(make_spline(new non_uniform_spline<3>(knots1, coefs), power)); break;
+		case 4: s.reset(make_spline(new non_uniform_spline<4>(knots1, coefs), power)); break;
+		case 5: s.reset(make_spline(new non_uniform_spline<5>(knots1, coefs), power)); break;
 		default: throw_runtime_error("unsupported degree of spline: ", degree);
 		}
 	}
 }
 
-inline double spline::fix_arg(double x) const
-{
-	switch (extr)
-	{
-	case extrapolation::none:
-		if (x < minval || x > maxval) throw runtime_error("spline: the value is out of range");
-		return x;
-	case extrapolation::periodic: return x - period * floor((x - minval) / period);
-	case extrapolation::end_value: return clamp(x, minval, maxval);
-	default: throw_runtime_error("unknown extrapolation method");
-	}
-}
-
 double spline::val(double x, int der) const
 {
-	x = fix_arg(x);
+	x = domain.fix_arg(x);
 	return s->val(x, der);
 }
 
 double spline::der(double x) const
 {
-	x = fix_arg(x);
+	x = domain.fix_arg(x);
 	return s->der(x);
 }
 
 double spline::der2(double x) const
 {
-	x = fix_arg(x);
+	x = domain.fix_arg(x);
 	return s->der2(x);
 }
 
 double spline::der3(double x) const
 {
-	x = fix_arg(x);
+	x = domain.fix_arg(x);
 	return s->der3(x);
 }
+
+void spline::eval_all(double x, double* out, int maxder) const
+{
+	x = domain.fix_arg(x);
+	s->eval_all(x, out, maxder);
+}
+
+void spline::eval(double const* x, double* y, size_t len, int der) const
+{
+	domain.fix_args(x, y, len);
+	s->eval(y, y, len, der);
+}
+
+
+/*
+ * spline bundle
+ */
+spline_bundle::spline_bundle(
+	unsigned int degree, 
+	vector<double> const& knots, 
+	vector<vector<double>> const& coefs, 
+	std::string const& extrap
+) : domain(knots, extrap), degree(degree), nchannels(int(coefs.size()))
+{
+	if (coefs.empty())
+		throw_runtime_error("parameter coefs is invalid");
+
+	for (auto const& c : coefs)
+	{
+		if (c.size() != coefs[0].size())
+			throw_runtime_error("channels of spline bundle differ in size");
+	}
+
+	uniform = is_uniform(knots, 1e-10);
+	double step = 1.0;
+	vector<vector<double>> channels(nchannels);
+
+	for (int m = 0; m < nchannels; ++ m)
+		spline_power_basis(degree, knots, coefs[m], uniform, origin, step, breaks, channels[m]);
+
+	int const rows = int(channels[0].size());
+	nintervals = rows / (degree + 1);
+	if (nintervals == 0)
+		throw_runtime_error("spline has no intervals");
+
+	pcoefs.resize(rows * nchannels);
+	for (int i = 0; i < rows; ++ i)
+		for (int m = 0; m < nchannels; ++ m)
+			pcoefs[i * nchannels + m] = channels[m][i];
+
+	if (uniform)
+	{
+		inv_step = 1.0 / step;
+		scale[0] = 1.0;
+		for (int r = 1; r < 4; ++ r)
+			scale[r] = scale[r - 1] * inv_step;
+	}
+	else
+	{
+		origin = 0.0;
+		inv_step = 0.0;
+		fill(scale, scale + 4, 1.0);
+	}
+}
+
+inline double const* spline_bundle::get_interval(double x, double& t) const
+{
+	int i;
+
+	if (uniform)
+	{
+		// clamped before the conversion, which overflows for huge periodic arguments
+		double const xs = (x - origin) * inv_step;
+		i = clamp(static_cast<int>(clamp(xs, 0.0, double(degree + nintervals))) - degree, 0, nintervals - 1);
+		t = xs - (i + degree);
+	}
+	else
+	{
+		i = clamp(int(upper_bound(breaks.begin(), breaks.end(), x) - breaks.begin()) - 1, 0, nintervals - 1);
+		t = x - breaks[i];
+	}
+
+	return &pcoefs[i * (degree + 1) * nchannels];
+}
+
+/*
+ * the weights of the powers t^k, k = der..degree, are shared by the
+ * channels; the channel loop runs over contiguous coefficients
+ */
+inline void spline_bundle::eval_der(double const* c, double t, int der, double* out) const
+{
+	double w[6];
+	double tk = scale[der];
+	for (int k = der; k <= degree; ++ k)
+	{
+		w[k] = tk * (fact(k) / fact(k - der));
+		tk *= t;
+	}
+
+	for (int m = 0; m < nchannels; ++ m)
+		out[m] = 0.0;
+
+	for (int k = der; k <= degree; ++ k)
+	{
+		double const* ck = c + k * nchannels;
+		for (int m = 0; m < nchannels; ++ m)
+			out[m] += w[k] * ck[m];
+	}
+}
+
+void spline_bundle::eval(double x, double* out, int der) const
+{
+	if (der < 0 || der > 3)
+		throw_runtime_error("can't evaluare derivative");
+
+	double t;
+	double const* c = get_interval(domain.fix_arg(x), t);
+	eval_der(c, t, der, out);
+}
+
+bool spline_bundle::eval_all(double x, double* out, int maxder) const noexcept
+{
+	if (maxder < 0 || maxder > 3 || !domain.try_fix_arg(x))
+		return false;
+
+	double t;
+	double const* c = get_interval(x, t);
+	for (int r = 0; r <= maxder; ++ r)
+		eval_der(c, t, r, out + r * nchannels);
+	return true;
+}
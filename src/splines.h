@@ -1,18 +1,29 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <string>
 
 
 class basic_spline
 {
 public:
+	virtual ~basic_spline() {}
 	virtual double val(double x, int der=0) const = 0;
 	virtual double der(double x) const = 0;
 	virtual double der2(double x) const = 0;
 	virtual double der3(double x) const = 0;
+
+	// out[0..maxder] are the value and the derivatives up to maxder <= 3
+	virtual void eval_all(double x, double* out, int maxder) const = 0;
+
+	// y[i] is the derivative der at x[i]; y may be x
+	virtual void eval(double const* x, double* y, size_t len, int der) const;
 };
 
-class spline
+/*
+ * the range of the knots and how arguments outside of it are mapped
+ */
+class spline_domain
 {
 private:
 	enum extrapolation
@@ -22,26 +33,119 @@ private:
 		end_value
 	};
 
-	std::unique_ptr<basic_spline> 	s;
 	extrapolation  					extr;
 	double  						minval, maxval, period;
 
+public:
+	spline_domain(std::vector<double> const& knots, std::string const& extrapolation);
+
+	// throws if x is out of range or not finite
 	double fix_arg(double x) const;
 
+	// as fix_arg(), returns false instead of throwing
+	bool try_fix_arg(double& x) const noexcept;
+
+	// y[i] = fix_arg(x[i]); y may be x
+	void fix_args(double const* x, double* y, size_t len) const;
+};
+
+/*
+ * the power basis form of a B-spline, per interval degree + 1 Taylor
+ * coefficients at its left end; uniform intervals start at
+ * origin + (degree + i) * step and are in the argument scaled by step,
+ * non-uniform ones start at breaks[i]; throws if the knots are not of the
+ * uniform kind requested
+ */
+void spline_power_basis(
+	unsigned int degree, 
+	std::vector<double> const& knots, 
+	std::vector<double> const& coefs,
+	bool uniform,
+	double& origin,
+	double& step,
+	std::vector<double>& breaks,
+	std::vector<double>& pcoefs
+);
+
+class spline
+{
+private:
+	std::unique_ptr<basic_spline> 	s;
+	spline_domain 					domain;
+
 public:
 	spline(
 		unsigned int degree, 
 		std::vector<double> const& knots, 
 		std::vector<double> const& coefs,
-		std::string const& extrapolation = "none" // periodic, none, end-value
+		std::string const& extrapolation = "none", // periodic, none, end-value
+		std::string const& basis = "bspline" // bspline, power
 	);
 	double val(double x, int der=0) const;
 	double der(double x) const;
 	double der2(double x) const;
 	double der3(double x) const;
 
+	/*
+	 * the value and the derivatives up to maxder <= 3 into out[0..maxder],
+	 * with a single search for the interval of x
+	 */
+	void eval_all(double x, double* out, int maxder) const;
+
+	/*
+	 * y[i] is the derivative der <= 3 at x[i], i < len; y may be x. Faster
+	 * than a loop over val() with the power basis, and when x is sorted
+	 */
+	void eval(double const* x, double* y, size_t len, int der=0) const;
+
 	inline double operator () (double x, int der=0) const
 	{
 		return val(x, der);
 	}
 };
+
+/*
+ * splines of the same degree on the same knots
+ *
+ * Evaluates all channels at once: the interval of the argument is found
+ * once and the weights of its power basis are shared by the channels,
+ * whose coefficients are stored interleaved. Values match spline with the
+ * power basis.
+ */
+class spline_bundle
+{
+private:
+	spline_domain 		domain;
+	int 				degree, nchannels, nintervals;
+	bool 				uniform;
+	double 				origin, inv_step;	// of uniform intervals
+	double 				scale[4];			// inv_step^r
+	std::vector<double> breaks;				// left ends of non-uniform intervals
+	std::vector<double> pcoefs;				// per interval degree + 1 rows of nchannels
+
+	double const* get_interval(double x, double& t) const;
+	void eval_der(double const* c, double t, int der, double* out) const;
+
+public:
+	spline_bundle(
+		unsigned int degree, 
+		std::vector<double> const& knots, 
+		std::vector<std::vector<double>> const& coefs, // per channel
+		std::string const& extrapolation = "none" // periodic, none, end-value
+	);
+
+	inline int channels() const
+	{
+		return nchannels;
+	}
+
+	// out[m] is the derivative der <= 3 of the channel m
+	void eval(double x, double* out, int der=0) const;
+
+	/*
+	 * out[r * channels() + m] is the derivative r of the channel m, for
+	 * r = 0..maxder, maxder <= 3; never throws, returns false leaving out
+	 * as is when x is out of range or NaN, like static_spline
+	 */
+	bool eval_all(double x, double* out, int maxder) const noexcept;
+};
@@ -0,0 +1,227 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cppmisc/throws.h>
+#include "math_helpers.h"
+#include "splines.h"
+
+
+namespace spline_detail
+{
+	/*
+	 * k!
+	 */
+	constexpr int fact(int k)
+	{
+		return k > 0 ? k * fact(k-1) : 1;
+	}
+}
+
+/*
+ * piecewise polynomial in the power basis
+ *
+ * Each interval keeps the Taylor coefficients at its left end, so the
+ * value and the derivatives are evaluated by the Horner scheme without
+ * divisions. Uniform intervals l = n.. are found the way uniform_spline
+ * does and their polynomials are in the scaled argument. Arguments outside
+ * the intervals are evaluated by the nearest one.
+ */
+template <int n /* degree of the spline */, bool uniform>
+class power_pieces
+{
+protected:
+	// the batch kernels of splines.cpp read them
+	double 	origin, inv_step;	// of uniform intervals
+	double 	scale[4];			// inv_step^r
+	std::vector<double> breaks;	// left ends of non-uniform intervals
+	std::vector<double> pcoefs;	// n + 1 per interval, lowest power first
+	int 	nintervals;
+
+	/*
+	 * d^r/dt^r of the polynomial c at t
+	 */
+	template <int r>
+	static inline double horner(double const* c, double t)
+	{
+		using spline_detail::fact;
+
+		if (r > n)
+			return 0.0;
+
+		double y = c[n] * (fact(n) / fact(n - r));
+		for (int k = n - 1; k >= r; -- k)
+			y = y * t + c[k] * (fact(k) / fact(k - r));
+		return y;
+	}
+
+	/*
+	 * coefficients of the interval of x and the argument of its polynomial
+	 */
+	inline double const* get_interval(double x, double& t) const
+	{
+		if (uniform)
+		{
+			// clamped before the conversion, which overflows for huge periodic arguments
+			double const xs = (x - origin) * inv_step;
+			int const i = clamp(static_cast<int>(clamp(xs, 0.0, double(n + nintervals))) - n, 0, nintervals - 1);
+			t = xs - (i + n);
+			return &pcoefs[i * (n + 1)];
+		}
+
+		int const i = clamp(int(std::upper_bound(breaks.begin(), breaks.end(), x) - breaks.begin()) - 1, 0, nintervals - 1);
+		t = x - breaks[i];
+		return &pcoefs[i * (n + 1)];
+	}
+
+public:
+	// of spline_power_basis()
+	power_pieces(double origin, double step, std::vector<double> const& breaks, std::vector<double> const& pcoefs) :
+		origin(uniform ? origin : 0.0), inv_step(uniform ? 1.0 / step : 0.0), breaks(breaks), pcoefs(pcoefs)
+	{
+		nintervals = int(pcoefs.size()) / (n + 1);
+		if (nintervals == 0)
+			throw_runtime_error("spline has no intervals");
+
+		scale[0] = 1.0;
+		for (int r = 1; r < 4; ++ r)
+			scale[r] = uniform ? scale[r - 1] * inv_step : 1.0;
+	}
+
+	template <int r>
+	inline double eval(double x) const
+	{
+		double t;
+		double const* c = get_interval(x, t);
+		return horner<r>(c, t) * scale[r];
+	}
+
+	// out[0..maxder] with one search, maxder <= 3
+	template <int maxder>
+	inline void eval_all(double x, double* out) const
+	{
+		static_assert(maxder >= 0 && maxder <= 3, "can't evaluare derivative");
+
+		double t;
+		double const* c = get_interval(x, t);
+		out[0] = horner<0>(c, t);
+		if (maxder >= 1)
+			out[1] = horner<1>(c, t) * scale[1];
+		if (maxder >= 2)
+			out[2] = horner<2>(c, t) * scale[2];
+		if (maxder >= 3)
+			out[3] = horner<3>(c, t) * scale[3];
+	}
+};
+
+/*
+ * policies for arguments outside the knots, the same as the extrapolation
+ * names of spline; fix() maps a finite x into the range or returns false
+ */
+namespace spline_extrapolation
+{
+	struct none
+	{
+		static inline bool fix(double& x, double minval, double maxval, double)
+		{
+			return x >= minval && x <= maxval;
+		}
+	};
+
+	struct periodic
+	{
+		static inline bool fix(double& x, double minval, double, double period)
+		{
+			x -= period * floor((x - minval) / period);
+			return true;
+		}
+	};
+
+	struct end_value
+	{
+		static inline bool fix(double& x, double minval, double maxval, double)
+		{
+			x = clamp(x, minval, maxval);
+			return true;
+		}
+	};
+}
+
+/*
+ * spline with the degree, the knot kind and the extrapolation fixed at
+ * compile time
+ *
+ * The counterpart of spline with the power basis for the hot paths: no
+ * virtual calls and no switches, so an evaluation inlines completely.
+ * eval() and eval_all() never throw; they return false, leaving the output
+ * as is, when the argument is out of range or NaN. The constructor throws
+ * if the knots are not of the given kind.
+ */
+template <
+	int n /* degree of the spline */,
+	bool uniform,
+	typename Extrapolation = spline_extrapolation::none
+>
+class static_spline
+{
+private:
+	double 					minval, maxval, period;
+	power_pieces<n, uniform> pieces;
+
+	static power_pieces<n, uniform> make_pieces(std::vector<double> const& knots, std::vector<double> const& coefs)
+	{
+		double origin, step;
+		std::vector<double> breaks, pcoefs;
+		spline_power_basis(n, knots, coefs, uniform, origin, step, breaks, pcoefs);
+		return power_pieces<n, uniform>(origin, step, breaks, pcoefs);
+	}
+
+public:
+	static_spline(std::vector<double> const& knots, std::vector<double> const& coefs) :
+		pieces(make_pieces(knots, coefs))
+	{
+		minval = *std::min_element(knots.begin(), knots.end());
+		maxval = *std::max_element(knots.begin(), knots.end());
+		period = maxval - minval;
+	}
+
+	// y is the derivative der <= 3 at x
+	template <int der = 0>
+	inline bool eval(double x, double& y) const noexcept
+	{
+		static_assert(der >= 0 && der <= 3, "can't evaluare derivative");
+
+		// NaN and inf by the bits, -Ofast folds std::isnan away
+		if (!is_finite(x) || !Extrapolation::fix(x, minval, maxval, period))
+			return false;
+
+		y = pieces.template eval<der>(x);
+		return true;
+	}
+
+	// out[0..maxder] are the value and the derivatives, maxder <= 3
+	template <int maxder>
+	inline bool eval_all(double x, double* out) const noexcept
+	{
+		if (!is_finite(x) || !Extrapolation::fix(x, minval, maxval, period))
+			return false;
+
+		pieces.template eval_all<maxder>(x, out);
+		return true;
+	}
+
+	// as eval(), throws on a wrong argument
+	template <int der = 0>
+	inline double val(double x) const
+	{
+		double y;
+		if (!eval<der>(x, y))
+			throw std::runtime_error("spline: the value is out of range");
+		return y;
+	}
+
+	inline double operator () (double x) const
+	{
+		return val<0>(x);
+	}
+};
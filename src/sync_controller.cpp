@@ -5,6 +5,7 @@
 #include "serializer.h"
 
 using namespace std;
+using namespace ser::literals;
 
 
 class ButterflySrv
@@ -30,11 +31,11 @@ public:
     {
         char buf[1024];
         int len = ser::pack(buf, sizeof(buf),
-            "ts", ts,
-            "theta", theta,
-            "phi", phi,
-            "dtheta", dtheta,
-            "dphi", dphi
+            "ts"_h, ts,
+            "theta"_h, theta,
+            "phi"_h, phi,
+            "dtheta"_h, dtheta,
+            "dphi"_h, dphi
         );
         if (len <= 0)
         {
@@ -93,7 +94,7 @@ public:
         else if (status > 0)
         {
             info_msg("obtained pack: ", pack.nentries());
-            status = pack.get("ts", m_ts, "theta", m_theta, "phi", m_phi, "dtheta", m_dtheta, "dphi", m_dphi);
+            status = pack.get("ts"_h, m_ts, "theta"_h, m_theta, "phi"_h, m_phi, "dtheta"_h, m_dtheta, "dphi"_h, m_dphi);
             if (status <= 0)
             {
                 err_msg("pack.get returned ", status);
@@ -0,0 +1,444 @@
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <cppmisc/throws.h>
+#include <cppmisc/traces.h>
+#include <cppmisc/timing.h>
+#include "uring_io.h"
+
+using namespace std;
+
+
+const int UringIo::recv_bufs;
+const int UringIo::recv_buf_size;
+const int UringIo::send_slots;
+const int UringIo::send_slot_size;
+
+namespace
+{
+    const int sq_entries = 8;
+    const int cq_entries = 64;
+    const uint16_t buf_group = 0;
+
+    enum : uint64_t { tag_recv = 1, tag_send = 16 };
+
+    inline int sys_io_uring_setup(unsigned entries, io_uring_params* p)
+    {
+        return int(syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    inline int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg, size_t argsz)
+    {
+        return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz));
+    }
+
+    inline int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args)
+    {
+        return int(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    inline unsigned load_acquire(unsigned const* p)
+    {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    inline void store_release(unsigned* p, unsigned v)
+    {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+}
+
+bool UringIo::supported()
+{
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = sys_io_uring_setup(1, &p);
+    if (fd < 0)
+        return false;
+    close(fd);
+    return true;
+}
+
+UringIo::UringIo(int sock) :
+    m_ring_fd(-1), m_sock(sock),
+    m_rings(MAP_FAILED), m_rings_size(0), m_sqes(nullptr), m_sqes_size(0), m_to_submit(0),
+    m_mem(MAP_FAILED), m_mem_size(0), m_buf_tail(0),
+    m_chunk_head(0), m_nchunks(0), m_chunk_pos(0),
+    m_recv_armed(false), m_closed(false), m_error(0),
+    m_sends(0), m_syscalls(0)
+{
+    memset(m_send_len, 0, sizeof(m_send_len));
+
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = cq_entries;
+    m_ring_fd = sys_io_uring_setup(sq_entries, &p);
+    if (m_ring_fd < 0)
+        throw_runtime_error("io_uring_setup failed: ", strerror(errno));
+
+    auto fail = [this](char const* what) {
+        int err = errno;
+        release();
+        throw_runtime_error(what, " failed: ", strerror(err));
+    };
+
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_EXT_ARG))
+    {
+        errno = ENOSYS;
+        fail("io_uring features check");
+    }
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    m_rings_size = std::max(sq_size, cq_size);
+    m_rings = mmap(nullptr, m_rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+    if (m_rings == MAP_FAILED)
+        fail("io_uring rings mmap");
+
+    m_sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        fail("io_uring sqes mmap");
+    m_sqes = reinterpret_cast<io_uring_sqe*>(sqes);
+
+    char* rings = reinterpret_cast<char*>(m_rings);
+    m_sq_head = reinterpret_cast<unsigned*>(rings + p.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned*>(rings + p.sq_off.tail);
+    m_sq_mask = *reinterpret_cast<unsigned*>(rings + p.sq_off.ring_mask);
+    m_sq_entries = p.sq_entries;
+    m_cq_head = reinterpret_cast<unsigned*>(rings + p.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned*>(rings + p.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned*>(rings + p.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(rings + p.cq_off.cqes);
+
+    // the sq array maps ring slots to sqes one to one
+    unsigned* sq_array = reinterpret_cast<unsigned*>(rings + p.sq_off.array);
+    for (unsigned i = 0; i < p.sq_entries; ++ i)
+        sq_array[i] = i;
+
+    // one page aligned block: buffer ring, receive buffers, send slots
+    size_t buf_ring_size = 4096;
+    m_mem_size = buf_ring_size + recv_bufs * recv_buf_size + send_slots * send_slot_size;
+    m_mem = mmap(nullptr, m_mem_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (m_mem == MAP_FAILED)
+        fail("io_uring buffers mmap");
+    m_bufs = reinterpret_cast<io_uring_buf*>(m_mem);
+    m_recv_mem = reinterpret_cast<char*>(m_mem) + buf_ring_size;
+    m_send_mem = m_recv_mem + recv_bufs * recv_buf_size;
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(m_bufs);
+    reg.ring_entries = recv_bufs;
+    reg.bgid = buf_group;
+    if (sys_io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        fail("io_uring provided buffers registration");
+
+    for (int i = 0; i < recv_bufs; ++ i)
+        recycle(uint16_t(i));
+
+    arm_recv();
+    if (enter(0, -1) < 0)
+        fail("io_uring_enter");
+}
+
+UringIo::~UringIo()
+{
+    release();
+}
+
+void UringIo::release()
+{
+    // closing the ring cancels the receive before the buffers go
+    if (m_ring_fd >= 0)
+        close(m_ring_fd);
+    m_ring_fd = -1;
+    if (m_sqes)
+        munmap(m_sqes, m_sqes_size);
+    m_sqes = nullptr;
+    if (m_rings != MAP_FAILED)
+        munmap(m_rings, m_rings_size);
+    m_rings = MAP_FAILED;
+    if (m_mem != MAP_FAILED)
+        munmap(m_mem, m_mem_size);
+    m_mem = MAP_FAILED;
+}
+
+io_uring_sqe* UringIo::get_sqe()
+{
+    unsigned tail = *m_sq_tail;
+    if (tail - load_acquire(m_sq_head) == m_sq_entries)
+    {
+        enter(0, -1);
+        if (tail - load_acquire(m_sq_head) == m_sq_entries)
+            return nullptr;
+    }
+
+    io_uring_sqe* sqe = &m_sqes[tail & m_sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    store_release(m_sq_tail, tail + 1);
+    ++ m_to_submit;
+    return sqe;
+}
+
+/*
+ * submits the queued entries and, with min_complete, waits for that many
+ * completions at most timeout_usec (< 0 for no limit); returns -1 only on
+ * failures other than a timeout or a signal
+ */
+int UringIo::enter(unsigned min_complete, int64_t timeout_usec)
+{
+    if (m_to_submit == 0 && min_complete == 0)
+        return 0;
+
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    __kernel_timespec ts;
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    void* argp = nullptr;
+    size_t argsz = 0;
+    if (min_complete > 0 && timeout_usec >= 0)
+    {
+        ts.tv_sec = timeout_usec / 1000000;
+        ts.tv_nsec = (timeout_usec % 1000000) * 1000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argsz = sizeof(arg);
+    }
+
+    ++ m_syscalls;
+    int res = sys_io_uring_enter(m_ring_fd, m_to_submit, min_complete, flags, argp, argsz);
+    if (res >= 0)
+    {
+        m_to_submit -= std::min<unsigned>(res, m_to_submit);
+        return 0;
+    }
+
+    if (errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        return 0;
+    return -1;
+}
+
+void UringIo::arm_recv()
+{
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = m_sock;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = buf_group;
+    sqe->user_data = tag_recv;
+    m_recv_armed = true;
+}
+
+void UringIo::prep_send(int slot, bool link)
+{
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe)
+    {
+        m_error = EBUSY;
+        return;
+    }
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = m_sock;
+    sqe->addr = reinterpret_cast<uint64_t>(m_send_mem + slot * send_slot_size);
+    sqe->len = m_send_len[slot];
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    if (link)
+        sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = tag_send + slot;
+    ++ m_sends;
+}
+
+void UringIo::recycle(uint16_t bid)
+{
+    io_uring_buf* buf = &m_bufs[m_buf_tail & (recv_bufs - 1)];
+    buf->addr = reinterpret_cast<uint64_t>(m_recv_mem + bid * recv_buf_size);
+    buf->len = recv_buf_size;
+    buf->bid = bid;
+    ++ m_buf_tail;
+
+    // the ring tail overlays resv of the first entry; io_uring_buf_ring
+    // can't be used from C++, where older headers put its bufs 8 bytes off
+    __atomic_store_n(&m_bufs[0].resv, m_buf_tail, __ATOMIC_RELEASE);
+}
+
+// takes all posted completions; no syscall
+void UringIo::reap()
+{
+    unsigned head = *m_cq_head;
+    unsigned tail = load_acquire(m_cq_tail);
+
+    for (; head != tail; ++ head)
+    {
+        io_uring_cqe const& cqe = m_cqes[head & m_cq_mask];
+
+        if (cqe.user_data == tag_recv)
+        {
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                m_recv_armed = false;
+
+            if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER))
+            {
+                Chunk& c = m_chunks[(m_chunk_head + m_nchunks) % recv_bufs];
+                c.bid = uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                c.len = cqe.res;
+                ++ m_nchunks;
+            }
+            else if (cqe.res == 0)
+                m_closed = true;
+            else if (cqe.res != -ENOBUFS)
+                m_error = -cqe.res;
+            // with all buffers taken the receive stops; read() rearms it
+        }
+        else if (cqe.user_data >= tag_send && cqe.user_data < tag_send + send_slots)
+        {
+            // a failed send cancels the rest of its chain, which still
+            // completes
+            int slot = int(cqe.user_data - tag_send);
+            -- m_sends;
+            if (cqe.res < 0)
+                m_error = -cqe.res;
+            else if (cqe.res != m_send_len[slot])
+                m_error = EPIPE;
+        }
+    }
+
+    store_release(m_cq_head, head);
+}
+
+int UringIo::copy_out(char* buf, int len)
+{
+    int n = 0;
+    while (n < len && m_nchunks > 0)
+    {
+        Chunk const& c = m_chunks[m_chunk_head];
+        int k = std::min(len - n, c.len - m_chunk_pos);
+        memcpy(buf + n, m_recv_mem + c.bid * recv_buf_size + m_chunk_pos, k);
+        n += k;
+        m_chunk_pos += k;
+
+        if (m_chunk_pos == c.len)
+        {
+            recycle(c.bid);
+            m_chunk_head = (m_chunk_head + 1) % recv_bufs;
+            -- m_nchunks;
+            m_chunk_pos = 0;
+        }
+    }
+    return n;
+}
+
+int UringIo::read(char* buf, int len, bool blocking)
+{
+    while (true)
+    {
+        reap();
+        int n = copy_out(buf, len);
+        if (n > 0)
+            return n;
+
+        if (m_closed)
+        {
+            dbg_msg("connection closed");
+            return -1;
+        }
+        if (m_error)
+        {
+            dbg_msg("an error occurred: ", strerror(m_error));
+            return -1;
+        }
+
+        if (!m_recv_armed)
+            arm_recv();
+
+        if (!blocking)
+        {
+            if (enter(0, -1) < 0)
+                return -1;
+            return 0;
+        }
+
+        if (enter(1, -1) < 0)
+            return -1;
+    }
+}
+
+int UringIo::wait_for_data(int64_t usec)
+{
+    int64_t deadline = monotonic_nsec() / 1000 + usec;
+
+    while (true)
+    {
+        reap();
+        if (m_nchunks > 0 || m_closed || m_error)
+            return 1;
+
+        if (!m_recv_armed)
+            arm_recv();
+
+        // a send completion wakes us up as well
+        int64_t left = deadline - monotonic_nsec() / 1000;
+        if (left <= 0)
+            return 0;
+        if (enter(1, left) < 0)
+            return -1;
+    }
+}
+
+// waits for the chain in flight; sends on the same socket that overlap
+// could reorder or interleave the stream
+bool UringIo::wait_sends()
+{
+    while (m_sends > 0)
+    {
+        if (enter(1, -1) < 0)
+            return false;
+        reap();
+    }
+    return m_error == 0;
+}
+
+bool UringIo::write(char const* data, int len)
+{
+    reap();
+    if (m_error)
+    {
+        dbg_msg("send failed: ", strerror(m_error));
+        return false;
+    }
+
+    // longer data is sent from several slots linked in order, in as many
+    // chains as it takes
+    for (int sent = 0; sent < len; )
+    {
+        if (!wait_sends())
+            return false;
+
+        for (int slot = 0; slot < send_slots && sent < len; ++ slot)
+        {
+            int n = std::min(len - sent, send_slot_size);
+            memcpy(m_send_mem + slot * send_slot_size, data + sent, n);
+            m_send_len[slot] = n;
+            sent += n;
+            prep_send(slot, slot + 1 < send_slots && sent < len);
+        }
+    }
+
+    if (!m_recv_armed && !m_closed)
+        arm_recv();
+
+    return enter(0, -1) == 0 && m_error == 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+/*
+ * io_uring backend for a connected device socket
+ *
+ * A drop-in for the read/write/wait_for_data calls of Connection. One
+ * multishot receive stays armed on the socket and fills buffers registered
+ * with the ring. read() only copies out of completed buffers, so it makes
+ * no syscall while data is coming. write() copies into send slots and
+ * submits them as one linked chain together with anything else queued.
+ * That is a single io_uring_enter, and the call does not wait for the send
+ * to complete. Only one chain is in flight at a time, so the stream stays
+ * in order: a write() issued before the previous one completed first waits
+ * for it. A send that fails is reported by the next write().
+ *
+ * fd() is the ring descriptor. It becomes readable when completions are
+ * posted, so it can go to epoll in place of the socket. Stream sockets
+ * only: reads don't keep datagram boundaries.
+ *
+ * Single-threaded: read() and write() both reap completions and advance
+ * the queues, so all calls must come from one thread.
+ */
+class UringIo
+{
+public:
+    static const int recv_bufs = 16;        // power of two
+    static const int recv_buf_size = 4096;
+    static const int send_slots = 4;
+    static const int send_slot_size = 1024;
+
+private:
+    int             m_ring_fd;
+    int             m_sock;
+
+    // submission and completion queues, shared with the kernel
+    void*           m_rings;
+    size_t          m_rings_size;
+    io_uring_sqe*   m_sqes;
+    size_t          m_sqes_size;
+    unsigned*       m_sq_head;
+    unsigned*       m_sq_tail;
+    unsigned        m_sq_mask;
+    unsigned        m_sq_entries;
+    unsigned*       m_cq_head;
+    unsigned*       m_cq_tail;
+    unsigned        m_cq_mask;
+    io_uring_cqe*   m_cqes;
+    unsigned        m_to_submit;
+
+    // provided receive buffers, then the send slots
+    void*           m_mem;
+    size_t          m_mem_size;
+    io_uring_buf*   m_bufs;         // the provided buffer ring
+    char*           m_recv_mem;
+    char*           m_send_mem;
+    uint16_t        m_buf_tail;
+
+    // completed receives in order, the first one partially consumed
+    struct Chunk
+    {
+        uint16_t    bid;
+        int         len;
+    };
+    Chunk           m_chunks[recv_bufs];
+    int             m_chunk_head;
+    int             m_nchunks;
+    int             m_chunk_pos;
+
+    bool            m_recv_armed;
+    bool            m_closed;
+    int             m_error;
+
+    int             m_send_len[send_slots];
+    int             m_sends;        // slots in flight, all of one chain
+
+    uint64_t        m_syscalls;
+
+    UringIo(UringIo const&) = delete;
+    UringIo& operator=(UringIo const&) = delete;
+
+    void release();
+    io_uring_sqe* get_sqe();
+    int enter(unsigned min_complete, int64_t timeout_usec);
+    void arm_recv();
+    void prep_send(int slot, bool link);
+    void recycle(uint16_t bid);
+    void reap();
+    int copy_out(char* buf, int len);
+    bool wait_sends();
+
+public:
+    // the socket stays owned by the caller and must outlive the object
+    explicit UringIo(int sock);
+    ~UringIo();
+
+    // the kernel lets us create a ring, e.g. it isn't disabled by sysctl
+    static bool supported();
+
+    /*
+     * same as Connection::read
+     * -1 failed or closed
+     *  0 no data (non-blocking)
+     *  N number of bytes received
+     */
+    int read(char* buf, int len, bool blocking);
+
+    bool write(char const* data, int len);
+
+    /*
+     * -1 failed
+     *  0 timed out
+     *  1 data available or the connection was closed
+     */
+    int wait_for_data(int64_t usec);
+
+    inline int fd() const { return m_ring_fd; }
+
+    // io_uring_enter calls made so far
+    inline uint64_t syscalls() const { return m_syscalls; }
+};
+
+typedef std::shared_ptr<UringIo> UringIoPtr;
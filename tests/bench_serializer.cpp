@@ -0,0 +1,101 @@
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cppmisc/timing.h>
+#include <cppmisc/traces.h>
+#include "../src/serializer.h"
+#include "../src/cam_iface.h"
+
+
+/*
+ * Decoding throughput of camera packets: fetch_next into a Packet (copy
+ * plus std::map index), into a PacketView (in place) and into a PacketRef
+ * decoded by the schema of CameraMeasurement.
+ *
+ *   bench_serializer [packets]
+ */
+
+struct Source
+{
+    std::string data;
+    size_t pos = 0;
+
+    int read(char* p, int n)
+    {
+        int len = std::min<int>(n, int(data.size() - pos));
+        memcpy(p, data.data() + pos, len);
+        pos += len;
+        return len;
+    }
+};
+
+template <typename PacketT>
+double packets_per_sec(Source& src, int n)
+{
+    src.pos = 0;
+    auto reader = ser::make_pack_reader([&src](char* p, int len) { return src.read(p, len); });
+    PacketT pack;
+    int64_t ts;
+    double x, y;
+    bool good;
+    double sum = 0;
+
+    int64_t t0 = monotonic_nsec();
+    for (int i = 0; i < n; ++ i)
+    {
+        if (reader->fetch_next(pack) <= 0)
+            throw_runtime_error("unexpected end of stream");
+        pack.get("good", good, "x", x, "y", y, "ts", ts);
+        sum += x;
+    }
+    int64_t t = monotonic_nsec() - t0;
+
+    if (sum < 0)
+        printf("%f\n", sum);
+    return n * 1e+9 / t;
+}
+
+double messages_per_sec(Source& src, int n)
+{
+    src.pos = 0;
+    auto reader = ser::make_pack_reader([&src](char* p, int len) { return src.read(p, len); });
+    ser::MessageDecoder<CameraMeasurement> decoder;
+    ser::PacketRef ref;
+    CameraMeasurement m;
+    double sum = 0;
+
+    int64_t t0 = monotonic_nsec();
+    for (int i = 0; i < n; ++ i)
+    {
+        if (reader->fetch_next(ref) <= 0)
+            throw_runtime_error("unexpected end of stream");
+        decoder.decode(ref, m);
+        sum += m.x;
+    }
+    int64_t t = monotonic_nsec() - t0;
+
+    if (sum < 0)
+        printf("%f\n", sum);
+    return n * 1e+9 / t;
+}
+
+int main(int argc, char const* argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    Source src;
+    char buf[256];
+    for (int i = 0; i < n; ++ i)
+    {
+        int len = ser::pack(buf, sizeof(buf), "ts", int64_t(i), "good", true, "x", 0.1 * i, "y", -0.1 * i);
+        src.data.append(buf, len);
+    }
+
+    double packet = packets_per_sec<ser::Packet>(src, n);
+    double view = packets_per_sec<ser::PacketView>(src, n);
+    printf("Packet:     %10.0f packets/s\n", packet);
+    double schema = messages_per_sec(src, n);
+    printf("PacketView: %10.0f packets/s\n", view);
+    printf("schema:     %10.0f packets/s\n", schema);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cppmisc/timing.h>
+#include "../src/splines.h"
+
+
+/*
+ * Throughput of spline evaluation over arrays, as in offline work on
+ * logs: a loop over val() against spline::eval, for sorted and shuffled
+ * arguments, uniform and non-uniform knots, in millions of values per
+ * second.
+ *
+ *   bench_spline_batch [arguments]
+ */
+
+double mvals_loop(spline const& s, std::vector<double> const& x, std::vector<double>& y)
+{
+	int64_t t0 = monotonic_nsec();
+	for (size_t i = 0; i < x.size(); ++ i)
+		y[i] = s(x[i]);
+	int64_t t = monotonic_nsec() - t0;
+	return x.size() * 1e3 / t;
+}
+
+double mvals_batch(spline const& s, std::vector<double> const& x, std::vector<double>& y)
+{
+	int64_t t0 = monotonic_nsec();
+	s.eval(x.data(), y.data(), x.size());
+	int64_t t = monotonic_nsec() - t0;
+	return x.size() * 1e3 / t;
+}
+
+int main(int argc, char const* argv[])
+{
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	int const nknots = 1000;
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<double> step(0.5, 1.5);
+	std::uniform_real_distribution<double> coef(-1.0, 1.0);
+
+	printf("degree knots       basis  order        loop       batch  (Mvals/s)\n");
+	for (int degree : {3, 5})
+	{
+		for (bool uniform : {true, false})
+		{
+			std::vector<double> knots, coefs;
+			double x = 0.;
+			for (int i = 0; i < nknots; ++ i)
+			{
+				knots.push_back(x);
+				x += uniform ? 0.01 : 0.01 * step(gen);
+			}
+			for (int i = 0; i < nknots + degree - 1; ++ i)
+				coefs.push_back(coef(gen));
+
+			std::uniform_real_distribution<double> arg(knots.front(), knots.back());
+			std::vector<double> args(n), y(n);
+			for (double& a : args)
+				a = arg(gen);
+
+			for (char const* basis : {"bspline", "power"})
+			{
+				spline s(degree, knots, coefs, "periodic", basis);
+				for (bool sorted : {false, true})
+				{
+					if (sorted)
+						std::sort(args.begin(), args.end());
+					else
+						std::shuffle(args.begin(), args.end(), gen);
+
+					double loop = mvals_loop(s, args, y);
+					double batch = mvals_batch(s, args, y);
+					printf("%6d %-11s %-7s %-8s %9.1f %11.1f\n", degree, uniform ? "uniform" : "non-uniform",
+						basis, sorted ? "sorted" : "shuffled", loop, batch);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include <vector>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cppmisc/timing.h>
+#include "../src/splines.h"
+#include "../src/static_spline.h"
+
+
+/*
+ * Evaluation time of a spline by the B-spline recursion and in the power
+ * basis, for degrees 1..5 on non-uniform knots like those of the
+ * controller splines. A call evaluates the value and the first two
+ * derivatives (the last ones only up to the degree), either by separate
+ * calls or by a single eval_all, and by the eval_all of static_spline. The arguments sweep the knots slowly, as
+ * the controller phase does.
+ *
+ * Then the five splines of the controller feedback on shared knots are
+ * evaluated one by one and as a spline_bundle.
+ *
+ *   bench_splines [evaluations]
+ */
+
+double ns_per_call(spline const& s, int degree, std::vector<double> const& args)
+{
+	int const nder = std::min(degree, 2);
+	double sum = 0.;
+
+	int64_t t0 = monotonic_nsec();
+	for (double x : args)
+	{
+		for (int der = 0; der <= nder; ++ der)
+			sum += s(x, der);
+	}
+	int64_t t = monotonic_nsec() - t0;
+
+	if (sum == 1.2345)
+		printf("%f\n", sum);
+	return double(t) / args.size();
+}
+
+double ns_per_eval_all(spline const& s, int degree, std::vector<double> const& args)
+{
+	int const nder = std::min(degree, 2);
+	double out[3];
+	double sum = 0.;
+
+	int64_t t0 = monotonic_nsec();
+	for (double x : args)
+	{
+		s.eval_all(x, out, nder);
+		for (int der = 0; der <= nder; ++ der)
+			sum += out[der];
+	}
+	int64_t t = monotonic_nsec() - t0;
+
+	if (sum == 1.2345)
+		printf("%f\n", sum);
+	return double(t) / args.size();
+}
+
+template <int n>
+double ns_per_static_eval(std::vector<double> const& knots, std::vector<double> const& coefs, std::vector<double> const& args)
+{
+	int const nder = std::min(n, 2);
+	static_spline<n, false> s(knots, coefs);
+	double out[4];
+	double sum = 0.;
+
+	int64_t t0 = monotonic_nsec();
+	for (double x : args)
+	{
+		if (nder == 1)
+			s.template eval_all<1>(x, out);
+		else
+			s.template eval_all<2>(x, out);
+		for (int der = 0; der <= nder; ++ der)
+			sum += out[der];
+	}
+	int64_t t = monotonic_nsec() - t0;
+
+	if (sum == 1.2345)
+		printf("%f\n", sum);
+	return double(t) / args.size();
+}
+
+double ns_per_static_eval(int degree, std::vector<double> const& knots, std::vector<double> const& coefs, std::vector<double> const& args)
+{
+	switch (degree)
+	{
+	case 1: return ns_per_static_eval<1>(knots, coefs, args);
+	case 2: return ns_per_static_eval<2>(knots, coefs, args);
+	case 3: return ns_per_static_eval<3>(knots, coefs, args);
+	case 4: return ns_per_static_eval<4>(knots, coefs, args);
+	default: return ns_per_static_eval<5>(knots, coefs, args);
+	}
+}
+
+int main(int argc, char const* argv[])
+{
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	int const nknots = 1000;
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<double> step(0.5, 1.5);
+	std::uniform_real_distribution<double> coef(-1.0, 1.0);
+
+	printf("degree    bspline      power   bspline*     power*     static   (* eval_all)\n");
+	for (int degree = 1; degree <= 5; ++ degree)
+	{
+		std::vector<double> knots, coefs;
+		double x = 0.;
+		for (int i = 0; i < nknots; ++ i)
+		{
+			knots.push_back(x);
+			x += 0.01 * step(gen);
+		}
+		for (int i = 0; i < nknots + degree - 1; ++ i)
+			coefs.push_back(coef(gen));
+
+		double const xmin = knots.front();
+		double const xmax = knots[nknots - degree];
+		std::vector<double> args(n);
+		for (int i = 0; i < n; ++ i)
+			args[i] = xmin + (xmax - xmin) * (i % 10000) / 10000.;
+
+		spline bs(degree, knots, coefs, "none", "bspline");
+		spline pp(degree, knots, coefs, "none", "power");
+		double t_bs = ns_per_call(bs, degree, args);
+		double t_pp = ns_per_call(pp, degree, args);
+		double t_bs_all = ns_per_eval_all(bs, degree, args);
+		double t_pp_all = ns_per_eval_all(pp, degree, args);
+		double t_static = ns_per_static_eval(degree, knots, coefs, args);
+		printf("%6d %8.1fns %8.1fns %8.1fns %8.1fns %8.1fns\n", degree, t_bs, t_pp, t_bs_all, t_pp_all, t_static);
+	}
+
+	printf("\nchannels  separate     bundle\n");
+	{
+		int const nchannels = 5;
+		std::vector<double> knots;
+		double x = 0.;
+		for (int i = 0; i < nknots; ++ i)
+		{
+			knots.push_back(x);
+			x += 0.01 * step(gen);
+		}
+
+		std::vector<std::vector<double>> coefs(nchannels);
+		std::vector<std::unique_ptr<spline>> ss;
+		for (auto& c : coefs)
+		{
+			for (int i = 0; i < nknots + 2; ++ i)
+				c.push_back(coef(gen));
+			ss.emplace_back(new spline(3, knots, c, "periodic", "power"));
+		}
+		spline_bundle b(3, knots, coefs, "periodic");
+
+		std::vector<double> args(n);
+		for (int i = 0; i < n; ++ i)
+			args[i] = x * (i % 10000) / 10000.;
+
+		double sum = 0.;
+		int64_t t0 = monotonic_nsec();
+		for (double a : args)
+		{
+			for (auto const& s : ss)
+				sum += (*s)(a);
+		}
+		int64_t t_sep = monotonic_nsec() - t0;
+
+		double out[nchannels];
+		t0 = monotonic_nsec();
+		for (double a : args)
+		{
+			b.eval(a, out);
+			for (int m = 0; m < nchannels; ++ m)
+				sum += out[m];
+		}
+		int64_t t_bundle = monotonic_nsec() - t0;
+
+		if (sum == 1.2345)
+			printf("%f\n", sum);
+		printf("%8d %8.1fns %8.1fns\n", nchannels, double(t_sep) / n, double(t_bundle) / n);
+	}
+
+	return 0;
+}
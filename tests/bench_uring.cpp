@@ -0,0 +1,143 @@
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cppmisc/timing.h>
+#include <cppmisc/traces.h>
+#include <networking/tcp.h>
+#include "../src/uring_io.h"
+#include "../src/servo_protocol.h"
+
+
+/*
+ * Servo round trips over loopback with the socket calls of Connection and
+ * with UringIo. A tick sends a torque command, waits for the state and
+ * reads it, as the controller does; the stand-in server answers each
+ * command with a state packet.
+ *
+ *   bench_uring [ticks]
+ */
+
+struct SocketIo
+{
+    ConnectionPtr con;
+    uint64_t calls = 0;
+
+    bool write(char const* p, int n) { ++ calls; return con->write(p, n); }
+    int wait_for_data(int64_t usec) { ++ calls; return con->wait_for_data(usec); }
+    int read(char* p, int n, bool blocking) { ++ calls; return con->read(p, n, blocking); }
+    uint64_t syscalls() const { return calls; }
+};
+
+ConnectionPtr connect_to(int port)
+{
+    // the server may not listen yet
+    for (int attempt = 0; ; ++ attempt)
+    {
+        try
+        {
+            return Connection::connect("127.0.0.1", port);
+        }
+        catch (std::exception const&)
+        {
+            if (attempt == 100)
+                throw;
+            sleep_usec(10000);
+        }
+    }
+}
+
+void serve(TCPSrv& srv, int ticks)
+{
+    auto con = srv.wait_for_connection();
+    for (int i = 0; i < ticks; ++ i)
+    {
+        Servo::CmdPack cmd;
+        int n = 0;
+        while (n < (int)sizeof(cmd))
+        {
+            int status = con->read(reinterpret_cast<char*>(&cmd) + n, sizeof(cmd) - n, true);
+            if (status <= 0)
+                return;
+            n += status;
+        }
+
+        Servo::InfoPack info;
+        Servo::init_info_pack(i, 0., 0., info);
+        con->write(reinterpret_cast<char const*>(&info), sizeof(info));
+    }
+}
+
+template <typename Io>
+void run(char const* name, Io& io, int ticks)
+{
+    std::vector<int64_t> lat(ticks);
+    uint64_t calls0 = io.syscalls();
+
+    for (int i = 0; i < ticks; ++ i)
+    {
+        int64_t t0 = monotonic_nsec();
+
+        Servo::CmdPack cmd;
+        Servo::init_cmd_torque(i, 0.1, cmd);
+        if (!io.write(reinterpret_cast<char const*>(&cmd), sizeof(cmd)))
+            throw_runtime_error("send failed");
+
+        Servo::InfoPack info;
+        int n = 0;
+        while (n < (int)sizeof(info))
+        {
+            if (io.wait_for_data(1000000) <= 0)
+                throw_runtime_error("no answer");
+            int status = io.read(reinterpret_cast<char*>(&info) + n, sizeof(info) - n, false);
+            if (status < 0)
+                throw_runtime_error("connection closed");
+            n += status;
+        }
+
+        lat[i] = monotonic_nsec() - t0;
+    }
+
+    double calls = double(io.syscalls() - calls0) / ticks;
+    std::sort(lat.begin(), lat.end());
+    int64_t sum = 0;
+    for (int64_t l : lat)
+        sum += l;
+
+    printf("%-7s %6.2f syscalls/tick, latency mean %7.1fus, p50 %7.1fus, p99 %7.1fus\n",
+        name, calls, sum / 1e+3 / ticks, lat[ticks / 2] / 1e+3, lat[ticks * 99 / 100] / 1e+3);
+}
+
+int main(int argc, char const* argv[])
+{
+    int ticks = argc > 1 ? atoi(argv[1]) : 20000;
+    int port = 20000 + getpid() % 20000;
+
+    {
+        TCPSrv srv(port);
+        std::thread server([&srv, ticks]() { serve(srv, ticks); });
+        SocketIo io;
+        io.con = connect_to(port);
+        run("socket", io, ticks);
+        server.join();
+    }
+
+    if (!UringIo::supported())
+    {
+        printf("uring   not available\n");
+        return 0;
+    }
+
+    {
+        TCPSrv srv(port + 1);
+        std::thread server([&srv, ticks]() { serve(srv, ticks); });
+        auto con = connect_to(port + 1);
+        UringIo io(con->fd());
+        run("uring", io, ticks);
+        server.join();
+    }
+
+    return 0;
+}
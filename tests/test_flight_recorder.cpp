@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <cppmisc/traces.h>
+#include <cppmisc/timing.h>
+#include "../src/flight_recorder.h"
+
+
+void test1()
+{
+    char const* path = "test_flight_recorder.bin";
+    const int N = 10000;
+
+    {
+        FlightRecorder recorder(path, 1024, 1000);
+        for (int i = 0; i < N; ++ i)
+        {
+            FlightRecord rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.t = i * 1e-3;
+            rec.ball_found = i % 2;
+            rec.ctrl_u = -i;
+
+            while (!recorder.push(rec))
+                sleep_usec(100);
+        }
+        recorder.close();
+        assert(recorder.written() == N);
+    }
+
+    FILE* f = fopen(path, "rb");
+    assert(f);
+
+    char magic[8];
+    uint32_t version, record_size;
+    uint64_t count;
+    assert(fread(magic, 1, 8, f) == 8);
+    assert(fread(&version, 4, 1, f) == 1);
+    assert(fread(&record_size, 4, 1, f) == 1);
+    assert(fread(&count, 8, 1, f) == 1);
+    assert(memcmp(magic, "BFLYREC", 8) == 0);
+    assert(version == FlightRecorder::version);
+    assert(record_size == sizeof(FlightRecord));
+    assert(count == N);
+
+    fseek(f, FlightRecorder::header_size, SEEK_SET);
+    for (int i = 0; i < N; ++ i)
+    {
+        FlightRecord rec;
+        assert(fread(&rec, sizeof(rec), 1, f) == 1);
+        assert(rec.t == i * 1e-3);
+        assert(rec.ball_found == i % 2);
+        assert(rec.ctrl_u == -i);
+    }
+
+    FlightRecord extra;
+    assert(fread(&extra, sizeof(extra), 1, f) == 0);
+    fclose(f);
+    unlink(path);
+}
+
+void test2()
+{
+    // the ring overflows if nobody drains it
+    char const* path = "test_flight_recorder_drop.bin";
+    FlightRecorder recorder(path, 4, 1000000);
+    FlightRecord rec;
+    memset(&rec, 0, sizeof(rec));
+
+    int pushed = 0;
+    for (int i = 0; i < 100; ++ i)
+        pushed += recorder.push(rec);
+
+    assert(recorder.dropped() == uint64_t(100 - pushed));
+    assert(recorder.dropped() > 0);
+    recorder.close();
+    unlink(path);
+}
+
+int main()
+{
+    test1();
+    test2();
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <cmath>
+#include <cppmisc/traces.h>
+#include "../src/latency_histogram.h"
+
+
+void test1()
+{
+    LatencyHistogram h;
+    assert(h.count() == 0);
+    assert(h.percentile(0.5) == 0);
+
+    for (int64_t i = 0; i < 32; ++ i)
+        h.record(i);
+
+    // small values are stored exactly
+    assert(h.count() == 32);
+    assert(h.max() == 31);
+    assert(h.percentile(0.5) == 15);
+    assert(h.percentile(1.0) == 31);
+}
+
+void test2()
+{
+    LatencyHistogram h;
+    const int64_t N = 100000;
+
+    // 1us .. 100ms
+    for (int64_t i = 1; i <= N; ++ i)
+        h.record(i * 1000);
+
+    double qs[] = {0.5, 0.99, 0.999};
+    for (double q : qs)
+    {
+        double expected = q * N * 1000;
+        double actual = h.percentile(q);
+        assert(std::fabs(actual - expected) / expected < 1. / 32);
+        unused(actual);
+    }
+
+    assert(h.max() == N * 1000);
+    assert(h.percentile(1.0) == N * 1000);
+    h.dump("test");
+
+    h.reset();
+    assert(h.count() == 0);
+}
+
+int main()
+{
+    test1();
+    test2();
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <thread>
+#include <atomic>
+#include <cppmisc/traces.h>
+#include "../src/seqlock.h"
+
+
+struct Triple
+{
+    int64_t a;
+    int64_t b;
+    int64_t c;
+};
+
+void test1()
+{
+    SeqLock<Triple> slot;
+    Triple v;
+    assert(slot.load(v) == 0);
+    assert(slot.version() == 0);
+
+    slot.store({1, 2, 3});
+    assert(slot.load(v) == 1);
+    assert(v.a == 1 && v.b == 2 && v.c == 3);
+
+    slot.store({4, 5, 6});
+    assert(slot.version() == 2);
+    assert(slot.load(v) == 2);
+    assert(v.a == 4 && v.b == 5 && v.c == 6);
+}
+
+void test2()
+{
+    SeqLock<Triple> slot;
+    std::atomic<bool> stop(false);
+    const int64_t N = 1000000;
+
+    std::thread writer([&slot, &stop, N]() {
+        for (int64_t i = 1; i <= N; ++ i)
+            slot.store({i, 2 * i, 3 * i});
+        stop = true;
+    });
+
+    uint32_t prev = 0;
+    int64_t prev_a = 0;
+
+    while (!stop)
+    {
+        Triple v;
+        uint32_t version = slot.load(v);
+        assert(version >= prev);
+        assert(v.b == 2 * v.a && v.c == 3 * v.a);
+        assert(v.a >= prev_a);
+        prev = version;
+        prev_a = v.a;
+    }
+
+    writer.join();
+
+    Triple v;
+    slot.load(v);
+    assert(v.a == N);
+}
+
+int main()
+{
+    test1();
+    test2();
+    return 0;
+}
@@ -0,0 +1,642 @@
+#include <string>
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <cppmisc/traces.h>
+#include "../src/serializer.h"
+#include "../src/ser_message.h"
+
+
+static int64_t allocations = 0;
+
+void* operator new(size_t sz)
+{
+    ++ allocations;
+    void* p = malloc(sz);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+
+/*
+ * in-memory byte stream; read() returns at most chunk bytes of what was
+ * written so far, 0 when empty
+ */
+struct Stream
+{
+    std::string data;
+    size_t pos = 0;
+    int chunk = 1 << 20;
+
+    void write_measurement(int64_t ts, double x)
+    {
+        std::string pack;
+        ser::pack(pack, "ts", ts, "good", true, "x", x);
+        data += pack;
+    }
+
+    int read(char* p, int n)
+    {
+        int len = std::min<int>({n, chunk, int(data.size() - pos)});
+        memcpy(p, data.data() + pos, len);
+        pos += len;
+        return len;
+    }
+};
+
+ser::PacketReaderPtr make_reader(Stream& s)
+{
+    return ser::make_pack_reader([&s](char* p, int n) { return s.read(p, n); });
+}
+
+void test_fetch_latest()
+{
+    Stream s;
+    auto reader = make_reader(s);
+    ser::Packet pack;
+    int skipped = -1;
+    int64_t ts;
+
+    assert(reader->fetch_latest(pack, skipped) == 0);
+    assert(skipped == 0);
+
+    for (int i = 0; i < 10; ++ i)
+        s.write_measurement(i, i * 0.5);
+
+    assert(reader->fetch_latest(pack, skipped) == 1);
+    assert(skipped == 9);
+    assert(pack.get("ts", ts) > 0 && ts == 9);
+
+    assert(reader->fetch_latest(pack, skipped) == 0);
+    assert(skipped == 0);
+}
+
+void test_partial_packet()
+{
+    Stream s;
+    auto reader = make_reader(s);
+    ser::Packet pack;
+    int skipped;
+    int64_t ts;
+
+    s.write_measurement(1, 1.);
+    s.write_measurement(2, 2.);
+    std::string tail = s.data.substr(s.data.size() - 10);
+    s.data.resize(s.data.size() - 10);
+
+    // the incomplete packet stays buffered
+    assert(reader->fetch_latest(pack, skipped) == 1);
+    assert(skipped == 0);
+    assert(pack.get("ts", ts) > 0 && ts == 1);
+
+    s.data += tail;
+    assert(reader->fetch_latest(pack, skipped) == 1);
+    assert(pack.get("ts", ts) > 0 && ts == 2);
+}
+
+void test_drain_beyond_buffer()
+{
+    // more data than the reader buffer holds, delivered in odd chunks
+    Stream s;
+    s.chunk = 1000;
+    auto reader = make_reader(s);
+    ser::Packet pack;
+    int skipped;
+    int64_t ts;
+
+    const int N = 2000;
+    for (int i = 0; i < N; ++ i)
+        s.write_measurement(i, i);
+
+    int total_skipped = 0;
+    int status;
+    while ((status = reader->fetch_latest(pack, skipped)) > 0)
+    {
+        total_skipped += skipped;
+        pack.get("ts", ts);
+    }
+    assert(status == 0);
+    assert(ts == N - 1);
+    assert(s.pos == s.data.size());
+    unused(total_skipped);
+}
+
+void test_ring_wraparound()
+{
+    // packets of odd sizes, so that they straddle the end of the ring
+    Stream s;
+    s.chunk = 777;
+    auto reader = make_reader(s);
+    ser::PacketView view;
+    int64_t ts;
+    std::string name;
+
+    const int N = 20000;
+    for (int i = 0; i < N; ++ i)
+    {
+        std::string pack;
+        ser::pack(pack, "ts", int64_t(i), "name", std::string(i % 13, 'a'));
+        s.data += pack;
+    }
+
+    for (int i = 0; i < N; ++ i)
+    {
+        while (reader->fetch_next(view) == 0)
+            ;
+        assert(view.get("ts", ts, "name", name) > 0);
+        assert(ts == i && name.size() == size_t(i % 13));
+    }
+    assert(reader->fetch_next(view) == 0);
+}
+
+void test_large_packet()
+{
+    Stream s;
+    s.chunk = 4096;
+    auto reader = make_reader(s);
+    ser::PacketView view;
+    int64_t ts;
+    std::string blob;
+    int skipped;
+
+    // larger than the initial buffer
+    std::string big(300 * 1024, 'x');
+    std::string pack;
+    s.write_measurement(1, 1.);
+    ser::pack(pack, "ts", int64_t(2), "blob", big);
+    s.data += pack;
+    s.write_measurement(3, 3.);
+
+    int status;
+    for (int i = 1; i <= 3; ++ i)
+    {
+        while ((status = reader->fetch_next(view)) == 0)
+            ;
+        assert(status == 1);
+        assert(view.get("ts", ts) > 0 && ts == i);
+    }
+    assert(reader->fetch_next(view) == 0);
+
+    // the newest packet may be the large one; it completes over several reads
+    s.write_measurement(4, 4.);
+    s.data += pack;
+    ts = 0;
+    while (ts != 2)
+    {
+        status = reader->fetch_latest(view, skipped);
+        assert(status >= 0);
+        if (status > 0)
+            view.get("ts", ts);
+    }
+    assert(view.get("blob", blob) > 0 && blob == big);
+
+    // a size beyond any sane packet is taken for corrupted data
+    char buf[16];
+    memcpy(buf, ser::magic, 4);
+    uint32_t sz = 0x7fffffff;
+    memcpy(buf + 4, &sz, 4);
+    s.data.append(buf, 8);
+    assert(reader->fetch_next(view) < 0);
+    unused(status);
+}
+
+void test_fetch_next_order()
+{
+    Stream s;
+    auto reader = make_reader(s);
+    ser::Packet pack;
+    int64_t ts;
+
+    for (int i = 0; i < 5; ++ i)
+        s.write_measurement(i, i);
+
+    for (int i = 0; i < 5; ++ i)
+    {
+        assert(reader->fetch_next(pack) == 1);
+        assert(pack.get("ts", ts) > 0 && ts == i);
+    }
+    assert(reader->fetch_next(pack) == 0);
+}
+
+void test_packet_view()
+{
+    Stream s;
+    auto reader = make_reader(s);
+    ser::PacketView view;
+    int64_t ts;
+    double x;
+    bool good;
+    std::string name;
+
+    std::string pack;
+    ser::pack(pack, "ts", int64_t(7), "good", true, "x", 1.5, "name", "cam0");
+    s.data += pack;
+    s.write_measurement(8, 2.5);
+
+    assert(reader->fetch_next(view) == 1);
+    assert(view.nentries() == 4);
+    assert(view.get("ts", ts, "good", good, "x", x) > 0);
+    assert(ts == 7 && good && x == 1.5);
+    assert(view.get("name", name) > 0 && name == "cam0");
+    assert(view.get<double>("x") == 1.5);
+    assert(view.get("missing", x) < 0);
+
+    // type mismatch
+    int32_t i32;
+    assert(view.get("x", i32) < 0);
+
+    // the next fetch consumes the viewed packet
+    assert(reader->fetch_next(view) == 1);
+    assert(view.get("ts", ts, "x", x) > 0);
+    assert(ts == 8 && x == 2.5);
+    assert(reader->fetch_next(view) == 0);
+}
+
+void test_corrupted_size()
+{
+    // a zero size field is an error, not an incomplete packet
+    for (uint32_t sz : {0u, 3u})
+    {
+        Stream s;
+        s.data.append(ser::magic, strlen(ser::magic));
+        s.data.append((char const*)&sz, sizeof(sz));
+        s.write_measurement(1, 1.);
+
+        auto reader = make_reader(s);
+        ser::PacketView view;
+        int skipped;
+        assert(reader->fetch_next(view) == -1);
+        s.pos = 0;
+        assert(make_reader(s)->fetch_latest(view, skipped) == -1);
+        unused(skipped);
+    }
+}
+
+void test_packet_view_many_entries()
+{
+    // one variable more than the view indexes; the last "v0" overrides the first
+    const int N = ser::PacketView::max_entries + 1;
+    std::string body;
+    for (int i = 0; i < N; ++ i)
+    {
+        std::string var;
+        std::string name = i == N - 1 ? "v0" : "v" + std::to_string(i);
+        ser::pack(var, name.c_str(), int32_t(i));
+        body += var.substr(ser::pack_header_size);
+    }
+    uint32_t sz = uint32_t(ser::pack_header_size + body.size());
+
+    Stream s;
+    s.data.append(ser::magic, strlen(ser::magic));
+    s.data.append((char const*)&sz, sizeof(sz));
+    s.data += body;
+    s.write_measurement(1, 1.);
+
+    auto reader = make_reader(s);
+    ser::PacketView view;
+    int32_t v;
+    assert(reader->fetch_next(view) == 1);
+    assert(view.nentries() == N);
+    assert(view.get("v1", v) > 0 && v == 1);
+    assert(view.get("v31", v) > 0 && v == 31);
+    assert(view.get("v0", v) > 0 && v == N - 1);
+    assert(view.get("missing", v) < 0);
+
+    // the packet is consumed and the next one follows
+    int64_t ts;
+    assert(reader->fetch_next(view) == 1);
+    assert(view.get("ts", ts) > 0 && ts == 1);
+}
+
+void test_packet_view_no_allocations()
+{
+    Stream s;
+    s.chunk = 4096;
+    const int N = 1000;
+    for (int i = 0; i < N; ++ i)
+        s.write_measurement(i, i);
+
+    auto reader = make_reader(s);
+    ser::PacketView view;
+    int64_t ts;
+    double x;
+
+    int64_t before = allocations;
+    for (int i = 0; i < N; ++ i)
+    {
+        int status = reader->fetch_next(view);
+        assert(status == 1);
+        status = view.get("ts", ts, "x", x);
+        assert(status > 0 && ts == i);
+        unused(status);
+    }
+    assert(allocations == before);
+}
+
+using namespace ser::literals;
+
+static_assert(ser::fnv_hash_const("") == ser::OFFSET_BASIS, "fnv_hash_const");
+static_assert(ser::name_hash("ts"_h) == SER_KEY("ts")::hash, "fnv_hash_const");
+static_assert(ser::slot_of<SER_KEY("x")::hash, ser::layout<SER_KEY("ts"), SER_KEY("x")>>::value == 1, "slot_of");
+static_assert(ser::slot_of<SER_KEY("y")::hash, ser::layout<SER_KEY("ts"), SER_KEY("x")>>::value == -1, "slot_of");
+
+void test_const_hash()
+{
+    // chars above 0x7f must be sign extended exactly as fnv_hash does
+    char const* names[] = {"", "x", "ts", "good", "dtheta", "\x7f\x80\xff", "\xc3\xa9t\xc3\xa9"};
+    for (char const* name : names)
+        assert(ser::fnv_hash_const(name) == ser::fnv_hash(name));
+}
+
+void test_keys_wire_compatible()
+{
+    char a[128], b[128], c[128];
+    int na = ser::pack(a, sizeof(a), "ts", int64_t(5), "x", 1.25, "cmd", "start");
+    int nb = ser::pack(b, sizeof(b), "ts"_h, int64_t(5), "x"_h, 1.25, "cmd"_h, "start");
+    int nc = ser::pack(c, sizeof(c), SER_KEY("ts")(), int64_t(5), SER_KEY("x")(), 1.25, SER_KEY("cmd")(), "start");
+    assert(na > 0 && na == nb && na == nc);
+    assert(memcmp(a, b, na) == 0 && memcmp(a, c, na) == 0);
+
+    ser::PacketView view;
+    assert(view.parse(a, na) == 1);
+    int64_t ts;
+    double x;
+    assert(view.get("ts"_h, ts, "x", x) > 0 && ts == 5 && x == 1.25);
+    assert(view.get<double>(SER_KEY("x")()) == 1.25);
+
+    std::string str(a, na);
+    ser::Packet pack;
+    assert(pack.parse(str) == 1);
+    assert(pack.get("x"_h, x, SER_KEY("ts")(), ts) > 0 && ts == 5 && x == 1.25);
+}
+
+void test_layout()
+{
+    typedef SER_KEY("ts") key_ts;
+    typedef SER_KEY("good") key_good;
+    typedef SER_KEY("x") key_x;
+    typedef ser::layout<key_ts, key_good, key_x> measurement;
+
+    char buf[128];
+    int64_t ts;
+    double x;
+    bool good;
+    ser::PacketView view;
+
+    int n = ser::pack(buf, sizeof(buf), "ts", int64_t(3), "good", true, "x", 0.5);
+    assert(view.parse(buf, n) == 1);
+    assert(view.get(measurement(), key_good(), good, key_x(), x, key_ts(), ts) > 0);
+    assert(good && x == 0.5 && ts == 3);
+
+    // a different order is found by searching
+    n = ser::pack(buf, sizeof(buf), "x", 1.5, "ts", int64_t(4), "good", false);
+    assert(view.parse(buf, n) == 1);
+    assert(view.get(measurement(), key_good(), good, key_x(), x, key_ts(), ts) > 0);
+    assert(!good && x == 1.5 && ts == 4);
+
+    // a missing key
+    n = ser::pack(buf, sizeof(buf), "ts", int64_t(4));
+    assert(view.parse(buf, n) == 1);
+    assert(view.get(measurement(), key_x(), x) < 0);
+    unused(n);
+}
+
+void test_arrays()
+{
+    std::vector<double> xs = {0.5, -1.25, 3e10, 7.};
+    int32_t ids[] = {3, -1, 42};
+    char buf[256];
+
+    int n = ser::pack(buf, sizeof(buf), "ts", int64_t(1), "x", xs, "id", ser::make_array(ids, 3),
+        "none", std::vector<float>());
+    assert(n > 0 && n == ser::get_packed_size("ts", int64_t(1), "x", xs, "id", ser::make_array(ids, 3),
+        "none", std::vector<float>()));
+
+    // views refer to the packet
+    ser::PacketView view;
+    ser::array_view<double> x;
+    ser::array_view<int32_t> id;
+    ser::array_view<float> none;
+    int64_t ts;
+    assert(view.parse(buf, n) == 1);
+    assert(view.nentries() == 4);
+
+    int64_t before = allocations;
+    assert(view.get("x", x, "id", id, "none", none, "ts", ts) > 0);
+    assert(allocations == before);
+    assert(x.size() == 4 && id.size() == 3 && none.empty() && ts == 1);
+    assert(x.bytes() > buf && x.bytes() < buf + n);
+    for (int i = 0; i < x.size(); ++ i)
+        assert(x[i] == xs[i]);
+    for (int i = 0; i < id.size(); ++ i)
+        assert(id[i] == ids[i]);
+
+    // copies
+    std::vector<double> x2;
+    std::string str(buf, n);
+    ser::Packet pack;
+    assert(pack.parse(str) == 1);
+    assert(pack.get("x", x2) > 0 && x2 == xs);
+    std::vector<int32_t> id2;
+    assert(ser::unpack(buf, n, "id", id2, "ts", ts) > 0);
+    assert(id2.size() == 3 && id2[2] == 42);
+
+    // the element type must match
+    ser::array_view<float> xf;
+    assert(view.get("x", xf) < 0);
+    assert(view.get("ts", x) < 0);
+    assert(view.get("x", ts) < 0);
+
+    // a count beyond the packet is rejected
+    int len = ser::pack(buf, sizeof(buf), "x", xs);
+    uint32_t count = 1000;
+    memcpy(buf + ser::pack_header_size + 6, &count, sizeof(count));
+    assert(view.parse(buf, len) < 0);
+    unused(before);
+    unused(n);
+    unused(len);
+}
+
+void test_packet_writer()
+{
+    Stream s;
+    auto writer = [&s](char const* p, int n) { s.data.append(p, n); return n; };
+    ser::PacketWriter out(64);
+
+    assert(out.flush(writer) == 0);
+
+    // several packets go out in one write, the buffer grows as needed
+    int n1 = out.append("ts", int64_t(1), "cmd", "torque", "torque", 0.5);
+    int n2 = out.append("ts", int64_t(2), "cmd", "stop");
+    assert(n1 > 0 && n2 > 0 && out.size() == n1 + n2);
+    char raw[64];
+    int n3 = ser::pack(raw, sizeof(raw), "ts", int64_t(3));
+    out.append_raw(raw, n3);
+    assert(out.flush(writer) == n1 + n2 + n3);
+    assert(out.empty());
+
+    auto reader = make_reader(s);
+    ser::PacketView view;
+    int64_t ts;
+    for (int i = 1; i <= 3; ++ i)
+    {
+        assert(reader->fetch_next(view) == 1);
+        assert(view.get("ts", ts) > 0 && ts == i);
+    }
+
+    // once grown, appending doesn't allocate
+    int sent = 0;
+    auto count = [&sent](char const*, int n) { sent += n; return n; };
+    int64_t before = allocations;
+    for (int i = 0; i < 100; ++ i)
+    {
+        out.append("ts", int64_t(i), "cmd", "torque", "torque", 0.5);
+        out.append("ts", int64_t(i), "cmd", "stop");
+        out.append_raw(raw, n3);
+        out.flush(count);
+    }
+    assert(allocations == before);
+    assert(sent == 100 * (n1 + n2 + n3));
+    unused(n1);
+    unused(n2);
+    unused(before);
+}
+
+void test_send_pack_no_allocations()
+{
+    char buf[256];
+    int len = 0;
+    auto writer = [&buf, &len](char const* p, int n) { memcpy(buf, p, n); len = n; return n; };
+
+    int64_t before = allocations;
+    int status = ser::send_pack(writer, "ts", int64_t(1), "cmd", "start");
+    assert(status > 0 && status == len);
+    assert(allocations == before);
+
+    ser::PacketView view;
+    std::string cmd;
+    assert(view.parse(buf, len) == 1);
+    assert(view.get("cmd", cmd) > 0 && cmd == "start");
+    unused(status);
+    unused(before);
+}
+
+struct Measurement
+{
+    int64_t ts;
+    bool good;
+    double x;
+
+    template <typename V>
+    void fields(V& v)
+    {
+        v(SER_KEY("ts")(), ts);
+        v(SER_KEY("good")(), good);
+        v(SER_KEY("x")(), x);
+    }
+};
+
+void test_message()
+{
+    char a[128], b[128];
+    Measurement m = {7, true, 2.5};
+    int na = ser::pack_message(a, sizeof(a), m);
+    int nb = ser::pack(b, sizeof(b), "ts", int64_t(7), "good", true, "x", 2.5);
+    assert(na > 0 && na == nb && na == ser::get_message_size(m));
+    assert(memcmp(a, b, na) == 0);
+    assert(ser::pack_message(b, na - 1, m) < 0);
+
+    ser::MessageDecoder<Measurement> decoder;
+    Measurement r = {};
+    assert(decoder.decode(a, na, r) == 1);
+    assert(r.ts == 7 && r.good && r.x == 2.5);
+    assert(decoder.relearned() == 1);
+
+    // the same layout is read at the learned offsets
+    m.ts = 8;
+    m.x = -1;
+    na = ser::pack_message(a, sizeof(a), m);
+    assert(decoder.decode(a, na, r) == 1);
+    assert(r.ts == 8 && r.x == -1);
+    assert(decoder.relearned() == 1);
+
+    // same size, different order
+    nb = ser::pack(b, sizeof(b), "x", 3.5, "good", false, "ts", int64_t(9));
+    assert(nb == na);
+    assert(decoder.decode(b, nb, r) == 1);
+    assert(r.ts == 9 && !r.good && r.x == 3.5);
+    assert(decoder.relearned() == 2);
+
+    // extra variables are skipped
+    nb = ser::pack(b, sizeof(b), "ts", int64_t(10), "y", 1.0, "good", true, "x", 4.5);
+    assert(decoder.decode(b, nb, r) == 1);
+    assert(r.ts == 10 && r.good && r.x == 4.5);
+
+    // a missing field or a different type doesn't match the schema
+    nb = ser::pack(b, sizeof(b), "ts", int64_t(11), "good", false);
+    assert(decoder.decode(b, nb, r) < 0);
+    nb = ser::pack(b, sizeof(b), "ts", int32_t(11), "good", false, "x", 1.0);
+    assert(decoder.decode(b, nb, r) < 0);
+
+    // the learned layout is kept
+    uint64_t relearned = decoder.relearned();
+    assert(decoder.decode(b, ser::pack(b, sizeof(b), "ts", int64_t(12), "y", 2.0, "good", true, "x", 5.5), r) == 1);
+    assert(r.ts == 12 && decoder.relearned() == relearned);
+    unused(relearned);
+    assert(decoder.decoded() == 5);
+}
+
+void test_message_reader()
+{
+    Stream s;
+    s.chunk = 4096;
+    const int N = 1000;
+    for (int i = 0; i < N; ++ i)
+        s.write_measurement(i, i);
+
+    auto reader = make_reader(s);
+    ser::MessageDecoder<Measurement> decoder;
+    ser::PacketRef ref;
+    Measurement m;
+
+    int64_t before = allocations;
+    for (int i = 0; i < N; ++ i)
+    {
+        int status = reader->fetch_next(ref);
+        assert(status == 1);
+        status = decoder.decode(ref, m);
+        assert(status == 1 && m.ts == i && m.x == i && m.good);
+        unused(status);
+    }
+    assert(allocations == before);
+    assert(decoder.relearned() == 1);
+}
+
+int main()
+{
+    test_fetch_latest();
+    test_partial_packet();
+    test_drain_beyond_buffer();
+    test_fetch_next_order();
+    test_ring_wraparound();
+    test_large_packet();
+    test_packet_view();
+    test_corrupted_size();
+    test_packet_view_many_entries();
+    test_packet_view_no_allocations();
+    test_const_hash();
+    test_keys_wire_compatible();
+    test_layout();
+    test_arrays();
+    test_packet_writer();
+    test_send_pack_no_allocations();
+    test_message();
+    test_message_reader();
+    return 0;
+}
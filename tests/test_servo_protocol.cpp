@@ -0,0 +1,328 @@
+#include <thread>
+#include <unistd.h>
+#include <cppmisc/traces.h>
+#include <cppmisc/timing.h>
+#include "../src/servo_iface.h"
+
+
+void test_info_v2()
+{
+    Servo::Sample samples[3] = {{1, 0.5, -0.25}, {2, 1e-3, 3.}, {3, -2., 0.125}};
+    Servo::Sample decoded[Servo::max_samples];
+    Servo::InfoHeaderV2 hdr;
+    char buf[256];
+
+    int n = Servo::serialize_info_v2(7, samples, 3, Servo::EncodingDouble, buf, sizeof(buf));
+    assert(n == 16 + 3 * 24);
+    assert(Servo::get_info_size(buf, n) == n);
+    assert(Servo::deserialize_info_v2(buf, hdr, decoded) == 3);
+    assert(hdr.seq == 7);
+    for (int i = 0; i < 3; ++ i)
+        assert(decoded[i].t == samples[i].t && decoded[i].theta == samples[i].theta && decoded[i].dtheta == samples[i].dtheta);
+
+    n = Servo::serialize_info_v2(8, samples, 3, Servo::EncodingFloat, buf, sizeof(buf));
+    assert(n == 16 + 3 * 16);
+    assert(Servo::deserialize_info_v2(buf, hdr, decoded) == 3);
+    assert(decoded[1].t == 2 && decoded[1].theta == float(1e-3) && decoded[2].dtheta == 0.125);
+
+    // a partial header asks for more data, garbage is rejected
+    assert(Servo::get_info_size(buf, 10) == 0);
+    assert(Servo::serialize_info_v2(8, samples, 3, Servo::EncodingFloat, buf, n - 1) < 0);
+    buf[9] = 100;
+    assert(Servo::get_info_size(buf, n) < 0);
+    assert(Servo::get_info_size("garbage!", 8) < 0);
+
+    // v1 packets share the stream
+    Servo::InfoPack v1;
+    Servo::init_info_pack(1, 2., 3., v1);
+    assert(Servo::get_info_size(reinterpret_cast<char const*>(&v1), 6) == sizeof(v1));
+    unused(n);
+}
+
+void test_start_cmd()
+{
+    Servo::CmdPack pack;
+    Servo::init_cmd_start(0, 2, true, pack);
+    assert(Servo::get_cmd(pack) == Servo::CmdStartV2F);
+    Servo::init_cmd_start(0, 2, false, pack);
+    assert(Servo::get_cmd(pack) == Servo::CmdStartV2);
+    Servo::init_cmd_start(0, 1, true, pack);
+    assert(Servo::get_cmd(pack) == Servo::CmdStart);
+
+    // v1 firmware compares the prefix only and takes v2 for a plain start
+    Servo::init_cmd_start(0, 2, false, pack);
+    assert(memcmp(pack.cmd, Servo::_cmd_start, sizeof(Servo::_cmd_start) - 1) == 0);
+}
+
+/*
+ * servo over loopback: v2 packets with a lost and a late one, a burst for
+ * get_latest_state and the stop sequence
+ */
+void test_servo_v2()
+{
+    int port = 20000 + getpid() % 20000;
+    TCPSrv srv(port);
+    bool stopped = false;
+
+    std::thread server([&srv, &stopped]() {
+        auto con = srv.wait_for_connection();
+        Servo::CmdPack cmd;
+        assert(con->read(reinterpret_cast<char*>(&cmd), sizeof(cmd), true) == sizeof(cmd));
+        assert(Servo::get_cmd(cmd) == Servo::CmdStartV2F);
+
+        Servo::Sample samples[4];
+        for (int i = 0; i < 4; ++ i)
+            samples[i] = {i, 0.5 * i, -0.5 * i};
+
+        // seq 2 arrives after 3
+        char buf[1024];
+        int len = 0;
+        len += Servo::serialize_info_v2(0, samples, 3, Servo::EncodingFloat, buf + len, sizeof(buf) - len);
+        len += Servo::serialize_info_v2(1, samples + 3, 1, Servo::EncodingFloat, buf + len, sizeof(buf) - len);
+        len += Servo::serialize_info_v2(3, samples, 1, Servo::EncodingFloat, buf + len, sizeof(buf) - len);
+        len += Servo::serialize_info_v2(2, samples, 2, Servo::EncodingFloat, buf + len, sizeof(buf) - len);
+        len += Servo::serialize_info_v2(4, samples + 1, 2, Servo::EncodingFloat, buf + len, sizeof(buf) - len);
+        assert(con->write(buf, len));
+
+        // wait for the first batch to be consumed
+        assert(con->read(reinterpret_cast<char*>(&cmd), sizeof(cmd), true) == sizeof(cmd));
+        assert(Servo::get_cmd(cmd) == Servo::CmdTorque);
+
+        len = 0;
+        for (int seq = 5; seq < 10; ++ seq)
+            len += Servo::serialize_info_v2(seq, samples, 4, Servo::EncodingFloat, buf + len, sizeof(buf) - len);
+        assert(con->write(buf, len));
+
+        // torque 0 and stop come together
+        Servo::CmdPack cmds[2];
+        int n = 0;
+        while (n < (int)sizeof(cmds))
+        {
+            int status = con->read(reinterpret_cast<char*>(cmds) + n, sizeof(cmds) - n, true);
+            assert(status > 0);
+            n += status;
+        }
+        assert(Servo::get_cmd(cmds[0]) == Servo::CmdTorque && cmds[0].torque == 0.);
+        assert(Servo::get_cmd(cmds[1]) == Servo::CmdStop);
+        stopped = true;
+    });
+
+    Json::Value cfg;
+    cfg["servo"]["ip"] = "127.0.0.1";
+    cfg["servo"]["port"] = port;
+    cfg["servo"]["protocol"] = 2;
+    cfg["servo"]["compact"] = true;
+
+    auto servo = ServoIfc::capture_instance();
+    servo->init(cfg);
+
+    // the server may not listen yet
+    for (int attempt = 0; ; ++ attempt)
+    {
+        try
+        {
+            servo->start();
+            break;
+        }
+        catch (std::exception const&)
+        {
+            assert(attempt < 100);
+            sleep_usec(10000);
+        }
+    }
+
+    int64_t t;
+    double theta, dtheta;
+    int64_t expected_t[] = {0, 1, 2, 3, 0, 1, 2};
+    for (int64_t et : expected_t)
+    {
+        assert(servo->get_state(t, theta, dtheta, true) == 1);
+        assert(t == et && theta == 0.5 * et && dtheta == -0.5 * et);
+    }
+    assert(servo->lost() == 1);
+    assert(servo->late() == 1);
+    assert(servo->get_state(t, theta, dtheta, false) == 0);
+
+    // 20 samples, however many reads they take
+    servo->set_torque(0.1);
+    uint64_t taken = 0;
+    do
+    {
+        assert(servo->get_latest_state(t, theta, dtheta, true) == 1);
+        ++ taken;
+    }
+    while (taken + servo->skipped() < 20);
+    assert(t == 3);
+    assert(servo->lost() == 1);
+
+    servo->stop();
+    server.join();
+    assert(stopped);
+    unused(stopped);
+}
+
+/*
+ * servo over udp: reordered datagrams, newest-wins reads and zero torque
+ * once the state goes stale
+ */
+void test_servo_udp()
+{
+    int srv_port = 20000 + getpid() % 20000;
+    int cli_port = srv_port + 1;
+    Udp srv("127.0.0.1", cli_port, srv_port);
+    bool stopped = false;
+
+    auto send_state = [&srv](uint32_t seq, int64_t t) {
+        Servo::Sample sample = {t, 0.1 * t, 0.};
+        char buf[64];
+        int len = Servo::serialize_info_v2(seq, &sample, 1, Servo::EncodingDouble, buf, sizeof(buf));
+        bool ok = srv.write(buf, len);
+        assert(ok);
+        unused(ok);
+    };
+
+    auto read_cmd = [&srv](Servo::CmdPack* cmds, int n) {
+        int len = srv.read(reinterpret_cast<char*>(cmds), n * sizeof(Servo::CmdPack), true);
+        return len / int(sizeof(Servo::CmdPack));
+    };
+
+    std::thread server([&]() {
+        Servo::CmdPack cmds[2];
+        assert(read_cmd(cmds, 2) == 1 && Servo::get_cmd(cmds[0]) == Servo::CmdStartV2);
+
+        send_state(0, 10);
+        send_state(2, 12);
+        send_state(1, 11);
+
+        // the controller reacts to the newest state
+        assert(read_cmd(cmds, 2) == 1);
+        assert(Servo::get_cmd(cmds[0]) == Servo::CmdTorque && cmds[0].torque == 0.25);
+
+        // no more state: the next command is made safe
+        assert(read_cmd(cmds, 2) == 1 && cmds[0].torque == 0.);
+
+        send_state(3, 13);
+        assert(read_cmd(cmds, 2) == 1 && cmds[0].torque == 0.5);
+
+        // torque 0 and stop in one datagram
+        assert(read_cmd(cmds, 2) == 2);
+        assert(Servo::get_cmd(cmds[0]) == Servo::CmdTorque && cmds[0].torque == 0.);
+        assert(Servo::get_cmd(cmds[1]) == Servo::CmdStop);
+        stopped = true;
+    });
+
+    Json::Value cfg;
+    cfg["servo"]["ip"] = "127.0.0.1";
+    cfg["servo"]["port"] = srv_port;
+    cfg["servo"]["protocol"] = 2;
+    cfg["servo"]["compact"] = false;
+    cfg["servo"]["transport"] = "udp";
+    cfg["servo"]["local_port"] = cli_port;
+    cfg["servo"]["safe_timeout_usec"] = 50000;
+
+    auto servo = ServoIfc::capture_instance();
+    servo->init(cfg);
+    servo->start();
+    uint64_t late = servo->late();
+
+    int64_t t;
+    double theta, dtheta;
+    while (servo->wait_for_data(10000) == 0)
+        ;
+    sleep_usec(20000);
+    assert(servo->get_latest_state(t, theta, dtheta, true) == 1);
+    assert(t == 12);
+    assert(servo->late() == late + 1);
+    servo->set_torque(0.25);
+
+    sleep_usec(100000);
+    uint64_t safe = servo->safe_torques();
+    servo->set_torque(0.25);
+    assert(servo->safe_torques() == safe + 1);
+
+    assert(servo->get_latest_state(t, theta, dtheta, true) == 1 && t == 13);
+    servo->set_torque(0.5);
+
+    servo->stop();
+    server.join();
+    assert(stopped);
+    unused(safe);
+    unused(late);
+    unused(stopped);
+}
+
+/*
+ * a servo that goes quiet gets zero torque while the controller blocks
+ * waiting for its state
+ */
+void test_servo_udp_quiet()
+{
+    int srv_port = 20000 + (getpid() + 7) % 20000;
+    int cli_port = srv_port + 1;
+    Udp srv("127.0.0.1", cli_port, srv_port);
+    const int64_t safe_timeout_usec = 50000;
+
+    auto send_state = [&srv](uint32_t seq, int64_t t) {
+        Servo::Sample sample = {t, 0.1 * t, 0.};
+        char buf[64];
+        int len = Servo::serialize_info_v2(seq, &sample, 1, Servo::EncodingDouble, buf, sizeof(buf));
+        bool ok = srv.write(buf, len);
+        assert(ok);
+        unused(ok);
+    };
+
+    auto read_cmd = [&srv](Servo::CmdPack* cmds, int n, int64_t usec) {
+        int len = srv.read(reinterpret_cast<char*>(cmds), n * sizeof(Servo::CmdPack), usec);
+        return len / int(sizeof(Servo::CmdPack));
+    };
+
+    int64_t quiet_usec = -1;
+    std::thread server([&]() {
+        Servo::CmdPack cmds[2];
+        assert(read_cmd(cmds, 2, -1) == 1 && Servo::get_cmd(cmds[0]) == Servo::CmdStartV2);
+        send_state(0, 10);
+
+        // no more state: zero torque comes without a set_torque call
+        int64_t t0 = monotonic_nsec();
+        assert(read_cmd(cmds, 2, 10 * safe_timeout_usec) == 1);
+        quiet_usec = (monotonic_nsec() - t0) / 1000;
+        assert(Servo::get_cmd(cmds[0]) == Servo::CmdTorque && cmds[0].torque == 0.);
+
+        send_state(1, 11);
+        assert(read_cmd(cmds, 2, -1) == 2 && Servo::get_cmd(cmds[1]) == Servo::CmdStop);
+    });
+
+    Json::Value cfg;
+    cfg["servo"]["ip"] = "127.0.0.1";
+    cfg["servo"]["port"] = srv_port;
+    cfg["servo"]["protocol"] = 2;
+    cfg["servo"]["transport"] = "udp";
+    cfg["servo"]["local_port"] = cli_port;
+    cfg["servo"]["safe_timeout_usec"] = Json::Int64(safe_timeout_usec);
+
+    auto servo = ServoIfc::capture_instance();
+    servo->init(cfg);
+    servo->start();
+
+    int64_t t;
+    double theta, dtheta;
+    uint64_t safe = servo->safe_torques();
+    assert(servo->get_state(t, theta, dtheta, true) == 1 && t == 10);
+    assert(servo->get_state(t, theta, dtheta, true) == 1 && t == 11);
+    assert(servo->safe_torques() > safe);
+
+    servo->stop();
+    server.join();
+    assert(quiet_usec >= 0 && quiet_usec < 2 * safe_timeout_usec);
+    unused(safe);
+}
+
+int main()
+{
+    test_info_v2();
+    test_start_cmd();
+    test_servo_v2();
+    test_servo_udp();
+    test_servo_udp_quiet();
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include <thread>
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <cppmisc/traces.h>
+#include <cppmisc/timing.h>
+#include "../src/shm_ring.h"
+#include "../src/cam_iface.h"
+
+using namespace ser::literals;
+
+
+std::string ring_name(char const* tag)
+{
+    return "/butterfly_test_" + std::string(tag) + "_" + std::to_string(getpid());
+}
+
+void test_round_trip()
+{
+    auto producer = ShmRing::create(ring_name("rt"), 100);
+    auto consumer = ShmRing::open(ring_name("rt"));
+    assert(producer->capacity() == 4096);
+    assert(consumer->capacity() == 4096);
+
+    char out[3000];
+    char in[3000];
+    for (int i = 0; i < (int)sizeof(out); ++ i)
+        out[i] = char(i * 7);
+
+    // the second message wraps around the end of the data area
+    for (int round = 0; round < 5; ++ round)
+    {
+        assert(producer->write(out, sizeof(out)));
+        assert(!producer->write(out, sizeof(out)));
+        assert(consumer->available() == sizeof(out));
+
+        int n = consumer->read(in, 1000);
+        assert(n == 1000);
+        n += consumer->read(in + n, sizeof(in));
+        assert(n == sizeof(in));
+        assert(memcmp(in, out, sizeof(in)) == 0);
+        assert(consumer->read(in, sizeof(in)) == 0);
+        unused(n);
+    }
+
+    assert(consumer->wait_for_data(1000) == 0);
+}
+
+void test_open_missing()
+{
+    bool failed = false;
+    try
+    {
+        ShmRing::open(ring_name("missing"));
+    }
+    catch (std::exception const&)
+    {
+        failed = true;
+    }
+    assert(failed);
+    unused(failed);
+}
+
+// a producer that leaves is noticed by the consumer
+void test_producer_gone()
+{
+    auto producer = ShmRing::create(ring_name("gone"), 4096);
+    auto consumer = ShmRing::open(ring_name("gone"));
+    assert(consumer->producer_alive(0));
+
+    // a silent producer is gone after the timeout, until it beats again
+    sleep_usec(5000);
+    assert(!consumer->producer_alive(1000));
+    producer->heartbeat();
+    assert(consumer->producer_alive(1000));
+
+    // what is written before closing is read first; the sleeping consumer
+    // is woken by the close
+    std::thread closer([&producer]() {
+        sleep_usec(20000);
+        producer.reset();
+    });
+    assert(consumer->wait_for_data(1000000) == -1);
+    closer.join();
+    assert(!consumer->producer_alive(0));
+}
+
+// the header capacity must be a power of two
+void test_open_bad_capacity()
+{
+    std::string name = ring_name("cap");
+    uint64_t const cap = 3 * 4096;
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    assert(fd >= 0);
+    int status = ftruncate(fd, ShmRing::header_size + cap);
+    assert(status == 0);
+    void* p = mmap(nullptr, ShmRing::header_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(p != MAP_FAILED);
+    uint32_t const magic = 0x474e5252;
+    uint32_t const version = ShmRing::version;
+    memcpy(static_cast<char*>(p) + 0, &magic, sizeof(magic));
+    memcpy(static_cast<char*>(p) + 4, &version, sizeof(version));
+    memcpy(static_cast<char*>(p) + 8, &cap, sizeof(cap));
+    munmap(p, ShmRing::header_size);
+    close(fd);
+
+    bool failed = false;
+    try
+    {
+        ShmRing::open(name);
+    }
+    catch (std::exception const&)
+    {
+        failed = true;
+    }
+    shm_unlink(name.c_str());
+    assert(failed);
+    unused(failed);
+    unused(status);
+}
+
+/*
+ * the consumer sleeps on the futex and a producer in another thread
+ * wakes it up
+ */
+void test_wakeup()
+{
+    auto producer = ShmRing::create(ring_name("wake"), 4096);
+    auto consumer = ShmRing::open(ring_name("wake"));
+    const int count = 1000;
+
+    std::thread writer([producer]() {
+        for (int i = 0; i < count; ++ i)
+        {
+            while (!producer->write(reinterpret_cast<char const*>(&i), sizeof(i)))
+                sleep_usec(10);
+            if (i % 100 == 0)
+                sleep_usec(1000);
+        }
+    });
+
+    int next = 0;
+    while (next < count)
+    {
+        int status = consumer->wait_for_data(1000000);
+        assert(status == 1);
+        unused(status);
+
+        int v;
+        while (consumer->available() >= (int)sizeof(v))
+        {
+            consumer->read(reinterpret_cast<char*>(&v), sizeof(v));
+            assert(v == next);
+            ++ next;
+        }
+    }
+
+    writer.join();
+}
+
+// camera measurements from a camera server on the same host
+void test_camera_shm()
+{
+    auto producer = ShmRing::create(ring_name("cam"), 4096);
+
+    Json::Value cfg;
+    cfg["camera"]["shm"] = ring_name("cam");
+    auto cam = Camera::capture_instance();
+    cam->init(cfg);
+    cam->start();
+
+    int64_t ts;
+    double x, y;
+    assert(cam->get(ts, x, y) == 0);
+    assert(cam->wait_for_data(1000) == 0);
+
+    auto writer = [&producer](char const* p, int n) { return producer->write(p, n) ? n : -1; };
+    for (int i = 0; i < 3; ++ i)
+    {
+        int status = ser::send_pack(writer, "ts"_h, int64_t(i), "good"_h, true, "x"_h, 0.5 * i, "y"_h, -0.5 * i);
+        assert(status > 0);
+        unused(status);
+    }
+    ser::send_pack(writer, "ts"_h, int64_t(3), "good"_h, false);
+
+    assert(cam->wait_for_data(1000) == 1);
+    assert(cam->get(ts, x, y) == 1);
+    assert(ts == 0 && x == 0. && y == 0.);
+    assert(cam->get(ts, x, y) == 1);
+    assert(ts == 1 && x == 0.5 && y == -0.5);
+    assert(cam->get_latest(ts, x, y) == -1);
+    assert(cam->get(ts, x, y) == 0);
+
+    bool failed = false;
+    try
+    {
+        cam->fd();
+    }
+    catch (std::exception const&)
+    {
+        failed = true;
+    }
+    assert(failed);
+
+    // the camera server leaves: the controller stops like on a closed socket
+    producer.reset();
+    failed = false;
+    try
+    {
+        cam->get(ts, x, y);
+    }
+    catch (std::exception const&)
+    {
+        failed = true;
+    }
+    assert(failed);
+
+    cam->stop();
+    unused(failed);
+}
+
+int main()
+{
+    test_round_trip();
+    test_open_missing();
+    test_producer_gone();
+    test_open_bad_capacity();
+    test_wakeup();
+    test_camera_shm();
+    return 0;
+}
@@ -0,0 +1,388 @@
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <math.h>
+#include <cppmisc/traces.h>
+#include "../src/splines.h"
+#include "../src/static_spline.h"
+
+
+struct SplineData
+{
+	std::vector<double> knots;
+	std::vector<double> coefs;
+	double xmin, xmax;	// where the B-spline recursion is defined
+};
+
+SplineData make_data(int degree, bool uniform, std::mt19937& gen)
+{
+	std::uniform_real_distribution<double> step(0.5, 1.5);
+	std::uniform_real_distribution<double> coef(-1.0, 1.0);
+	SplineData d;
+	int const nknots = 40;
+
+	double x = -3.0;
+	for (int i = 0; i < nknots; ++ i)
+	{
+		d.knots.push_back(x);
+		x += uniform ? 0.25 : 0.25 * step(gen);
+	}
+	for (int i = 0; i < nknots + degree - 1; ++ i)
+		d.coefs.push_back(coef(gen));
+
+	if (uniform)
+	{
+		double const h = (d.knots.back() - d.knots.front()) / (d.coefs.size() - 1);
+		d.xmin = d.knots.front() + degree * h;
+		d.xmax = d.knots.back();
+	}
+	else
+	{
+		d.xmin = d.knots.front();
+		d.xmax = d.knots[nknots - degree];
+	}
+	return d;
+}
+
+/*
+ * the power basis form gives the values and derivatives of the B-spline;
+ * errors are relative to the largest magnitude of each derivative
+ */
+void test_power_basis()
+{
+	std::mt19937 gen(1);
+
+	for (int degree = 1; degree <= 5; ++ degree)
+	{
+		for (bool uniform : {true, false})
+		{
+			SplineData d = make_data(degree, uniform, gen);
+			spline bs(degree, d.knots, d.coefs, "none", "bspline");
+			spline pp(degree, d.knots, d.coefs, "none", "power");
+
+			std::uniform_real_distribution<double> arg(d.xmin, d.xmax);
+			for (int der = 0; der <= std::min(degree, 3); ++ der)
+			{
+				double maxerr = 0.;
+				double maxval = 0.;
+				for (int i = 0; i < 10000; ++ i)
+				{
+					double const x = arg(gen);
+					double const a = bs(x, der);
+					double const b = pp(x, der);
+					maxerr = std::max(maxerr, fabs(a - b));
+					maxval = std::max(maxval, fabs(a));
+				}
+				assert(maxerr <= 1e-12 * maxval);
+			}
+		}
+	}
+}
+
+/*
+ * eval_all gives the same numbers as the separate calls, for both bases and
+ * the periodic argument wrapping
+ */
+void test_eval_all()
+{
+	std::mt19937 gen(2);
+
+	for (int degree = 3; degree <= 5; ++ degree)
+	{
+		for (bool uniform : {true, false})
+		{
+			SplineData d = make_data(degree, uniform, gen);
+			for (char const* basis : {"bspline", "power"})
+			{
+				spline s(degree, d.knots, d.coefs, "periodic", basis);
+				std::uniform_real_distribution<double> arg(2 * d.knots.front(), 2 * d.knots.back());
+
+				for (int i = 0; i < 1000; ++ i)
+				{
+					double const x = arg(gen);
+					for (int maxder = 0; maxder <= 3; ++ maxder)
+					{
+						// a finite sentinel: -Ofast folds isnan() to false
+						double const untouched = 1e300;
+						double out[4] = {untouched, untouched, untouched, untouched};
+						s.eval_all(x, out, maxder);
+						for (int der = 0; der <= maxder; ++ der)
+						{
+							double const expected = s(x, der);
+							assert(fabs(out[der] - expected) <= 1e-12 * (1 + fabs(expected)));
+						}
+						for (int der = maxder + 1; der < 4; ++ der)
+							assert(out[der] == untouched);
+					}
+				}
+			}
+		}
+	}
+}
+
+/*
+ * channels of a bundle match the splines made of them one by one
+ */
+void test_bundle()
+{
+	std::mt19937 gen(3);
+	std::uniform_real_distribution<double> coef(-1.0, 1.0);
+	int const nchannels = 5;
+
+	for (int degree = 1; degree <= 5; ++ degree)
+	{
+		for (bool uniform : {true, false})
+		{
+			SplineData d = make_data(degree, uniform, gen);
+			std::vector<std::vector<double>> coefs(nchannels, d.coefs);
+			for (int m = 1; m < nchannels; ++ m)
+				for (double& c : coefs[m])
+					c = coef(gen);
+
+			spline_bundle b(degree, d.knots, coefs, "periodic");
+			assert(b.channels() == nchannels);
+			std::vector<std::unique_ptr<spline>> ss;
+			for (int m = 0; m < nchannels; ++ m)
+				ss.emplace_back(new spline(degree, d.knots, coefs[m], "periodic", "power"));
+
+			std::uniform_real_distribution<double> arg(2 * d.knots.front(), 2 * d.knots.back());
+			int const maxder = std::min(degree, 3);
+			double maxerr[4] = {}, maxval[4] = {};
+			for (int i = 0; i < 1000; ++ i)
+			{
+				double const x = arg(gen);
+				double out[4 * nchannels];
+				b.eval_all(x, out, maxder);
+				for (int r = 0; r <= maxder; ++ r)
+				{
+					double one[nchannels];
+					b.eval(x, one, r);
+					for (int m = 0; m < nchannels; ++ m)
+					{
+						double const expected = (*ss[m])(x, r);
+						assert(one[m] == out[r * nchannels + m]);
+						maxerr[r] = std::max(maxerr[r], fabs(out[r * nchannels + m] - expected));
+						maxval[r] = std::max(maxval[r], fabs(expected));
+					}
+				}
+			}
+			for (int r = 0; r <= maxder; ++ r)
+				assert(maxerr[r] <= 1e-12 * maxval[r]);
+		}
+	}
+
+	// wrong arguments are reported by the status, out stays as is
+	{
+		SplineData d = make_data(3, true, gen);
+		spline_bundle periodic(3, d.knots, {d.coefs, d.coefs}, "periodic");
+		spline_bundle bounded(3, d.knots, {d.coefs, d.coefs});
+		double out[2] = {1.0, 1.0};
+		bool ok = periodic.eval_all(NAN, out, 0) || periodic.eval_all(INFINITY, out, 0) ||
+			bounded.eval_all(d.knots.back() + 1.0, out, 0) || periodic.eval_all(d.knots.front(), out, 4);
+		assert(!ok && out[0] == 1.0 && out[1] == 1.0);
+		ok = periodic.eval_all(1e300, out, 0);
+		assert(ok);
+		unused(ok);
+	}
+
+	// channels must share the knots
+	bool thrown = false;
+	try
+	{
+		SplineData d = make_data(3, false, gen);
+		std::vector<double> shorter(d.coefs.begin(), d.coefs.end() - 1);
+		spline_bundle b(3, d.knots, {d.coefs, shorter});
+	}
+	catch (std::exception const&)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+	unused(thrown);
+}
+
+/*
+ * static_spline gives the numbers of spline in the power basis, and
+ * reports wrong arguments by the status
+ */
+template <int n, bool uniform, typename Extrapolation>
+void check_static_spline(char const* extrap, std::mt19937& gen)
+{
+	SplineData d = make_data(n, uniform, gen);
+	static_spline<n, uniform, Extrapolation> ss(d.knots, d.coefs);
+	spline s(n, d.knots, d.coefs, extrap, "power");
+
+	std::uniform_real_distribution<double> arg(d.knots.front(), d.knots.back());
+	for (int i = 0; i < 1000; ++ i)
+	{
+		double const x = arg(gen);
+		double out[4], expected[4];
+		s.eval_all(x, expected, 3);
+		bool ok = ss.template eval_all<3>(x, out);
+		assert(ok);
+		for (int der = 0; der < 4; ++ der)
+			assert(fabs(out[der] - expected[der]) <= 1e-12 * (1 + fabs(expected[der])));
+
+		// -Ofast may contract eval and eval_all differently
+		double y = NAN;
+		ok = ss.template eval<1>(x, y);
+		assert(ok && fabs(y - out[1]) <= 1e-12 * (1 + fabs(out[1])));
+		assert(fabs(ss(x) - out[0]) <= 1e-12 * (1 + fabs(out[0])));
+		unused(ok);
+	}
+
+	// NaN and inf are never evaluated
+	double y = 1.0;
+	double out[4] = {1.0, 1.0, 1.0, 1.0};
+	bool ok = ss.eval(NAN, y) || ss.eval(-INFINITY, y) || ss.template eval_all<3>(NAN, out);
+	assert(!ok && y == 1.0 && out[0] == 1.0 && out[3] == 1.0);
+	unused(ok);
+}
+
+void test_static_spline()
+{
+	std::mt19937 gen(4);
+	check_static_spline<3, true, spline_extrapolation::none>("none", gen);
+	check_static_spline<3, false, spline_extrapolation::none>("none", gen);
+	check_static_spline<5, false, spline_extrapolation::periodic>("periodic", gen);
+	check_static_spline<2, true, spline_extrapolation::end_value>("end-value", gen);
+
+	// out of range: no throw with eval, a throw with val
+	SplineData d = make_data(3, false, gen);
+	static_spline<3, false> ss(d.knots, d.coefs);
+	double y = 1.0;
+	bool ok = ss.eval(d.knots.back() + 1.0, y);
+	assert(!ok && y == 1.0);
+	unused(ok);
+
+	bool thrown = false;
+	try
+	{
+		ss.val(d.knots.front() - 1.0);
+	}
+	catch (std::exception const&)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+
+	// periodic and end-value map the argument into the knots
+	static_spline<3, false, spline_extrapolation::periodic> sp(d.knots, d.coefs);
+	spline s(3, d.knots, d.coefs, "periodic", "power");
+	double const x = d.knots.back() + 0.3;
+	ok = sp.eval(x, y);
+	assert(ok && fabs(y - s(x)) <= 1e-12);
+
+	// the knot kind is checked
+	thrown = false;
+	try
+	{
+		static_spline<3, true> su(d.knots, d.coefs);
+	}
+	catch (std::exception const&)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+	unused(thrown);
+}
+
+/*
+ * batch evaluation matches val() for sorted and shuffled arguments, in
+ * place and for lengths that don't fill the SIMD lanes
+ */
+void test_batch()
+{
+	std::mt19937 gen(5);
+
+	for (int degree = 1; degree <= 5; ++ degree)
+	{
+		for (bool uniform : {true, false})
+		{
+			SplineData d = make_data(degree, uniform, gen);
+			for (char const* basis : {"bspline", "power"})
+			{
+				for (char const* extrap : {"periodic", "end-value"})
+				{
+					spline s(degree, d.knots, d.coefs, extrap, basis);
+					std::uniform_real_distribution<double> arg(2 * d.knots.front(), 2 * d.knots.back());
+
+					for (size_t len : {0, 1, 3, 7, 300, 1001})
+					{
+						std::vector<double> x(len);
+						for (double& xi : x)
+							xi = arg(gen);
+						for (bool sorted : {true, false})
+						{
+							if (sorted)
+								std::sort(x.begin(), x.end());
+
+							for (int der = 0; der <= std::min(degree, 3); ++ der)
+							{
+								std::vector<double> y(len), z(x);
+								s.eval(x.data(), y.data(), len, der);
+								s.eval(z.data(), z.data(), len, der);
+								for (size_t i = 0; i < len; ++ i)
+								{
+									double const expected = s(x[i], der);
+									assert(fabs(y[i] - expected) <= 1e-12 * (1 + fabs(expected)));
+									assert(z[i] == y[i]);
+									unused(expected);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// arguments out of range throw as val() does
+	SplineData d = make_data(3, false, gen);
+	spline s(3, d.knots, d.coefs, "none", "power");
+	double x[2] = {d.knots.front(), d.knots.back() + 1.0};
+	double y[2];
+	bool thrown = false;
+	try
+	{
+		s.eval(x, y, 2);
+	}
+	catch (std::exception const&)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+
+	// and so do NaN and inf, whatever the extrapolation
+	for (char const* extrap : {"none", "periodic", "end-value"})
+	{
+		spline se(3, d.knots, d.coefs, extrap, "bspline");
+		for (double bad : {NAN, INFINITY, -INFINITY})
+		{
+			std::vector<double> xs(9, d.knots.front());
+			xs[7] = bad;
+			std::vector<double> ys(xs.size());
+			thrown = false;
+			try
+			{
+				se.eval(xs.data(), ys.data(), xs.size());
+			}
+			catch (std::exception const&)
+			{
+				thrown = true;
+			}
+			assert(thrown);
+		}
+	}
+	unused(thrown);
+}
+
+int main()
+{
+	test_power_basis();
+	test_eval_all();
+	test_bundle();
+	test_static_spline();
+	test_batch();
+	return 0;
+}
@@ -0,0 +1,215 @@
+#include <thread>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+#include <cppmisc/traces.h>
+#include <cppmisc/timing.h>
+#include <networking/tcp.h>
+#include "../src/uring_io.h"
+#include "../src/servo_iface.h"
+
+
+int test_port(int n)
+{
+    return 20000 + (getpid() * 4 + n) % 40000;
+}
+
+ConnectionPtr connect_to(int port)
+{
+    // the server may not listen yet
+    for (int attempt = 0; ; ++ attempt)
+    {
+        try
+        {
+            return Connection::connect("127.0.0.1", port);
+        }
+        catch (std::exception const&)
+        {
+            if (attempt == 100)
+                throw;
+            sleep_usec(10000);
+        }
+    }
+}
+
+/*
+ * reads and writes over loopback: more data than the provided buffers
+ * hold, sends longer than a slot, the ring descriptor in poll() and
+ * the end of the stream
+ */
+void test_stream()
+{
+    int port = test_port(0);
+    TCPSrv srv(port);
+    const int total = 1000000;
+    const int nvalues = 2000;
+    std::string received;
+
+    std::thread server([&srv, &received, total, nvalues]() {
+        auto con = srv.wait_for_connection();
+        std::string data(total, 0);
+        for (int i = 0; i < total; ++ i)
+            data[i] = char(i * 13);
+
+        // wait for the client to start
+        char c;
+        assert(con->read(&c, 1, true) == 1);
+        assert(con->write(data));
+
+        while ((int)received.size() < 5000 + nvalues * 8)
+        {
+            char buf[4096];
+            int n = con->read(buf, sizeof(buf), true);
+            assert(n > 0);
+            received.append(buf, n);
+        }
+    });
+
+    auto con = connect_to(port);
+    UringIo io(con->fd());
+
+    char buf[8192];
+    assert(io.read(buf, sizeof(buf), false) == 0);
+    assert(io.wait_for_data(1000) == 0);
+
+    pollfd pfd = {io.fd(), POLLIN, 0};
+    assert(poll(&pfd, 1, 0) == 0);
+    assert(io.write("s", 1));
+    assert(poll(&pfd, 1, 1000) == 1);
+
+    // the client doesn't read while the server sends, the receive runs
+    // out of buffers and is rearmed
+    sleep_usec(50000);
+    int got = 0;
+    while (got < total)
+    {
+        int n = io.read(buf, sizeof(buf), true);
+        assert(n > 0);
+        for (int i = 0; i < n; ++ i)
+            assert(buf[i] == char((got + i) * 13));
+        got += n;
+    }
+
+    std::string big(5000, 0);
+    for (int i = 0; i < (int)big.size(); ++ i)
+        big[i] = char(i * 7);
+    // a burst of writes faster than the sends complete stays in order
+    assert(io.write(big.data(), big.size()));
+    for (int i = 0; i < nvalues; ++ i)
+    {
+        int64_t v = i;
+        assert(io.write(reinterpret_cast<char const*>(&v), sizeof(v)));
+    }
+
+    server.join();
+    assert(received.compare(0, big.size(), big) == 0);
+    for (int i = 0; i < nvalues; ++ i)
+    {
+        int64_t v;
+        memcpy(&v, received.data() + big.size() + i * sizeof(v), sizeof(v));
+        assert(v == i);
+    }
+
+    // the server is gone
+    assert(io.wait_for_data(1000000) == 1);
+    assert(io.read(buf, sizeof(buf), true) < 0);
+    assert(io.syscalls() > 0);
+}
+
+// servo state and torque commands through the uring backend
+void test_servo_uring()
+{
+    int port = test_port(1);
+    TCPSrv srv(port);
+    bool stopped = false;
+
+    std::thread server([&srv, &stopped]() {
+        auto con = srv.wait_for_connection();
+        Servo::CmdPack cmd;
+        assert(con->read(reinterpret_cast<char*>(&cmd), sizeof(cmd), true) == sizeof(cmd));
+        assert(Servo::get_cmd(cmd) == Servo::CmdStart);
+
+        for (int i = 0; i < 3; ++ i)
+        {
+            Servo::InfoPack info;
+            Servo::init_info_pack(i, 0.5 * i, -0.5 * i, info);
+            assert(con->write(reinterpret_cast<char const*>(&info), sizeof(info)));
+            assert(con->read(reinterpret_cast<char*>(&cmd), sizeof(cmd), true) == sizeof(cmd));
+            assert(Servo::get_cmd(cmd) == Servo::CmdTorque && cmd.torque == i);
+        }
+
+        Servo::CmdPack cmds[2];
+        int n = 0;
+        while (n < (int)sizeof(cmds))
+        {
+            int status = con->read(reinterpret_cast<char*>(cmds) + n, sizeof(cmds) - n, true);
+            assert(status > 0);
+            n += status;
+        }
+        assert(Servo::get_cmd(cmds[1]) == Servo::CmdStop);
+        stopped = true;
+    });
+
+    Json::Value cfg;
+    cfg["servo"]["ip"] = "127.0.0.1";
+    cfg["servo"]["port"] = port;
+    cfg["servo"]["io_backend"] = "uring";
+
+    auto servo = ServoIfc::capture_instance();
+    servo->init(cfg);
+    for (int attempt = 0; ; ++ attempt)
+    {
+        try
+        {
+            servo->start();
+            break;
+        }
+        catch (std::exception const&)
+        {
+            assert(attempt < 100);
+            sleep_usec(10000);
+        }
+    }
+
+    for (int i = 0; i < 3; ++ i)
+    {
+        int64_t t;
+        double theta, dtheta;
+        assert(servo->wait_for_data(1000000) == 1);
+        assert(servo->get_state(t, theta, dtheta, true) == 1);
+        assert(t == i && theta == 0.5 * i && dtheta == -0.5 * i);
+        servo->set_torque(i);
+    }
+
+    servo->stop();
+    server.join();
+    assert(stopped);
+    unused(stopped);
+
+    cfg["servo"]["transport"] = "udp";
+    cfg["servo"]["protocol"] = 2;
+    bool failed = false;
+    try
+    {
+        servo->init(cfg);
+    }
+    catch (std::exception const&)
+    {
+        failed = true;
+    }
+    assert(failed);
+    unused(failed);
+}
+
+int main()
+{
+    if (!UringIo::supported())
+    {
+        info_msg("io_uring is not available, skipping");
+        return 0;
+    }
+
+    test_stream();
+    test_servo_uring();
+    return 0;
+}